@@ -28,11 +28,19 @@ extern "C" {
 
 typedef struct _flink_dev    flink_dev;
 typedef struct _flink_subdev flink_subdev;
+typedef struct _flink_txn    flink_txn;
+typedef struct _flink_irq    flink_irq;
+typedef struct _flink_irq_dispatcher flink_irq_dispatcher;
+typedef struct _flink_cyclic flink_cyclic;
+typedef struct _flink_wd_service flink_wd_service;
+typedef struct _flink_sampler flink_sampler;
+typedef struct _flink_snapshot flink_snapshot;
 
 
 // ############ Base operations ############
 
 flink_dev* flink_open(const char* file_name);
+flink_dev* flink_open_mapped(const char* file_name);
 int        flink_close(flink_dev* dev);
 
 
@@ -45,6 +53,126 @@ int     flink_read_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, void*
 int     flink_write_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, void* wdata);
 
 
+// ############ Access statistics ############
+
+typedef struct _flink_stats {
+	uint64_t reads;				/// Register reads, also within transactions
+	uint64_t writes;			/// Register writes, also within transactions
+	uint64_t bit_reads;			/// Bit reads
+	uint64_t bit_writes;		/// Bit writes
+	uint64_t bytes_read;		/// Bytes read
+	uint64_t bytes_written;		/// Bytes written
+	uint64_t errors;			/// Failed calls and operations
+	uint64_t ioctls;			/// Calls of flink_ioctl(), device only
+	uint64_t syscalls;			/// ioctl system calls of the ioctl backend, device only
+	uint64_t transactions;		/// Committed transactions, device only
+	uint64_t time_ns;			/// Time spent in the calls
+	uint64_t max_time_ns;		/// Longest call
+} flink_stats;
+
+int flink_get_stats(flink_dev* dev, flink_subdev* subdev, flink_stats* stats);
+int flink_reset_stats(flink_dev* dev);
+
+
+// ############ Unchecked fast access ############
+
+typedef struct _flink_fast_subdev {
+	volatile uint8_t* regs;		/// Mapped registers, NULL if accessed through the backend
+	flink_subdev*     subdev;	/// Subdevice accessed through the backend
+	ssize_t (*read)(flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata);
+	ssize_t (*write)(flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata);
+} flink_fast_subdev;
+
+int flink_fast_open(flink_subdev* subdev, flink_fast_subdev* fast);
+
+/**
+ * @brief Reads a register without any check. The offset must be valid and aligned.
+ * @return uint32_t: Register value, undefined if the backend access failed.
+ */
+static inline uint32_t flink_fast_read32(const flink_fast_subdev* fast, uint32_t offset) {
+	uint32_t value = 0;
+	if(fast->regs) return *(volatile uint32_t*)(fast->regs + offset);
+	fast->read(fast->subdev, offset, sizeof(value), &value);
+	return value;
+}
+
+/**
+ * @brief Writes a register without any check. The offset must be valid and aligned.
+ */
+static inline void flink_fast_write32(const flink_fast_subdev* fast, uint32_t offset, uint32_t value) {
+	if(fast->regs) {
+		*(volatile uint32_t*)(fast->regs + offset) = value;
+		return;
+	}
+	fast->write(fast->subdev, offset, sizeof(value), &value);
+}
+
+
+// ############ Transactions ############
+
+flink_txn* flink_txn_begin(flink_dev* dev);
+int        flink_txn_add_read(flink_txn* txn, flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata);
+int        flink_txn_add_write(flink_txn* txn, flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata);
+int        flink_txn_commit(flink_txn* txn, ssize_t* results);
+void       flink_txn_free(flink_txn* txn);
+
+
+// ############ Snapshots ############
+
+flink_snapshot* flink_snapshot_create(flink_dev* dev);
+int             flink_snapshot_add_register(flink_snapshot* snap, flink_subdev* subdev, uint32_t offset, uint8_t size, size_t field);
+int             flink_snapshot_add_channel(flink_snapshot* snap, flink_subdev* subdev, uint32_t channel, size_t field);
+int             flink_snapshot_capture(flink_snapshot* snap, void* data, size_t size, uint64_t* timestamp_ns);
+void            flink_snapshot_free(flink_snapshot* snap);
+
+
+// ############ Cyclic executor ############
+
+typedef int (*flink_cycle_handler)(flink_cyclic* cyc, uint64_t cycle, void* arg);
+
+typedef struct _flink_cyclic_stats {
+	uint64_t cycles;			/// Executed cycles
+	uint64_t overruns;			/// Cycles which ended after the release of the next cycle
+	uint64_t skipped;			/// Releases skipped because of overruns
+	uint64_t errors;			/// Cycles with a failed register access
+	uint64_t latency_min_ns;	/// Start of a cycle after its release
+	uint64_t latency_avg_ns;
+	uint64_t latency_max_ns;
+	uint64_t exec_min_ns;		/// Duration of reads, handler and writes
+	uint64_t exec_avg_ns;
+	uint64_t exec_max_ns;
+	uint64_t jitter_max_ns;		/// Largest deviation of the time between two cycle starts from the period
+} flink_cyclic_stats;
+
+flink_cyclic* flink_cyclic_create(flink_dev* dev, uint32_t period_us, flink_cycle_handler handler, void* arg);
+int           flink_cyclic_add_read(flink_cyclic* cyc, flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata);
+int           flink_cyclic_add_write(flink_cyclic* cyc, flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata);
+int           flink_cyclic_set_realtime(flink_cyclic* cyc, int cpu, int priority, uint8_t lock_memory);
+int           flink_cyclic_run(flink_cyclic* cyc, uint64_t nof_cycles);
+int           flink_cyclic_stop(flink_cyclic* cyc);
+int           flink_cyclic_get_stats(flink_cyclic* cyc, flink_cyclic_stats* stats);
+void          flink_cyclic_free(flink_cyclic* cyc);
+
+
+// ############ Sampler ############
+
+typedef struct _flink_sampler_stats {
+	uint64_t frames;			/// Frames published to the ring
+	uint64_t dropped;			/// Frames dropped because the ring was full
+	uint64_t overruns;			/// Periods missed because sampling took too long
+	uint64_t errors;			/// Frames with a failed register access, not published
+} flink_sampler_stats;
+
+flink_sampler* flink_sampler_create(flink_dev* dev, uint32_t period_us, uint32_t capacity);
+int            flink_sampler_add_channel(flink_sampler* smp, flink_subdev* subdev, uint32_t channel);
+int            flink_sampler_add_register(flink_sampler* smp, flink_subdev* subdev, uint32_t offset);
+int            flink_sampler_start(flink_sampler* smp, int cpu, int priority);
+ssize_t        flink_sampler_read(flink_sampler* smp, uint64_t* timestamps, uint32_t* values, size_t max_frames);
+int            flink_sampler_get_stats(flink_sampler* smp, flink_sampler_stats* stats);
+int            flink_sampler_stop(flink_sampler* smp);
+void           flink_sampler_free(flink_sampler* smp);
+
+
 // ############ Subdevice operations ############
 
 #define REGISTER_WITH						4	// byte
@@ -84,6 +212,9 @@ uint32_t      flink_subdevice_get_nofchannels(flink_subdev* subdev);
 uint32_t      flink_subdevice_get_unique_id(flink_subdev* subdev);
 int           flink_subdevice_select(flink_subdev* subdev, uint8_t exclusive);
 int           flink_subdevice_reset(flink_subdev* subdev);
+int           flink_subdevice_set_cached(flink_subdev* subdev, uint8_t enable);
+int           flink_subdevice_refresh(flink_subdev* subdev);
+int           flink_flush(flink_dev* dev);
 const char*   flink_subdevice_id2str(uint8_t subdev_id);
 
 // Info
@@ -92,6 +223,7 @@ int flink_info_get_description(flink_subdev* subdev, char* value);
 // Analog input
 int flink_analog_in_get_resolution(flink_subdev* subdev, uint32_t* resolution);
 int flink_analog_in_get_value(flink_subdev* subdev, uint32_t channel, uint32_t* value);
+int flink_analog_in_get_values(flink_subdev* subdev, uint32_t first, uint32_t count, uint32_t* values);
 
 // Analog output
 int flink_analog_out_get_resolution(flink_subdev* subdev, uint32_t* resolution);
@@ -106,6 +238,9 @@ int flink_dio_set_value(flink_subdev* subdev, uint32_t channel, uint8_t high);
 int flink_dio_get_value(flink_subdev* subdev, uint32_t channel, uint8_t* value);
 int flink_dio_set_debounce(flink_subdev* subdev, uint32_t channel, uint32_t debounce);
 int flink_dio_get_debounce(flink_subdev* subdev, uint32_t channel, uint32_t* debounce);
+int flink_dio_get_port(flink_subdev* subdev, uint32_t port, uint32_t count, uint32_t* values);
+int flink_dio_set_port_masked(flink_subdev* subdev, uint32_t port, uint32_t count, const uint32_t* values, const uint32_t* masks);
+int flink_dio_set_direction_mask(flink_subdev* subdev, uint32_t port, uint32_t count, const uint32_t* outputs, const uint32_t* masks);
 
 // Counter
 int flink_counter_set_mode(flink_subdev* subdev, uint8_t mode);
@@ -129,6 +264,21 @@ int flink_wd_get_status(flink_subdev* subdev, uint8_t* status);
 int flink_wd_set_counter(flink_subdev* subdev, uint32_t value);
 int flink_wd_arm(flink_subdev* subdev);
 
+typedef struct _flink_wd_stats {
+	uint64_t kicks;					/// Retriggers of the watchdog
+	uint64_t missed_heartbeats;		/// Kicks left out because the heartbeat was too old
+	uint64_t timer_overruns;		/// Kick periods the thread woke up too late for
+	uint64_t errors;				/// Failed register accesses
+	uint64_t slack_min_ns;			/// Smallest time left until expiry at a kick
+	uint64_t kick_interval_max_ns;	/// Largest time between two kicks
+	uint8_t  expired;				/// Watchdog status at the last kick period
+} flink_wd_stats;
+
+flink_wd_service* flink_wd_service_start(flink_subdev* subdev, uint32_t timeout_ms, uint32_t heartbeat_ms, int cpu, int priority);
+int flink_wd_service_heartbeat(flink_wd_service* wds);
+int flink_wd_service_get_stats(flink_wd_service* wds, flink_wd_stats* stats);
+int flink_wd_service_stop(flink_wd_service* wds);
+
 // Stepper Motor
 int flink_stepperMotor_get_baseclock(flink_subdev* subdev, uint32_t* frequency);
 int flink_stepperMotor_set_local_config_reg(flink_subdev* subdev, uint32_t channel, uint32_t config);
@@ -161,6 +311,96 @@ int flink_get_signal_offset(flink_dev *dev, uint32_t *offset);
 int flink_set_irq_multiplex(flink_subdev *subdev, uint32_t irq, uint32_t flink_irq);
 int flink_get_irq_multiplex(flink_subdev *subdev, uint32_t irq, uint32_t *flink_irq);
 
+// Interrupt file descriptors
+flink_irq* flink_irq_open(flink_dev* dev, const uint32_t* irqs, uint8_t nof_irqs);
+int        flink_irq_get_fd(flink_irq* irq);
+int        flink_irq_read(flink_irq* irq, uint32_t* counts);
+int        flink_irq_wait(flink_irq* irq, int timeout_ms, uint32_t* counts);
+int        flink_irq_close(flink_irq* irq);
+
+// Interrupt dispatcher
+#define FLINK_IRQ_HIST_BINS	32	// bin i counts latencies from 2^i to 2^(i+1) ns, bin 0 from 0 ns
+
+typedef void (*flink_irq_handler)(flink_dev* dev, uint32_t irq, uint32_t count, void* arg);
+
+typedef struct _flink_irq_batch {
+	uint32_t irq;				/// IRQ number
+	uint32_t count;				/// Interrupts in the batch
+	uint64_t first_ns;			/// Reception of the first interrupt, CLOCK_MONOTONIC
+	uint64_t last_ns;			/// Reception of the last interrupt, CLOCK_MONOTONIC
+} flink_irq_batch;
+
+typedef void (*flink_irq_batch_handler)(flink_dev* dev, const flink_irq_batch* batch, void* arg);
+
+typedef struct _flink_irq_stats {
+	uint64_t count;				/// Interrupts received
+	uint64_t calls;				/// Handler calls
+	uint64_t coalesced;			/// Interrupts passed to the handler together with an earlier one
+	uint64_t latency_min_ns;	/// Time from reception to handler start
+	uint64_t latency_avg_ns;
+	uint64_t latency_max_ns;
+	uint64_t latency_p50_ns;	/// Percentiles, upper bound of the histogram bin
+	uint64_t latency_p99_ns;
+	uint64_t duration_min_ns;	/// Run time of the handler
+	uint64_t duration_avg_ns;
+	uint64_t duration_max_ns;
+	uint64_t histogram[FLINK_IRQ_HIST_BINS];	/// Latencies of the handler calls
+} flink_irq_stats;
+
+flink_irq_dispatcher* flink_irq_dispatcher_start(flink_dev* dev, int cpu, int priority);
+int flink_irq_dispatcher_add(flink_irq_dispatcher* disp, uint32_t irq, flink_irq_handler handler, void* arg);
+int flink_irq_dispatcher_add_coalesced(flink_irq_dispatcher* disp, uint32_t irq, uint32_t max_events, uint32_t max_delay_us,
+                                       flink_irq_batch_handler handler, void* arg);
+int flink_irq_dispatcher_remove(flink_irq_dispatcher* disp, uint32_t irq);
+int flink_irq_dispatcher_stop(flink_irq_dispatcher* disp);
+int flink_irq_dispatcher_get_stats(flink_irq_dispatcher* disp, uint32_t irq, flink_irq_stats* stats);
+int flink_irq_dispatcher_reset_stats(flink_irq_dispatcher* disp, uint32_t irq);
+
+
+// ############ Simulator ############
+
+int flink_sim_set_latency(flink_dev* dev, uint32_t latency_ns);
+int flink_sim_poke(flink_subdev* subdev, uint32_t offset, uint32_t value);
+int flink_sim_peek(flink_subdev* subdev, uint32_t offset, uint32_t* value);
+int flink_sim_trigger_irq(flink_dev* dev, uint32_t irq);
+
+// ############ Record and replay ############
+
+typedef struct _flink_replay_stats {
+	uint64_t records;			/// Accesses in the trace
+	uint64_t matched;			/// Accesses served by their record
+	uint64_t skipped;			/// Records passed over to find the next match
+	uint64_t repeated;			/// Reads served by an earlier record
+	uint64_t missing;			/// Accesses not in the trace
+	uint64_t mismatched;		/// Writes of other data than recorded
+} flink_replay_stats;
+
+int flink_record_flush(flink_dev* dev);
+int flink_replay_get_stats(flink_dev* dev, flink_replay_stats* stats);
+
+// ############ Logging ############
+
+#define FLINK_LOG_OFF           0	// nothing is logged
+#define FLINK_LOG_ERROR         1	// failed calls, default
+#define FLINK_LOG_DEBUG         2	// failed calls and debug messages
+#define FLINK_LOG_MESSAGE_SIZE  96	// byte, longer messages are truncated
+
+typedef struct _flink_log_entry {
+	uint64_t timestamp_ns;		/// CLOCK_MONOTONIC time of the message
+	int      level;				/// FLINK_LOG_ERROR or FLINK_LOG_DEBUG
+	int      error;				/// Error code of a failed call, 0 for debug messages
+	char     message[FLINK_LOG_MESSAGE_SIZE];	/// Message, without newline
+} flink_log_entry;
+
+typedef void (*flink_log_handler)(const flink_log_entry* entry, void* arg);
+
+int      flink_log_set_level(int level);
+int      flink_log_get_level(void);
+void     flink_log_set_handler(flink_log_handler handler, void* arg);
+int      flink_log_set_ring(uint32_t capacity);
+int      flink_log_read(flink_log_entry* entries, uint32_t max_entries);
+uint64_t flink_log_get_dropped(void);
+
 // ############ Exit states ############
 #define EXIT_SUCCESS	0
 #define EXIT_ERROR		-1
@@ -25,6 +25,8 @@
 #include "types.h"
 #include "error.h"
 #include "log.h"
+#include "cache.h"
+#include "layout.h"
 
 #include <stdint.h>
 
@@ -36,9 +38,9 @@
  */
 int flink_analog_in_get_resolution(flink_subdev* subdev, uint32_t* resolution){
 	uint32_t offset;
-	offset = HEADER_SIZE + SUBHEADER_SIZE;
+	offset = subdev->layout[LAYOUT_CONSTANT];
 	
-	if(flink_read(subdev, offset, REGISTER_WITH, resolution) != REGISTER_WITH) {
+	if(flink_cache_read_constant(subdev, offset, resolution) < 0) {
 		libc_error();
 		return EXIT_ERROR;
 	}
@@ -56,7 +58,7 @@ int flink_analog_in_get_value(flink_subdev* subdev, uint32_t channel, uint32_t*
 	uint32_t offset;
 	
 	dbg_print("Get Value of analog in for channel %d on subdevice %d\n", subdev->id, channel);
-	offset = HEADER_SIZE + SUBHEADER_SIZE + ANALOG_INPUT_FIRST_VALUE_OFFSET + channel*REGISTER_WITH;
+	offset = layout_reg(subdev, LAYOUT_VALUE, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 
 	if(flink_read(subdev, offset, REGISTER_WITH, value) != REGISTER_WITH) {
@@ -65,3 +67,44 @@ int flink_analog_in_get_value(flink_subdev* subdev, uint32_t channel, uint32_t*
 	}
 	return EXIT_SUCCESS;
 }
+
+/**
+ * @brief Reads a range of analog input channels
+ *
+ * The channel values are contiguous, so the range is read with as few
+ * accesses as the maximum transfer size of 255 bytes allows.
+ *
+ * @param subdev: Subdevice containing the channels.
+ * @param first: Number of the first channel to read.
+ * @param count: Number of channels to read.
+ * @param values: Array of at least count elements, contains the digitized values.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_analog_in_get_values(flink_subdev* subdev, uint32_t first, uint32_t count, uint32_t* values){
+	const uint32_t max_chunk = UINT8_MAX / REGISTER_WITH; // channels per access
+	uint32_t offset, chunk;
+	
+	if(subdev == NULL || values == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(first > subdev->nof_channels || count > subdev->nof_channels - first) {
+		flink_error(FLINK_EINVALCHAN);
+		return EXIT_ERROR;
+	}
+	
+	dbg_print("Get Values of analog in for channels %d to %d on subdevice %d\n", first, first + count - 1, subdev->id);
+	offset = layout_reg(subdev, LAYOUT_VALUE, first);
+	
+	while(count > 0) {
+		chunk = count < max_chunk ? count : max_chunk;
+		if(flink_read(subdev, offset, chunk * REGISTER_WITH, values) != chunk * REGISTER_WITH) {
+			libc_error();
+			return EXIT_ERROR;
+		}
+		offset += chunk * REGISTER_WITH;
+		values += chunk;
+		count -= chunk;
+	}
+	return EXIT_SUCCESS;
+}
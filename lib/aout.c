@@ -25,6 +25,8 @@
 #include "types.h"
 #include "error.h"
 #include "log.h"
+#include "cache.h"
+#include "layout.h"
 
 #include <stdint.h>
 
@@ -36,9 +38,9 @@
  */
 int flink_analog_out_get_resolution(flink_subdev* subdev, uint32_t* resolution){
 	uint32_t offset;
-	offset = HEADER_SIZE + SUBHEADER_SIZE;
+	offset = subdev->layout[LAYOUT_CONSTANT];
 	
-	if(flink_read(subdev, offset, REGISTER_WITH, resolution) != REGISTER_WITH) {
+	if(flink_cache_read_constant(subdev, offset, resolution) < 0) {
 		libc_error();
 		return EXIT_ERROR;
 	}
@@ -56,7 +58,7 @@ int flink_analog_out_set_value(flink_subdev* subdev, uint32_t channel, int32_t v
 	uint32_t offset;
 
 	dbg_print("Get Value of analog out for channel %d on subdevice %d\n", subdev->id, channel);
-	offset = HEADER_SIZE + SUBHEADER_SIZE + ANALOG_OUTPUT_FIRST_VALUE_OFFSET + channel*REGISTER_WITH;
+	offset = layout_reg(subdev, LAYOUT_VALUE, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 
 	if(flink_write(subdev, offset, REGISTER_WITH, &value) != REGISTER_WITH) {
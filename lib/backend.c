@@ -0,0 +1,126 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, transport backends                    *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file backend.c
+ *  @brief Selection of transport backends.
+ *
+ *  Contains the table of all backends and the emulation of the driver
+ *  ioctl commands for backends which do not talk to the driver.
+ */
+
+#include "flinklib.h"
+#include "flinkioctl.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "backend.h"
+
+#include <string.h>
+
+static const flink_backend* const backends[] = {
+	&flink_ioctl_backend,
+	&flink_mmap_backend,
+	&flink_sim_backend,
+	&flink_record_backend,
+	&flink_replay_backend,
+};
+#define NOF_BACKENDS (sizeof(backends) / sizeof(backends[0]))
+
+
+/**
+ * @brief Finds the backend for a device name.
+ * @param uri: Device name, optionally prefixed with a scheme, e.g. "mmap:/dev/flink0".
+ * @param path: Contains the part of the name following the scheme.
+ * @return flink_backend*: The selected backend, the ioctl backend for names without scheme.
+ */
+const flink_backend* flink_find_backend(const char* uri, const char** path) {
+	const char* sep = strchr(uri, ':');
+	size_t len;
+	unsigned int i;
+
+	*path = uri;
+	if(sep == NULL) return &flink_ioctl_backend;
+
+	len = sep - uri;
+	for(i = 0; i < NOF_BACKENDS; i++) {
+		if(strlen(backends[i]->scheme) == len && strncmp(backends[i]->scheme, uri, len) == 0) {
+			*path = sep + 1;
+			return backends[i];
+		}
+	}
+	return &flink_ioctl_backend; // no known scheme, e.g. a file name containing ':'
+}
+
+
+/**
+ * @brief Executes a driver ioctl command with the register operations of a backend.
+ *
+ * Used by backends without driver, so flink_ioctl() behaves the same for all backends.
+ *
+ * @param dev: Flink device handle.
+ * @param cmd: IOCTL command.
+ * @param arg: IOCTL arguments.
+ * @return int: Return value of the command or -1 in case of failure.
+ */
+int flink_emulate_ioctl(flink_dev* dev, int cmd, void* arg) {
+	ioctl_container_t* container = arg;
+	ioctl_bit_container_t* bit_container = arg;
+	flink_subdev* info = arg;
+	uint8_t id;
+
+	switch(cmd) {
+		case SELECT_SUBDEVICE:
+		case SELECT_SUBDEVICE_EXCL:
+			id = *((uint8_t*)arg);
+			break;
+		case SELECT_AND_READ:
+		case SELECT_AND_WRITE:
+			id = container->subdevice;
+			break;
+		case SELECT_AND_READ_BIT:
+		case SELECT_AND_WRITE_BIT:
+			id = bit_container->subdevice;
+			break;
+		case READ_SUBDEVICE_INFO:
+			id = info->id;
+			break;
+		case READ_NOF_SUBDEVICES:
+			*((uint8_t*)arg) = dev->nof_subdevices;
+			return EXIT_SUCCESS;
+		default:
+			flink_error(FLINK_UNKNOWNIOCTL);
+			return EXIT_ERROR;
+	}
+
+	if(id >= dev->nof_subdevices) {
+		flink_error(FLINK_EINVALSUBDEV);
+		return EXIT_ERROR;
+	}
+
+	switch(cmd) {
+		case SELECT_AND_READ:
+			return dev->backend->read(dev->subdevices + id, container->offset, container->size, container->data);
+		case SELECT_AND_WRITE:
+			return dev->backend->write(dev->subdevices + id, container->offset, container->size, container->data);
+		case SELECT_AND_READ_BIT:
+			return dev->backend->read_bit(dev->subdevices + id, bit_container->offset, bit_container->bit, &bit_container->value);
+		case SELECT_AND_WRITE_BIT:
+			return dev->backend->write_bit(dev->subdevices + id, bit_container->offset, bit_container->bit, bit_container->value);
+		case READ_SUBDEVICE_INFO:
+			memcpy(info, dev->subdevices + id, offsetof(flink_subdev, parent));
+			return EXIT_SUCCESS;
+		default: // nothing to select without driver
+			return EXIT_SUCCESS;
+	}
+}
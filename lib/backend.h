@@ -0,0 +1,60 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, transport backends                    *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file backend.h
+ *  @brief Transport backends.
+ *
+ *  A backend implements the access to the registers of a flink device.
+ *  It is selected by the URI scheme of the name passed to flink_open(),
+ *  e.g. "ioctl:/dev/flink0", "mmap:/dev/flink0", "sim:" or "replay:run.trace". A name without a
+ *  scheme is opened with the ioctl backend.
+ *
+ *  open() must not keep the address of the device: the device is moved
+ *  into one block with its subdevice array once count() is known.
+ */
+
+#ifndef FLINKLIB_BACKEND_H_
+#define FLINKLIB_BACKEND_H_
+
+#include "types.h"
+
+#include <sys/types.h>
+
+struct _flink_backend {
+	const char* scheme;		/// URI scheme selecting this backend
+	int     (*open)(flink_dev* dev, const char* path);
+	int     (*close)(flink_dev* dev);
+	int     (*count)(flink_dev* dev);		/// Nof subdevices of an opened device
+	int     (*enumerate)(flink_dev* dev);	/// Fills the subdevice array allocated for count() entries
+	int     (*ioctl)(flink_dev* dev, int cmd, void* arg);
+	ssize_t (*read)(flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata);
+	ssize_t (*write)(flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata);
+	int     (*read_bit)(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t* value);
+	int     (*write_bit)(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t value);
+	int     (*transfer)(flink_dev* dev, flink_op* ops, size_t nof_ops, ssize_t* results);	/// Optional, executes a transaction at once
+};
+
+extern const flink_backend flink_ioctl_backend;
+extern const flink_backend flink_mmap_backend;
+extern const flink_backend flink_sim_backend;
+extern const flink_backend flink_record_backend;
+extern const flink_backend flink_replay_backend;
+
+const flink_backend* flink_find_backend(const char* uri, const char** path);
+int flink_emulate_ioctl(flink_dev* dev, int cmd, void* arg);
+int flink_ioctl_count(flink_dev* dev);
+int flink_ioctl_enumerate(flink_dev* dev);
+int flink_txn_transfer(flink_txn* txn, ssize_t* results);
+
+#endif // FLINKLIB_BACKEND_H_
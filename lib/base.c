@@ -28,10 +28,11 @@
 #include "valid.h"
 #include "error.h"
 #include "log.h"
+#include "backend.h"
+#include "cache.h"
+#include "layout.h"
 
 #include <stdlib.h>
-#include <fcntl.h>
-#include <unistd.h>
 
 
 /*******************************************************************
@@ -41,61 +42,54 @@
  *******************************************************************/
 
 /**
- * @brief Read number of subdevices from flink device.
- * 
- * @param dev: Device to read
- * @return int: Number of flink devices or -1 in case of error.
+ * @brief Opens a flink device with a backend and reads its subdevices.
+ *
+ * The device and its subdevices are allocated as one block.
+ *
+ * @param backend: Backend used to access the device.
+ * @param path: Device file or backend specific name (null terminated array).
+ * @return flink_dev*: Pointer to the opened flink device or NULL in case of error.
  */
-static int read_nof_subdevices(flink_dev* dev) {
-	uint8_t n = 0;
-	
-	dbg_print("reading number of subdevices...\n");
+static flink_dev* open_device(const flink_backend* backend, const char* path) {
+	flink_dev probe = { .backend = backend, .fd = -1 };
+	flink_dev* dev = NULL;
+	int i, n;
 	
-	if(flink_ioctl(dev, READ_NOF_SUBDEVICES, &n) < 0) {
-		dbg_print("   --> failed!\n");
-		libc_error();
-		return EXIT_ERROR;
+	// Open device
+	if(probe.backend->open(&probe, path) < 0) { // failed to open device
+		return NULL;
 	}
-	dbg_print("  --> %u\n", n);
-	return n;
-}
-
-/**
- * @brief Read header of all subdevices and update flink device.
- * 
- * @param dev: flink device to update
- * @return int: number of subdevices read, or -1 in case of error.
- */
-static int get_subdevices(flink_dev* dev) {
-	flink_subdev* subdev = NULL;
-	int i = 0, ret = 0;
 	
-	if(!validate_flink_dev(dev)) {
-		flink_error(FLINK_EINVALDEV);
-		return EXIT_ERROR;
+	n = probe.backend->count(&probe);
+	if(n < 0) { // reading nof subdevices failed
+		probe.backend->close(&probe);
+		return NULL;
 	}
 	
-	// Read nof subdevices
-	dev->nof_subdevices = read_nof_subdevices(dev);
-	
-	// Allocate memory
-	dev->subdevices = calloc(dev->nof_subdevices, sizeof(flink_subdev));
-	if(dev->subdevices == NULL) { // allocation failed
+	// Allocate memory for the device followed by its subdevices
+	dev = calloc(1, sizeof(flink_dev) + n * sizeof(flink_subdev));
+	if(dev == NULL) { // allocation failed
 		libc_error();
-		dev->nof_subdevices = 0;
-		return EXIT_ERROR;
+		probe.backend->close(&probe);
+		return NULL;
+	}
+	*dev = probe;
+	dev->nof_subdevices = n;
+	dev->subdevices = (flink_subdev*)(dev + 1);
+	
+	if(dev->backend->enumerate(dev) < 0) { // reading subdevices failed
+		dev->backend->close(dev);
+		free(dev);
+		return NULL;
 	}
 	
-	// Fillup all information
-	for(i = 0; i < dev->nof_subdevices; i++) { // for each subdevice
-		subdev = dev->subdevices + i;
-		subdev->id = i;
-		ret = flink_ioctl(dev, READ_SUBDEVICE_INFO, subdev);
-		if (ret < 0) return ret;
-		subdev->parent = dev;
+	pthread_mutex_init(&dev->flush_lock, NULL);
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		flink_layout_init(dev->subdevices + i);
+		pthread_mutex_init(&dev->subdevices[i].lock, NULL);
 	}
 	
-	return i;
+	return dev;
 }
 
 
@@ -107,54 +101,73 @@ static int get_subdevices(flink_dev* dev) {
 
 /**
  * @brief Opens a flink device file
+ * 
+ * The name may start with a scheme selecting the backend used to access
+ * the device: "ioctl:/dev/flink0" (default) or "mmap:/dev/flink0".
+ * 
  * @param file_name: Device file (null terminated array).
  * @return flink_dev*: Pointer to the opened flink device or NULL in case of error.
  */
 flink_dev* flink_open(const char* file_name) {
-	flink_dev* dev = NULL;
+	const flink_backend* backend;
+	const char* path;
 	
-	// Allocate memory for flink_t
-	dev = malloc(sizeof(flink_dev));
-	if(dev == NULL) { // allocation failed
-		libc_error();
-		return NULL;
-	}
-	
-	// Open device file
-	dev->fd = open(file_name, O_RDWR);
-	if(dev->fd < 0) { // failed to open device
-		free(dev);
-		libc_error();
+	if(file_name == NULL) {
+		flink_error(FLINK_ENULLPTR);
 		return NULL;
 	}
 	
-	if(get_subdevices(dev) < 0) { // reading subdevices failed
-		close(dev->fd);
-		free(dev);
+	backend = flink_find_backend(file_name, &path);
+	dbg_print("opening '%s' with backend '%s'\n", path, backend->scheme);
+	return open_device(backend, path);
+}
+
+
+/**
+ * @brief Opens a flink device file with memory mapped register access.
+ * 
+ * The registers of all subdevices are mapped into the process and read
+ * and written without a system call. If the driver refuses the mapping,
+ * the device is used through ioctl like with flink_open(). A regular file
+ * is used as an image of the device memory.
+ * 
+ * @param file_name: Device file or image file (null terminated array).
+ * @return flink_dev*: Pointer to the opened flink device or NULL in case of error.
+ */
+flink_dev* flink_open_mapped(const char* file_name) {
+	if(file_name == NULL) {
+		flink_error(FLINK_ENULLPTR);
 		return NULL;
 	}
 	
-	return dev;
+	return open_device(&flink_mmap_backend, file_name);
 }
 
 
 /**
  * @brief Close an open flink device
+ * 
+ * No other thread may access the device or its subdevices anymore.
+ * 
  * @param dev: device to close.
  * @return int: 0 on success, -1 in case of failure.
  */
 int flink_close(flink_dev* dev) {
+	int i;
+	
 	if(!validate_flink_dev(dev)) {
 		flink_error(FLINK_EINVALDEV);
 		return EXIT_ERROR;
 	}
 	
-	if(dev->subdevices) {
-		free(dev->subdevices);
+	flink_cache_free(dev); // writes pending cached registers
+	dev->backend->close(dev);
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		pthread_mutex_destroy(&dev->subdevices[i].lock);
 	}
+	pthread_mutex_destroy(&dev->flush_lock);
 	
-	close(dev->fd);
-	free(dev);
+	free(dev); // subdevices are part of the same block
 	return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,578 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, register caches                       *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file cache.c
+ *  @brief Register caches: constants and shadow registers of output subdevices.
+ *
+ *  The base clock or resolution of a subdevice is read on first use and
+ *  served from memory afterwards, until flink_subdevice_refresh().
+ *
+ *  A cached subdevice keeps a copy of its writable function registers.
+ *  Writes to these registers only update the copy and mark the register
+ *  dirty if its value changed. flink_flush() writes all dirty registers
+ *  of a device with one transaction, combining neighbouring registers
+ *  into one transfer.
+ *
+ *  Cached are the periods and high times of PWM, the values of analog
+ *  outputs, the values of digital I/O and the channel registers of
+ *  stepper motors. The steps to do of a stepper motor start a move when
+ *  written, so they are written even if unchanged. All other registers
+ *  are written immediately, after the pending writes of the subdevice
+ *  were flushed to keep their order. So are the writes of a transaction,
+ *  the cache takes their values. Reads always access the device.
+ *
+ *  The cache of a subdevice is protected by the lock of the subdevice.
+ *  flink_flush() locks the cached subdevices in the order of their ids
+ *  while it commits, so threads writing different subdevices only meet
+ *  there.
+ */
+
+#include "flinklib.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "valid.h"
+#include "backend.h"
+#include "cache.h"
+#include "layout.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FUNC_OFFSET		(HEADER_SIZE + SUBHEADER_SIZE)
+#define MAX_RUN			(UINT8_MAX / REGISTER_WITH)	// registers per transfer
+#define STEPPER_SET		1	// register group of atomic set
+#define STEPPER_RESET	2	// register group of atomic reset
+#define STEPPER_TODO	6	// register group of steps to do
+#define STEPPER_DONE	7	// register group of steps done
+
+typedef enum {
+	REG_UNCACHED,		/// Written immediately
+	REG_CACHED,			/// Written on flush if changed
+	REG_FORCED,			/// Written on flush even if unchanged
+	REG_ATOMIC_SET,		/// Written immediately, sets bits of the local configuration
+	REG_ATOMIC_RESET	/// Written immediately, clears bits of the local configuration
+} reg_kind;
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Size of the register range covered by the cache.
+ * @return uint32_t: Size in bytes from the subdevice base address, 0 if the function is not cached.
+ */
+static uint32_t cache_extent(flink_subdev* subdev) {
+	if(subdev->nof_channels == 0) return 0;
+	switch(subdev->function_id) {
+		case PWM_INTERFACE_ID:           return layout_reg(subdev, LAYOUT_HIGHTIME, subdev->nof_channels);
+		case ANALOG_OUTPUT_INTERFACE_ID: return layout_reg(subdev, LAYOUT_VALUE, subdev->nof_channels);
+		case GPIO_INTERFACE_ID:          return layout_reg(subdev, LAYOUT_DIO_VALUE, layout_bit_words(subdev));
+		case STEPPER_MOTOR_INTERFACE_ID: return layout_reg(subdev, LAYOUT_STEPPER + STEPPER_DONE, subdev->nof_channels);
+		default:                         return 0;
+	}
+}
+
+/**
+ * @brief Classifies a register of a cached subdevice.
+ */
+static reg_kind kind_of(flink_subdev* subdev, uint32_t offset) {
+	uint32_t group;
+
+	if(offset < FUNC_OFFSET || offset % REGISTER_WITH || offset >= subdev->shadow_size) return REG_UNCACHED;
+	if(offset == subdev->layout[LAYOUT_CONSTANT]) return REG_UNCACHED; // base clock or resolution
+
+	switch(subdev->function_id) {
+		case GPIO_INTERFACE_ID:
+			return offset >= subdev->layout[LAYOUT_DIO_VALUE] ? REG_CACHED : REG_UNCACHED; // values, not directions
+		case STEPPER_MOTOR_INTERFACE_ID:
+			group = (offset - subdev->layout[LAYOUT_STEPPER]) / (subdev->nof_channels * REGISTER_WITH);
+			if(group == STEPPER_SET)   return REG_ATOMIC_SET;
+			if(group == STEPPER_RESET) return REG_ATOMIC_RESET;
+			if(group == STEPPER_TODO)  return REG_FORCED;
+			if(group == STEPPER_DONE)  return REG_UNCACHED;
+			return REG_CACHED;
+		default:
+			return REG_CACHED;
+	}
+}
+
+static inline int is_dirty(flink_subdev* subdev, uint32_t word) {
+	return (subdev->dirty[word / 32] >> (word % 32)) & 0x1;
+}
+
+static inline void set_dirty(flink_subdev* subdev, uint32_t word) {
+	subdev->dirty[word / 32] |= 1u << (word % 32);
+}
+
+static inline void clear_dirty(flink_subdev* subdev, uint32_t word) {
+	subdev->dirty[word / 32] &= ~(1u << (word % 32));
+}
+
+/**
+ * @brief Stores a value in the cache and marks it dirty if it has to be written.
+ */
+static void store(flink_subdev* subdev, uint32_t offset, uint32_t value, reg_kind kind) {
+	uint32_t word = offset / REGISTER_WITH;
+
+	if(kind == REG_FORCED || subdev->shadow[word] != value) {
+		subdev->shadow[word] = value;
+		set_dirty(subdev, word);
+	}
+}
+
+/**
+ * @brief Reads the cached registers from the device.
+ */
+static int load(flink_subdev* subdev) {
+	const flink_backend* backend = subdev->parent->backend;
+	uint32_t offset, chunk;
+
+	for(offset = FUNC_OFFSET; offset < subdev->shadow_size; offset += chunk) {
+		chunk = subdev->shadow_size - offset;
+		if(chunk > MAX_RUN * REGISTER_WITH) chunk = MAX_RUN * REGISTER_WITH;
+		if(backend->read(subdev, offset, chunk, (uint8_t*)subdev->shadow + offset) != (ssize_t)chunk) return EXIT_ERROR;
+	}
+	memset(subdev->dirty, 0, ((subdev->shadow_size / REGISTER_WITH + 31) / 32) * sizeof(uint32_t));
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Adds the dirty registers of a subdevice to a transaction, one write per run of registers.
+ */
+static int add_dirty(flink_txn* txn, flink_subdev* subdev) {
+	uint32_t i = 0, start, n = subdev->shadow_size / REGISTER_WITH;
+
+	while(i < n) {
+		if(subdev->dirty[i / 32] == 0) { // skip clean blocks
+			i = (i / 32 + 1) * 32;
+			continue;
+		}
+		if(!is_dirty(subdev, i)) {
+			i++;
+			continue;
+		}
+		start = i;
+		while(i < n && is_dirty(subdev, i) && i - start < MAX_RUN) i++;
+		if(flink_txn_add_write(txn, subdev, start * REGISTER_WITH, (i - start) * REGISTER_WITH, subdev->shadow + start) < 0) {
+			return EXIT_ERROR;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Commits the dirty registers collected in a transaction.
+ * @return int: 0 on success, -1 in case of failure. Registers which failed stay dirty.
+ */
+static int commit_dirty(flink_txn* txn) {
+	flink_op* op;
+	uint32_t w;
+	size_t i;
+	int ret;
+
+	if(txn->nof_ops == 0) return EXIT_SUCCESS;
+
+	dbg_print("flushing %zu register runs\n", txn->nof_ops);
+	ret = flink_txn_transfer(txn, txn->results);
+	for(i = 0; i < txn->nof_ops; i++) {
+		op = txn->ops + i;
+		if(txn->results[i] < 0) continue;
+		for(w = op->offset / REGISTER_WITH; w < (op->offset + op->size) / REGISTER_WITH; w++) {
+			clear_dirty(op->subdev, w);
+		}
+	}
+	return ret;
+}
+
+/**
+ * @brief Writes the dirty registers of a subdevice, the subdevice must be locked.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+static int flush_subdev(flink_subdev* subdev) {
+	if(subdev->shadow == NULL) return EXIT_SUCCESS;
+	if(subdev->flush_txn == NULL) {
+		subdev->flush_txn = flink_txn_begin(subdev->parent);
+		if(subdev->flush_txn == NULL) return EXIT_ERROR;
+	}
+	subdev->flush_txn->nof_ops = 0;
+	if(add_dirty(subdev->flush_txn, subdev) < 0) return EXIT_ERROR;
+	return commit_dirty(subdev->flush_txn);
+}
+
+/**
+ * @brief Writes the dirty registers of all cached subdevices of a device with one transaction.
+ *
+ * The cached subdevices are locked in the order of their ids until the
+ * transaction is committed, so the flush sees a consistent cache.
+ *
+ * @param dev: Device to flush.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+static int flush_dev(flink_dev* dev) {
+	uint32_t locked[(UINT8_MAX + 1) / 32] = { 0 };
+	flink_subdev* subdev;
+	int i, ret = EXIT_SUCCESS;
+
+	pthread_mutex_lock(&dev->flush_lock);
+	if(dev->flush_txn == NULL) {
+		dev->flush_txn = flink_txn_begin(dev);
+		if(dev->flush_txn == NULL) {
+			pthread_mutex_unlock(&dev->flush_lock);
+			return EXIT_ERROR;
+		}
+	}
+	dev->flush_txn->nof_ops = 0;
+
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		subdev = dev->subdevices + i;
+		if(__atomic_load_n(&subdev->shadow, __ATOMIC_ACQUIRE) == NULL) continue;
+		pthread_mutex_lock(&subdev->lock);
+		locked[i / 32] |= 1u << (i % 32);
+		if(add_dirty(dev->flush_txn, subdev) < 0) {
+			ret = EXIT_ERROR;
+			break;
+		}
+	}
+	if(ret == EXIT_SUCCESS) ret = commit_dirty(dev->flush_txn);
+
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		if(locked[i / 32] & (1u << (i % 32))) pthread_mutex_unlock(&dev->subdevices[i].lock);
+	}
+	pthread_mutex_unlock(&dev->flush_lock);
+	return ret;
+}
+
+static void free_shadow(flink_subdev* subdev) {
+	uint32_t* shadow = subdev->shadow;
+
+	__atomic_store_n(&subdev->shadow, NULL, __ATOMIC_RELEASE);
+	free(shadow);
+	free(subdev->dirty);
+	flink_txn_free(subdev->flush_txn);
+	subdev->dirty = NULL;
+	subdev->flush_txn = NULL;
+	subdev->shadow_size = 0;
+}
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Library internal methods                                       *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Reads the constant register of a subdevice, the base clock or resolution.
+ * @param subdev: Subdevice.
+ * @param offset: Offset of the constant register.
+ * @param value: Contains the constant.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_cache_read_constant(flink_subdev* subdev, uint32_t offset, uint32_t* value) {
+	uint32_t constant;
+
+	if(subdev == NULL || value == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(__atomic_load_n(&subdev->constant_valid, __ATOMIC_ACQUIRE)) {
+		*value = __atomic_load_n(&subdev->constant, __ATOMIC_RELAXED);
+		return EXIT_SUCCESS;
+	}
+	// Threads reading concurrently all read the device and store the same value
+	if(flink_read(subdev, offset, REGISTER_WITH, &constant) != REGISTER_WITH) return EXIT_ERROR;
+	__atomic_store_n(&subdev->constant, constant, __ATOMIC_RELAXED);
+	__atomic_store_n(&subdev->constant_valid, 1, __ATOMIC_RELEASE);
+	*value = constant;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Writes registers of a cached subdevice to the cache, the subdevice must be locked.
+ * @param subdev: Cached subdevice.
+ * @param offset: Write offset, relative to the subdevice base address.
+ * @param size: Nof bytes to write.
+ * @param wdata: Data to write.
+ * @return int: 1 if cached, 0 if the write has to go to the device, -1 in case of failure.
+ */
+int flink_cache_write(flink_subdev* subdev, uint32_t offset, uint8_t size, const void* wdata) {
+	const uint8_t* src = wdata;
+	uint32_t i, value;
+	reg_kind kind;
+
+	if(size == 0 || size % REGISTER_WITH) return flush_subdev(subdev) < 0 ? EXIT_ERROR : 0;
+	for(i = 0; i < size; i += REGISTER_WITH) {
+		kind = kind_of(subdev, offset + i);
+		if(kind != REG_CACHED && kind != REG_FORCED) {
+			return flush_subdev(subdev) < 0 ? EXIT_ERROR : 0;
+		}
+	}
+
+	for(i = 0; i < size; i += REGISTER_WITH) {
+		memcpy(&value, src + i, REGISTER_WITH);
+		store(subdev, offset + i, value, kind_of(subdev, offset + i));
+	}
+	return 1;
+}
+
+/**
+ * @brief Writes a bit of a cached subdevice to the cache, the subdevice must be locked.
+ * @return int: 1 if cached, 0 if the write has to go to the device, -1 in case of failure.
+ */
+int flink_cache_write_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t value) {
+	reg_kind kind = kind_of(subdev, offset);
+	uint32_t word;
+
+	if(bit >= REGISTER_WITH * 8 || (kind != REG_CACHED && kind != REG_FORCED)) {
+		return flush_subdev(subdev) < 0 ? EXIT_ERROR : 0;
+	}
+	word = subdev->shadow[offset / REGISTER_WITH];
+	if(value) word |= 1u << bit;
+	else      word &= ~(1u << bit);
+	store(subdev, offset, word, kind);
+	return 1;
+}
+
+/**
+ * @brief Updates the bits selected by masks in registers of a cached subdevice in the cache, the subdevice must be locked.
+ * @param subdev: Cached subdevice.
+ * @param offset: Offset of the first register, relative to the subdevice base address.
+ * @param count: Nof registers.
+ * @param values: New values of the registers.
+ * @param masks: Bits to update in the registers.
+ * @return int: 1 if cached, 0 if the registers have to be modified on the device, -1 in case of failure.
+ */
+int flink_cache_write_masked(flink_subdev* subdev, uint32_t offset, uint32_t count, const uint32_t* values, const uint32_t* masks) {
+	uint32_t i, word;
+	reg_kind kind;
+
+	for(i = 0; i < count; i++) {
+		kind = kind_of(subdev, offset + i * REGISTER_WITH);
+		if(kind != REG_CACHED && kind != REG_FORCED) {
+			return flush_subdev(subdev) < 0 ? EXIT_ERROR : 0;
+		}
+	}
+	for(i = 0; i < count; i++) {
+		word = subdev->shadow[offset / REGISTER_WITH + i];
+		word = (word & ~masks[i]) | (values[i] & masks[i]);
+		store(subdev, offset + i * REGISTER_WITH, word, kind_of(subdev, offset + i * REGISTER_WITH));
+	}
+	return 1;
+}
+
+/**
+ * @brief Updates the cache after a write went to the device, the subdevice must be locked.
+ *
+ * A write to the subheader, e.g. a reset, reloads the cache. The atomic
+ * registers of a stepper motor are applied to the cached local configuration.
+ *
+ * @param subdev: Cached subdevice.
+ * @param offset: Write offset, relative to the subdevice base address.
+ * @param size: Nof bytes written, 0 for a bit.
+ * @param wdata: Data written.
+ */
+void flink_cache_written(flink_subdev* subdev, uint32_t offset, uint8_t size, const void* wdata) {
+	uint32_t i, value, conf;
+
+	if(offset < FUNC_OFFSET) {
+		if(load(subdev) < 0) dbg_print("reloading the cache of subdevice %d failed\n", subdev->id);
+		return;
+	}
+	for(i = 0; i + REGISTER_WITH <= size; i += REGISTER_WITH) {
+		if(offset + i >= subdev->shadow_size || (offset + i) % REGISTER_WITH) continue;
+		memcpy(&value, (const uint8_t*)wdata + i, REGISTER_WITH);
+		switch(kind_of(subdev, offset + i)) {
+			case REG_ATOMIC_SET:
+			case REG_ATOMIC_RESET:
+				conf = (offset + i - subdev->layout[LAYOUT_STEPPER]) / REGISTER_WITH % subdev->nof_channels;
+				conf = layout_reg(subdev, LAYOUT_STEPPER, conf);
+				if(kind_of(subdev, offset + i) == REG_ATOMIC_SET) subdev->shadow[conf / REGISTER_WITH] |= value;
+				else                                               subdev->shadow[conf / REGISTER_WITH] &= ~value;
+				break;
+			default:
+				subdev->shadow[(offset + i) / REGISTER_WITH] = value;
+				break;
+		}
+	}
+}
+
+/**
+ * @brief Commits a transaction writing to cached subdevices.
+ *
+ * The subdevices written by the transaction are locked in the order of their ids
+ * and their pending writes are flushed first, so the writes keep their order.
+ * The caches take the values written by the transaction.
+ *
+ * @param txn: Transaction with at least one operation.
+ * @param results: Array with one entry per operation, receiving the nof bytes transferred or -1.
+ * @return int: 0 if all operations succeeded, -1 if at least one failed.
+ */
+int flink_cache_commit(flink_txn* txn, ssize_t* results) {
+	uint32_t written[(UINT8_MAX + 1) / 32] = { 0 };
+	flink_dev* dev = txn->dev;
+	flink_subdev* subdev;
+	flink_op* op;
+	int i, ret = EXIT_SUCCESS;
+	size_t k;
+
+	for(k = 0; k < txn->nof_ops; k++) {
+		if(!txn->ops[k].write) continue;
+		i = txn->ops[k].subdev - dev->subdevices;
+		written[i / 32] |= 1u << (i % 32);
+	}
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		if(!(written[i / 32] & (1u << (i % 32)))) continue;
+		subdev = dev->subdevices + i;
+		pthread_mutex_lock(&subdev->lock);
+		if(flush_subdev(subdev) < 0) ret = EXIT_ERROR;
+	}
+
+	if(ret == EXIT_SUCCESS) {
+		ret = flink_txn_transfer(txn, results);
+		for(k = 0; k < txn->nof_ops; k++) {
+			op = txn->ops + k;
+			if(op->write && results[k] >= 0 && op->subdev->shadow) flink_cache_written(op->subdev, op->offset, op->size, op->data);
+		}
+	}
+	else {
+		for(k = 0; k < txn->nof_ops; k++) results[k] = EXIT_ERROR; // pending writes failed, nothing is written
+	}
+
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		if(written[i / 32] & (1u << (i % 32))) pthread_mutex_unlock(&dev->subdevices[i].lock);
+	}
+	return ret;
+}
+
+/**
+ * @brief Writes pending registers and releases the caches of all subdevices of a device.
+ */
+void flink_cache_free(flink_dev* dev) {
+	int i;
+
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		if(dev->subdevices[i].shadow) {
+			flush_dev(dev);
+			break;
+		}
+	}
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		free_shadow(dev->subdevices + i);
+	}
+	flink_txn_free(dev->flush_txn);
+	dev->flush_txn = NULL;
+}
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Enables or disables the shadow register cache of a subdevice.
+ *
+ * Enabling reads the cached registers from the device. Disabling writes
+ * pending registers first. Writes of other threads racing with enabling
+ * may bypass the cache, enable it before sharing the subdevice.
+ *
+ * @param subdev: Subdevice, the function must be PWM, analog output, digital I/O or stepper motor.
+ * @param enable: Nonzero to enable the cache.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_subdevice_set_cached(flink_subdev* subdev, uint8_t enable) {
+	uint32_t extent;
+	int ret;
+
+	if(subdev == NULL || !validate_flink_subdev(subdev)) {
+		flink_error(FLINK_EINVALSUBDEV);
+		return EXIT_ERROR;
+	}
+
+	extent = cache_extent(subdev);
+	if(enable && (extent == 0 || extent > subdev->mem_size)) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+
+	pthread_mutex_lock(&subdev->lock);
+	if(!enable || subdev->shadow) {
+		ret = EXIT_SUCCESS;
+		if(!enable && subdev->shadow) {
+			ret = flush_subdev(subdev);
+			free_shadow(subdev);
+		}
+		pthread_mutex_unlock(&subdev->lock);
+		return ret;
+	}
+
+	// Writers seeing the cache wait for the lock until it is loaded
+	subdev->dirty = calloc((extent / REGISTER_WITH + 31) / 32, sizeof(uint32_t));
+	subdev->shadow_size = extent;
+	__atomic_store_n(&subdev->shadow, calloc(extent / REGISTER_WITH, REGISTER_WITH), __ATOMIC_RELEASE);
+	ret = EXIT_SUCCESS;
+	if(subdev->shadow == NULL || subdev->dirty == NULL) {
+		libc_error();
+		ret = EXIT_ERROR;
+	}
+	else if(load(subdev) < 0) {
+		ret = EXIT_ERROR;
+	}
+	if(ret != EXIT_SUCCESS) free_shadow(subdev);
+	pthread_mutex_unlock(&subdev->lock);
+	return ret;
+}
+
+
+/**
+ * @brief Discards the cached constants of a subdevice.
+ *
+ * The base clock or resolution is read again on next use. Call it after
+ * the device was reconfigured.
+ *
+ * @param subdev: Subdevice.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_subdevice_refresh(flink_subdev* subdev) {
+	if(subdev == NULL || !validate_flink_subdev(subdev)) {
+		flink_error(FLINK_EINVALSUBDEV);
+		return EXIT_ERROR;
+	}
+	__atomic_store_n(&subdev->constant_valid, 0, __ATOMIC_RELEASE);
+	return EXIT_SUCCESS;
+}
+
+
+/**
+ * @brief Writes the pending registers of all cached subdevices of a device.
+ *
+ * Neighbouring dirty registers are written with one transfer and all
+ * transfers are submitted as one transaction. Call it at the end of
+ * every control cycle.
+ *
+ * @param dev: Flink device handle.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_flush(flink_dev* dev) {
+	if(!validate_flink_dev(dev)) {
+		flink_error(FLINK_EINVALDEV);
+		return EXIT_ERROR;
+	}
+	return flush_dev(dev);
+}
@@ -0,0 +1,32 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, register caches                       *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file cache.h
+ *  @brief Register caches: constants and shadow registers of output subdevices.
+ */
+
+#ifndef FLINKLIB_CACHE_H_
+#define FLINKLIB_CACHE_H_
+
+#include "types.h"
+
+int  flink_cache_read_constant(flink_subdev* subdev, uint32_t offset, uint32_t* value);
+int  flink_cache_write(flink_subdev* subdev, uint32_t offset, uint8_t size, const void* wdata);
+int  flink_cache_write_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t value);
+int  flink_cache_write_masked(flink_subdev* subdev, uint32_t offset, uint32_t count, const uint32_t* values, const uint32_t* masks);
+void flink_cache_written(flink_subdev* subdev, uint32_t offset, uint8_t size, const void* wdata);
+int  flink_cache_commit(flink_txn* txn, ssize_t* results);
+void flink_cache_free(flink_dev* dev);
+
+#endif // FLINKLIB_CACHE_H_
@@ -25,6 +25,7 @@
 #include "types.h"
 #include "error.h"
 #include "log.h"
+#include "layout.h"
 
 int flink_counter_set_mode(flink_subdev* subdev, uint8_t mode) {
 	// TODO
@@ -37,7 +38,7 @@ int flink_counter_get_count(flink_subdev* subdev, uint32_t channel, uint32_t* da
 		
 	dbg_print("Reading counter value from counter %d of subdevice %d\n", channel, subdev->id);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + REGISTER_WITH * channel;
+	offset = layout_reg(subdev, LAYOUT_VALUE, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_read(subdev, offset, REGISTER_WITH, data) != REGISTER_WITH) {
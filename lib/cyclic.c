@@ -0,0 +1,280 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, cyclic executor                       *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file cyclic.c
+ *  @brief Periodic control loop.
+ *
+ *  A cyclic executor runs a control cycle at a fixed period: it commits
+ *  the read set, calls the handler, commits the write set and flushes the
+ *  shadow registers of the device. The releases are absolute times, so
+ *  the cycles neither drift nor accumulate the jitter of a relative sleep.
+ *  A cycle ending after the release of the next one is an overrun, the
+ *  releases which already passed are skipped instead of run back to back.
+ */
+
+#include "flinklib.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "valid.h"
+#include "thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Applies the real-time settings to the calling thread.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+static int setup_thread(flink_cyclic* cyc) {
+	if(cyc->lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+	return flink_thread_set_realtime(cyc->cpu, cyc->priority);
+}
+
+/**
+ * @brief Records a cycle in the statistics.
+ */
+static void record(flink_cyclic* cyc, uint64_t latency, uint64_t exec, uint64_t jitter, uint8_t error) {
+	flink_cyclic_stats* stats = &cyc->stats;
+
+	pthread_mutex_lock(&cyc->lock);
+	if(stats->cycles == 0 || latency < stats->latency_min_ns) stats->latency_min_ns = latency;
+	if(stats->cycles == 0 || exec < stats->exec_min_ns) stats->exec_min_ns = exec;
+	if(latency > stats->latency_max_ns) stats->latency_max_ns = latency;
+	if(exec > stats->exec_max_ns) stats->exec_max_ns = exec;
+	if(jitter > stats->jitter_max_ns) stats->jitter_max_ns = jitter;
+	stats->latency_avg_ns += latency;
+	stats->exec_avg_ns += exec;
+	stats->errors += error;
+	stats->cycles++;
+	pthread_mutex_unlock(&cyc->lock);
+}
+
+/**
+ * @brief Counts an overrun and returns the next release in the future.
+ */
+static uint64_t skip_releases(flink_cyclic* cyc, uint64_t release, uint64_t now) {
+	uint64_t skipped = (now - release) / cyc->period_ns + 1;
+
+	pthread_mutex_lock(&cyc->lock);
+	cyc->stats.overruns++;
+	cyc->stats.skipped += skipped;
+	pthread_mutex_unlock(&cyc->lock);
+	return release + skipped * cyc->period_ns;
+}
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Creates a cyclic executor.
+ * @param dev: Flink device accessed by the cycles.
+ * @param period_us: Cycle period in us.
+ * @param handler: Called in every cycle between reads and writes, a non-zero return value ends the run. May be NULL.
+ * @param arg: Argument passed to the handler.
+ * @return flink_cyclic*: Executor or NULL in case of failure.
+ */
+flink_cyclic* flink_cyclic_create(flink_dev* dev, uint32_t period_us, flink_cycle_handler handler, void* arg) {
+	flink_cyclic* cyc;
+
+	if(!validate_flink_dev(dev)) {
+		flink_error(FLINK_EINVALDEV);
+		return NULL;
+	}
+	if(period_us == 0) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return NULL;
+	}
+	cyc = calloc(1, sizeof(flink_cyclic));
+	if(cyc == NULL) {
+		libc_error();
+		return NULL;
+	}
+	cyc->dev = dev;
+	cyc->period_ns = (uint64_t)period_us * 1000;
+	cyc->handler = handler;
+	cyc->arg = arg;
+	cyc->cpu = -1;
+	pthread_mutex_init(&cyc->lock, NULL);
+	cyc->reads = flink_txn_begin(dev);
+	cyc->writes = flink_txn_begin(dev);
+	if(cyc->reads == NULL || cyc->writes == NULL) {
+		flink_cyclic_free(cyc);
+		return NULL;
+	}
+	return cyc;
+}
+
+/**
+ * @brief Adds a register to the read set, which is read at the start of every cycle.
+ * @param cyc: Cyclic executor.
+ * @param subdev: Subdevice of the executor's device.
+ * @param offset: Register offset, relative to the subdevice base address.
+ * @param size: Nof bytes to read.
+ * @param rdata: Buffer receiving the data in every cycle.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_cyclic_add_read(flink_cyclic* cyc, flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata) {
+	if(cyc == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	return flink_txn_add_read(cyc->reads, subdev, offset, size, rdata);
+}
+
+/**
+ * @brief Adds a register to the write set, which is written at the end of every cycle.
+ * @param cyc: Cyclic executor.
+ * @param subdev: Subdevice of the executor's device.
+ * @param offset: Register offset, relative to the subdevice base address.
+ * @param size: Nof bytes to write.
+ * @param wdata: Buffer holding the data written in every cycle.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_cyclic_add_write(flink_cyclic* cyc, flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata) {
+	if(cyc == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	return flink_txn_add_write(cyc->writes, subdev, offset, size, wdata);
+}
+
+/**
+ * @brief Sets the real-time settings applied to the thread calling flink_cyclic_run().
+ * @param cyc: Cyclic executor.
+ * @param cpu: CPU to pin the thread to, -1 for no pinning.
+ * @param priority: SCHED_FIFO priority, 0 to keep the scheduling.
+ * @param lock_memory: Lock all current and future pages of the process with mlockall.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_cyclic_set_realtime(flink_cyclic* cyc, int cpu, int priority, uint8_t lock_memory) {
+	if(cyc == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	cyc->cpu = cpu;
+	cyc->priority = priority;
+	cyc->lock_memory = lock_memory;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Runs cycles in the calling thread.
+ *
+ * The first cycle starts immediately. The run ends after the given nof cycles, when the
+ * handler returns non-zero or when flink_cyclic_stop() is called.
+ *
+ * @param cyc: Cyclic executor.
+ * @param nof_cycles: Nof cycles to run, 0 to run until stopped.
+ * @return int: 0 on success, -1 if the real-time settings could not be applied.
+ */
+int flink_cyclic_run(flink_cyclic* cyc, uint64_t nof_cycles) {
+	uint64_t cycle, release, start, end, last_start = 0, jitter;
+	uint8_t error;
+
+	if(cyc == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(setup_thread(cyc) != EXIT_SUCCESS) return EXIT_ERROR;
+	__atomic_store_n(&cyc->stop, 0, __ATOMIC_RELAXED);
+
+	release = flink_now_ns();
+	for(cycle = 0; nof_cycles == 0 || cycle < nof_cycles; cycle++) {
+		flink_sleep_until(release);
+		if(__atomic_load_n(&cyc->stop, __ATOMIC_RELAXED)) break;
+		start = flink_now_ns();
+
+		error = 0;
+		if(cyc->reads->nof_ops > 0 && flink_txn_commit(cyc->reads, NULL) != EXIT_SUCCESS) error = 1;
+		if(cyc->handler != NULL && cyc->handler(cyc, cycle, cyc->arg) != 0) flink_cyclic_stop(cyc);
+		if(cyc->writes->nof_ops > 0 && flink_txn_commit(cyc->writes, NULL) != EXIT_SUCCESS) error = 1;
+		if(flink_flush(cyc->dev) != EXIT_SUCCESS) error = 1;
+		end = flink_now_ns();
+
+		jitter = 0;
+		if(cycle > 0) {
+			jitter = start - last_start > cyc->period_ns ? start - last_start - cyc->period_ns : cyc->period_ns - (start - last_start);
+		}
+		last_start = start;
+		record(cyc, start - release, end - start, jitter, error);
+
+		release += cyc->period_ns;
+		if(end > release) release = skip_releases(cyc, release, end);
+	}
+	dbg_print("cyclic executor ran %llu cycles\n", (unsigned long long)cycle);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Ends the run after the current cycle. May be called from the handler or another thread.
+ * @param cyc: Cyclic executor.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_cyclic_stop(flink_cyclic* cyc) {
+	if(cyc == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	__atomic_store_n(&cyc->stop, 1, __ATOMIC_RELAXED);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Reads the statistics of the cycles run so far.
+ * @param cyc: Cyclic executor.
+ * @param stats: Contains the statistics.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_cyclic_get_stats(flink_cyclic* cyc, flink_cyclic_stats* stats) {
+	if(cyc == NULL || stats == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	pthread_mutex_lock(&cyc->lock);
+	*stats = cyc->stats;
+	pthread_mutex_unlock(&cyc->lock);
+	if(stats->cycles > 0) {
+		stats->latency_avg_ns /= stats->cycles;
+		stats->exec_avg_ns /= stats->cycles;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Frees a cyclic executor which is not running.
+ * @param cyc: Cyclic executor.
+ */
+void flink_cyclic_free(flink_cyclic* cyc) {
+	if(cyc == NULL) return;
+	flink_txn_free(cyc->reads);
+	flink_txn_free(cyc->writes);
+	pthread_mutex_destroy(&cyc->lock);
+	free(cyc);
+}
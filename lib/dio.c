@@ -28,6 +28,9 @@
 #include "types.h"
 #include "error.h"
 #include "log.h"
+#include "cache.h"
+#include "lowlevel.h"
+#include "layout.h"
 
 #include <stdint.h>
 
@@ -42,10 +45,10 @@ int flink_dio_get_baseclock(flink_subdev* subdev, uint32_t* frequency) {
 
 	dbg_print("Reading base clock from dio subdevice %d\n", subdev->id);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE;
+	offset = subdev->layout[LAYOUT_CONSTANT];
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
-	if(flink_read(subdev, offset, REGISTER_WITH, frequency) != REGISTER_WITH) {
+	if(flink_cache_read_constant(subdev, offset, frequency) < 0) {
 		libc_error();
 		return EXIT_ERROR;
 	}
@@ -65,7 +68,7 @@ int flink_dio_set_direction(flink_subdev* subdev, uint32_t channel, uint8_t outp
 	
 	dbg_print("Setting digital I/O direction for channel %d on subdevice %d\n", channel, subdev->id);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + 4 + (channel / (REGISTER_WITH * 8)) * REGISTER_WITH;
+	offset = layout_bit_reg(subdev, LAYOUT_DIO_DIRECTION, channel);
 	bit = channel % (REGISTER_WITH * 8);
 	
 	dbg_print("   --> calculated offset is 0x%x\n", offset);
@@ -92,9 +95,7 @@ int flink_dio_set_value(flink_subdev* subdev, uint32_t channel, uint8_t value) {
 	
 	dbg_print("Setting digital output value to %u...\n", val);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + 4;
-	offset += ((subdev->nof_channels - 1) / (REGISTER_WITH * 8) + 1) * REGISTER_WITH;
-	offset += (channel / (REGISTER_WITH * 8)) * REGISTER_WITH;
+	offset = layout_bit_reg(subdev, LAYOUT_DIO_VALUE, channel);
 	bit = channel % (REGISTER_WITH * 8);
 	
 	dbg_print("   --> calculated offset is 0x%x\n", offset);
@@ -120,9 +121,7 @@ int flink_dio_get_value(flink_subdev* subdev, uint32_t channel, uint8_t* value)
 	
 	dbg_print("Reading digital input value from channel %d on subdevice %d\n", channel, subdev->id);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + 4;
-	offset += ((subdev->nof_channels - 1) / (REGISTER_WITH * 8) + 1) * REGISTER_WITH;
-	offset += (channel / (REGISTER_WITH * 8)) * REGISTER_WITH;
+	offset = layout_bit_reg(subdev, LAYOUT_DIO_VALUE, channel);
 	bit = channel % (REGISTER_WITH * 8);
 	
 	dbg_print("[DEBUG]   --> calculated offset is 0x%x\n", offset);
@@ -146,9 +145,7 @@ int flink_dio_set_debounce(flink_subdev* subdev, uint32_t channel, uint32_t debo
 	uint32_t offset;
 
 	dbg_print("Write digital input debounce time from channel %d on subdevice %d\n", channel, subdev->id);
-	offset = HEADER_SIZE + SUBHEADER_SIZE + 4;
-	offset += ((subdev->nof_channels - 1) / (REGISTER_WITH * 8) + 1) * REGISTER_WITH * 2;
-	offset += channel * REGISTER_WITH;
+	offset = layout_reg(subdev, LAYOUT_DIO_DEBOUNCE, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_write(subdev, offset, REGISTER_WITH, &debounce) != REGISTER_WITH) {
@@ -169,9 +166,7 @@ int flink_dio_get_debounce(flink_subdev* subdev, uint32_t channel, uint32_t* deb
 	uint32_t offset;
 
 	dbg_print("Read digital input debounce time from channel %d on subdevice %d\n", channel, subdev->id);
-	offset = HEADER_SIZE + SUBHEADER_SIZE + 4;
-	offset += ((subdev->nof_channels - 1) / (REGISTER_WITH * 8) + 1) * REGISTER_WITH * 2;
-	offset += channel * REGISTER_WITH;
+	offset = layout_reg(subdev, LAYOUT_DIO_DEBOUNCE, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_read(subdev, offset, REGISTER_WITH, debounce) != REGISTER_WITH) {
@@ -180,3 +175,133 @@ int flink_dio_get_debounce(flink_subdev* subdev, uint32_t channel, uint32_t* deb
 	}
 	return EXIT_SUCCESS;
 }
+
+/*******************************************************************
+ *                                                                 *
+ *  Port operations, 32 channels per port                          *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Reads or writes consecutive registers with as few accesses as possible.
+ */
+static int transfer_words(flink_subdev* subdev, uint32_t offset, uint32_t count, uint32_t* data, uint8_t write) {
+	const uint32_t max_chunk = UINT8_MAX / REGISTER_WITH; // words per access
+	uint32_t chunk;
+	ssize_t ret;
+	
+	while(count > 0) {
+		chunk = count < max_chunk ? count : max_chunk;
+		if(write) ret = flink_write(subdev, offset, chunk * REGISTER_WITH, data);
+		else      ret = flink_read(subdev, offset, chunk * REGISTER_WITH, data);
+		if(ret != chunk * REGISTER_WITH) {
+			libc_error();
+			return EXIT_ERROR;
+		}
+		offset += chunk * REGISTER_WITH;
+		data += chunk;
+		count -= chunk;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Checks a port range and calculates the offset of its first register.
+ */
+static int port_offset(flink_subdev* subdev, uint32_t port, uint32_t count, int group, uint32_t* offset) {
+	uint32_t nof_ports = layout_bit_words(subdev);
+	
+	if(port > nof_ports || count > nof_ports - port) {
+		flink_error(FLINK_EINVALCHAN);
+		return EXIT_ERROR;
+	}
+	*offset = layout_reg(subdev, group, port);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Updates the bits selected by masks in consecutive registers, with one read and one write per chunk.
+ */
+static int modify_words(flink_subdev* subdev, uint32_t offset, uint32_t count, const uint32_t* values, const uint32_t* masks) {
+	const uint32_t max_chunk = UINT8_MAX / REGISTER_WITH; // words per access
+	uint32_t chunk;
+	
+	while(count > 0) {
+		chunk = count < max_chunk ? count : max_chunk;
+		if(flink_write_masked(subdev, offset, chunk, values, masks) < 0) return EXIT_ERROR;
+		offset += chunk * REGISTER_WITH;
+		values += chunk;
+		masks += chunk;
+		count -= chunk;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Reads the values of whole ports
+ * @param subdev: Subdevice containing the channels.
+ * @param port: First port, port n contains the channels 32*n to 32*n+31.
+ * @param count: Number of ports to read.
+ * @param values: Array of count words, bit k of word i contains channel 32*(port+i)+k.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_dio_get_port(flink_subdev* subdev, uint32_t port, uint32_t count, uint32_t* values) {
+	uint32_t offset;
+	
+	if(subdev == NULL || values == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(port_offset(subdev, port, count, LAYOUT_DIO_VALUE, &offset) < 0) return EXIT_ERROR;
+	dbg_print("Reading digital I/O ports %u to %u on subdevice %d\n", port, port + count - 1, subdev->id);
+	
+	return transfer_words(subdev, offset, count, values, 0);
+}
+
+/**
+ * @brief Sets the output channels selected by masks
+ *
+ * The ports are read and written back with the selected bits modified.
+ * Other channels keep their values.
+ *
+ * @param subdev: Subdevice containing the channels.
+ * @param port: First port, port n contains the channels 32*n to 32*n+31.
+ * @param count: Number of ports to modify.
+ * @param values: Array of count words with the new channel values.
+ * @param masks: Array of count words, channels with a set bit are modified.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_dio_set_port_masked(flink_subdev* subdev, uint32_t port, uint32_t count, const uint32_t* values, const uint32_t* masks) {
+	uint32_t offset;
+	
+	if(subdev == NULL || values == NULL || masks == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(port_offset(subdev, port, count, LAYOUT_DIO_VALUE, &offset) < 0) return EXIT_ERROR;
+	dbg_print("Setting digital I/O ports %u to %u on subdevice %d\n", port, port + count - 1, subdev->id);
+	
+	return modify_words(subdev, offset, count, values, masks);
+}
+
+/**
+ * @brief Configures the channels selected by masks as inputs or outputs
+ * @param subdev: Subdevice containing the channels.
+ * @param port: First port, port n contains the channels 32*n to 32*n+31.
+ * @param count: Number of ports to configure.
+ * @param outputs: Array of count words, a set bit configures the channel as output.
+ * @param masks: Array of count words, channels with a set bit are configured.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_dio_set_direction_mask(flink_subdev* subdev, uint32_t port, uint32_t count, const uint32_t* outputs, const uint32_t* masks) {
+	uint32_t offset;
+	
+	if(subdev == NULL || outputs == NULL || masks == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(port_offset(subdev, port, count, LAYOUT_DIO_DIRECTION, &offset) < 0) return EXIT_ERROR;
+	dbg_print("Setting digital I/O direction of ports %u to %u on subdevice %d\n", port, port + count - 1, subdev->id);
+	
+	return modify_words(subdev, offset, count, outputs, masks);
+}
@@ -21,6 +21,7 @@
 #include "error.h"
 #include <errno.h>
 #include "log.h"
+#include <stdio.h>
 #include <string.h>
 
 __thread int flink_errno = 0;
@@ -35,6 +36,7 @@ const char* flinklib_error_strings[] = {
 	"Null ptr as argument",
 	"Unknown ioctl command",
 	"Wrong subdevice type",
+	"Invalid register offset",
 };
 #define NOF_ERRORS (sizeof(flinklib_error_strings) / sizeof(char*))
 
@@ -55,15 +57,15 @@ void flink_perror(const char* p) {
 
 void libc_error(void) {
 	flink_errno = errno;
-	if(PRINT_ERRORS_TO_STDERR){
-		flink_perror("libc error");
+	if(flink_log_enabled(FLINK_LOG_ERROR)) {
+		flink_log(FLINK_LOG_ERROR, flink_errno, "libc error: %s", flink_strerror(flink_errno));
 	}
 }
 
 
 void flink_error(int e) {
 	flink_errno = e;
-	if(PRINT_ERRORS_TO_STDERR){
-		flink_perror("flink error");
+	if(flink_log_enabled(FLINK_LOG_ERROR)) {
+		flink_log(FLINK_LOG_ERROR, e, "flink error: %s", flink_strerror(e));
 	}
 }
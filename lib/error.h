@@ -32,6 +32,9 @@
 #define FLINK_ENULLPTR		(FLINK_NOERROR + 6)		// Null ptr as argument
 #define FLINK_UNKNOWNIOCTL	(FLINK_NOERROR + 7)		// Unknown ioctl command
 #define FLINK_WRONGSUBDEVT	(FLINK_NOERROR + 8)		// Wrong subdevice type
+#define FLINK_EINVALOFFS	(FLINK_NOERROR + 9)		// Invalid register offset
+
+extern __thread int flink_errno;
 
 const char* flink_strerror(int e);
 void flink_perror(const char* p);
@@ -25,6 +25,7 @@
 #include "types.h"
 #include "error.h"
 #include "log.h"
+#include "layout.h"
 
 #include <stdint.h>
 
@@ -41,7 +42,7 @@ int flink_info_get_description(flink_subdev* subdev, char* desc) {
 	
 	dbg_print("Reading description from info subdevice with id %d\n", subdev->id);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + REGISTER_WITH;
+	offset = subdev->layout[LAYOUT_DESCRIPTION];
 	for(i = 0; i < INFO_DESC_SIZE; i += 4, offset += 4) {
 		if(flink_read(subdev, offset, 4, &data) != REGISTER_WITH) {
 			libc_error();
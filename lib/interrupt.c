@@ -26,8 +26,19 @@
 #include "types.h"
 #include "error.h"
 #include "log.h"
+#include "layout.h"
+#include "probe.h"
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/signalfd.h>
+
+#define IRQ_READ_BATCH	16	// siginfos read per call
 
 /**
  * @brief Registers a irq handler
@@ -45,6 +56,7 @@ int flink_register_irq(flink_dev *dev, uint32_t irq_number){
 
 	// read data from device
 	read_size = flink_ioctl(dev, REGISTER_IRQ, &ioctl_arg);
+	PROBE2(irq_register, irq_number, read_size);
 	if(read_size < 0) {
 		libc_error();
 		return EXIT_ERROR;
@@ -69,6 +81,7 @@ int flink_unregister_irq(flink_dev *dev, uint32_t irq_number){
 
 	// read data from device
 	read_size = flink_ioctl(dev, UNREGISTER_IRQ, &ioctl_arg);
+	PROBE2(irq_unregister, irq_number, read_size);
 	if(read_size < 0) {
 		libc_error();
 		return EXIT_ERROR;
@@ -111,7 +124,7 @@ int flink_get_signal_offset(flink_dev *dev, uint32_t *offset){
 int flink_set_irq_multiplex(flink_subdev *subdev, uint32_t irq, uint32_t flink_irq) {
 	uint32_t offset = 0;
 
-	offset = HEADER_SIZE + SUBHEADER_SIZE + REGISTER_WITH*irq;
+	offset = layout_reg(subdev, LAYOUT_IRQ, irq);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 
 	if(flink_write(subdev, offset, REGISTER_WITH, &flink_irq) != REGISTER_WITH) {
@@ -132,7 +145,7 @@ int flink_set_irq_multiplex(flink_subdev *subdev, uint32_t irq, uint32_t flink_i
 int flink_get_irq_multiplex(flink_subdev *subdev, uint32_t irq, uint32_t *flink_irq) {
     uint32_t offset = 0;
 
-	offset = HEADER_SIZE + SUBHEADER_SIZE + REGISTER_WITH*irq;
+	offset = layout_reg(subdev, LAYOUT_IRQ, irq);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_read(subdev, offset, REGISTER_WITH, flink_irq) != REGISTER_WITH) {
@@ -141,3 +154,188 @@ int flink_get_irq_multiplex(flink_subdev *subdev, uint32_t irq, uint32_t *flink_
 	}
 	return EXIT_SUCCESS;
 }
+
+/**
+ * @brief Unregisters the IRQs of an interrupt handle and frees it.
+ * @param irq: Interrupt handle.
+ * @param nof_registered: Nof IRQs registered so far.
+ */
+static void free_irq(flink_irq* irq, uint8_t nof_registered) {
+	uint8_t i;
+
+	for(i = 0; i < nof_registered; i++) flink_unregister_irq(irq->dev, irq->irqs[i]);
+	if(irq->fd >= 0) {
+		flink_irq_read(irq, NULL); // discard signals which are still queued
+		close(irq->fd);
+	}
+	free(irq->irqs);
+	free(irq->signals);
+	free(irq);
+}
+
+/**
+ * @brief Registers a set of IRQs and returns a handle with a pollable file descriptor.
+ *
+ * The signals of the IRQs are blocked in the calling thread and received through a
+ * signalfd instead of a signal handler. Threads created afterwards inherit the blocked
+ * signals, threads created before must block them as well. The signals stay blocked 
+ * after flink_irq_close().
+ *
+ * @param dev: Flink device.
+ * @param irqs: IRQ numbers to register.
+ * @param nof_irqs: Nof IRQs.
+ * @return flink_irq*: Interrupt handle or NULL in case of failure.
+ */
+flink_irq* flink_irq_open(flink_dev* dev, const uint32_t* irqs, uint8_t nof_irqs) {
+	flink_irq* irq;
+	uint32_t signal_offset;
+	sigset_t set;
+	uint8_t i;
+	int sig;
+
+	if(dev == NULL) {
+		flink_error(FLINK_EINVALDEV);
+		return NULL;
+	}
+	if(irqs == NULL || nof_irqs == 0) {
+		flink_error(FLINK_ENULLPTR);
+		return NULL;
+	}
+	if(flink_get_signal_offset(dev, &signal_offset) != EXIT_SUCCESS) return NULL;
+
+	irq = calloc(1, sizeof(flink_irq));
+	if(irq == NULL) {
+		libc_error();
+		return NULL;
+	}
+	irq->dev = dev;
+	irq->fd = -1;
+	irq->nof_irqs = nof_irqs;
+	irq->irqs = calloc(nof_irqs, sizeof(uint32_t));
+	irq->signals = calloc(nof_irqs, sizeof(int));
+	if(irq->irqs == NULL || irq->signals == NULL) {
+		libc_error();
+		free_irq(irq, 0);
+		return NULL;
+	}
+
+	// Block the signals before registering, an unhandled real-time signal terminates the process
+	sigemptyset(&set);
+	for(i = 0; i < nof_irqs; i++) {
+		irq->irqs[i] = irqs[i];
+		irq->signals[i] = signal_offset + irqs[i];
+		sigaddset(&set, irq->signals[i]);
+	}
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+	irq->fd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+	if(irq->fd < 0) {
+		libc_error();
+		free_irq(irq, 0);
+		return NULL;
+	}
+
+	for(i = 0; i < nof_irqs; i++) {
+		sig = flink_register_irq(dev, irqs[i]);
+		if(sig < 0) {
+			free_irq(irq, i);
+			return NULL;
+		}
+		dbg_print("  --> irq %u is signal %d\n", irqs[i], sig);
+	}
+	return irq;
+}
+
+/**
+ * @brief Returns the file descriptor of an interrupt handle.
+ *
+ * The file descriptor becomes readable when one of the IRQs occurred. It can be 
+ * waited on with poll, select or epoll together with other file descriptors.
+ *
+ * @param irq: Interrupt handle.
+ * @return int: File descriptor, -1 in case of failure.
+ */
+int flink_irq_get_fd(flink_irq* irq) {
+	if(irq == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	return irq->fd;
+}
+
+/**
+ * @brief Reads the pending interrupts without blocking.
+ * @param irq: Interrupt handle.
+ * @param counts: Contains the nof occurrences of each IRQ, in the order passed to flink_irq_open(). May be NULL.
+ * @return int: Nof interrupts read, 0 if none is pending, -1 in case of failure.
+ */
+int flink_irq_read(flink_irq* irq, uint32_t* counts) {
+	struct signalfd_siginfo info[IRQ_READ_BATCH];
+	ssize_t size;
+	int n = 0;
+	size_t k;
+	uint8_t i;
+
+	if(irq == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(counts != NULL) {
+		for(i = 0; i < irq->nof_irqs; i++) counts[i] = 0;
+	}
+
+	while((size = read(irq->fd, info, sizeof(info))) > 0) {
+		for(k = 0; k < size / sizeof(info[0]); k++) {
+			for(i = 0; i < irq->nof_irqs; i++) {
+				if(irq->signals[i] == (int)info[k].ssi_signo) break;
+			}
+			if(i == irq->nof_irqs) continue;
+			PROBE1(irq_receive, irq->irqs[i]);
+			if(counts != NULL) counts[i]++;
+			n++;
+		}
+	}
+	if(size < 0 && errno != EAGAIN) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+	return n;
+}
+
+/**
+ * @brief Waits for interrupts and reads them.
+ * @param irq: Interrupt handle.
+ * @param timeout_ms: Maximum time to wait in ms, -1 waits forever.
+ * @param counts: Contains the nof occurrences of each IRQ, in the order passed to flink_irq_open(). May be NULL.
+ * @return int: Nof interrupts read, 0 on timeout, -1 in case of failure or if interrupted by a signal.
+ */
+int flink_irq_wait(flink_irq* irq, int timeout_ms, uint32_t* counts) {
+	struct pollfd pfd;
+	int ret;
+
+	if(irq == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	pfd.fd = irq->fd;
+	pfd.events = POLLIN;
+	ret = poll(&pfd, 1, timeout_ms);
+	if(ret < 0) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+	return flink_irq_read(irq, counts);
+}
+
+/**
+ * @brief Unregisters the IRQs of an interrupt handle and closes its file descriptor.
+ * @param irq: Interrupt handle.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_irq_close(flink_irq* irq) {
+	if(irq == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	free_irq(irq, irq->nof_irqs);
+	return EXIT_SUCCESS;
+}
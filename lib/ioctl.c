@@ -0,0 +1,185 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, ioctl backend                         *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file ioctl.c
+ *  @brief Backend accessing a flink device through the ioctl interface of the driver.
+ *
+ *  Every register access is one ioctl call on the device file. This is
+ *  the default backend, used for names without URI scheme.
+ *
+ *  @author Martin Züger
+ *  @author Urs Graf
+ */
+
+#include "flinklib.h"
+#include "flinkioctl.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "backend.h"
+#include "stats.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Read number of subdevices from flink device.
+ *
+ * @param dev: Device to read
+ * @return int: Number of flink devices or -1 in case of error.
+ */
+static int read_nof_subdevices(flink_dev* dev) {
+	uint8_t n = 0;
+
+	dbg_print("reading number of subdevices...\n");
+
+	if(flink_ioctl(dev, READ_NOF_SUBDEVICES, &n) < 0) {
+		dbg_print("   --> failed!\n");
+		libc_error();
+		return EXIT_ERROR;
+	}
+	dbg_print("  --> %u\n", n);
+	return n;
+}
+
+static int ioctl_open(flink_dev* dev, const char* path) {
+	dev->fd = open(path, O_RDWR);
+	if(dev->fd < 0) { // failed to open device
+		libc_error();
+		return EXIT_ERROR;
+	}
+	return EXIT_SUCCESS;
+}
+
+static int ioctl_close(flink_dev* dev) {
+	return close(dev->fd);
+}
+
+static int ioctl_ioctl(flink_dev* dev, int cmd, void* arg) {
+	int ret = ioctl(dev->fd, cmd, arg);
+	STATS_INC(&dev->stats, syscalls);
+	if(ret < 0) {
+		libc_error();
+	}
+	return ret;
+}
+
+static ssize_t ioctl_read(flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata) {
+	ioctl_container_t ioctl_arg;
+	ioctl_arg.subdevice = subdev->id;
+	ioctl_arg.offset    = offset;
+	ioctl_arg.size      = size;
+	ioctl_arg.data      = rdata;
+
+	return ioctl_ioctl(subdev->parent, SELECT_AND_READ, &ioctl_arg);
+}
+
+static ssize_t ioctl_write(flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata) {
+	ioctl_container_t ioctl_arg;
+	ioctl_arg.subdevice = subdev->id;
+	ioctl_arg.offset    = offset;
+	ioctl_arg.size      = size;
+	ioctl_arg.data      = wdata;
+
+	return ioctl_ioctl(subdev->parent, SELECT_AND_WRITE, &ioctl_arg);
+}
+
+static int ioctl_read_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t* value) {
+	ioctl_bit_container_t ioctl_arg;
+	ioctl_arg.offset    = offset;
+	ioctl_arg.bit       = bit;
+	ioctl_arg.subdevice = subdev->id;
+
+	if(ioctl_ioctl(subdev->parent, SELECT_AND_READ_BIT, &ioctl_arg) < 0) {
+		return EXIT_ERROR;
+	}
+	*value = ioctl_arg.value;
+	return EXIT_SUCCESS;
+}
+
+static int ioctl_write_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t value) {
+	ioctl_bit_container_t ioctl_arg;
+	ioctl_arg.offset    = offset;
+	ioctl_arg.bit       = bit;
+	ioctl_arg.value     = value;
+	ioctl_arg.subdevice = subdev->id;
+
+	if(ioctl_ioctl(subdev->parent, SELECT_AND_WRITE_BIT, &ioctl_arg) < 0) {
+		return EXIT_ERROR;
+	}
+	return EXIT_SUCCESS;
+}
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Read number of subdevices with an ioctl command.
+ *
+ * @param dev: flink device to read
+ * @return int: number of subdevices, or -1 in case of error.
+ */
+int flink_ioctl_count(flink_dev* dev) {
+	return read_nof_subdevices(dev);
+}
+
+/**
+ * @brief Read header of all subdevices with ioctl commands and update flink device.
+ *
+ * The driver offers no command returning all headers at once, so every
+ * header is read with its own READ_SUBDEVICE_INFO command.
+ *
+ * @param dev: flink device to update, with the subdevice array allocated
+ * @return int: number of subdevices read, or -1 in case of error.
+ */
+int flink_ioctl_enumerate(flink_dev* dev) {
+	flink_subdev* subdev = NULL;
+	int i = 0, ret = 0;
+
+	// Fillup all information
+	for(i = 0; i < dev->nof_subdevices; i++) { // for each subdevice
+		subdev = dev->subdevices + i;
+		subdev->id = i;
+		ret = flink_ioctl(dev, READ_SUBDEVICE_INFO, subdev);
+		if (ret < 0) return ret;
+		subdev->parent = dev;
+	}
+
+	return i;
+}
+
+const flink_backend flink_ioctl_backend = {
+	.scheme    = "ioctl",
+	.open      = ioctl_open,
+	.close     = ioctl_close,
+	.count     = flink_ioctl_count,
+	.enumerate = flink_ioctl_enumerate,
+	.ioctl     = ioctl_ioctl,
+	.read      = ioctl_read,
+	.write     = ioctl_write,
+	.read_bit  = ioctl_read_bit,
+	.write_bit = ioctl_write_bit,
+};
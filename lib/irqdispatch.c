@@ -0,0 +1,502 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, interrupt dispatcher                  *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file irqdispatch.c
+ *  @brief Thread waiting on all IRQs of a device and calling their handlers.
+ *
+ *  The driver sends the signal of an IRQ to the thread which registered
+ *  it. The dispatcher thread therefore registers and unregisters the IRQs
+ *  itself: flink_irq_dispatcher_add() and _remove() pass a request to the
+ *  thread and wait for its result. The signals are blocked in the thread
+ *  and received through one signalfd, so the handlers run in the thread
+ *  and not in signal context. The interrupts of an IRQ are collected in
+ *  a batch which is delivered to the handler at once: at every wake-up,
+ *  or for a coalesced IRQ when the batch reaches its maximum size or age.
+ *
+ *  The time of reception is taken when the thread wakes up. For every
+ *  handler call the latency from the reception of the first interrupt of
+ *  the batch to handler start and the run time of the handler are
+ *  recorded in the statistics of the IRQ.
+ */
+
+#define _GNU_SOURCE	// ppoll
+
+#include "flinklib.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "valid.h"
+#include "thread.h"
+#include "probe.h"
+
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <string.h>
+#include <time.h>
+
+#define IRQ_READ_BATCH	16	// siginfos read per call
+#define NO_DEADLINE		UINT64_MAX
+
+enum { REQ_IDLE, REQ_PENDING, REQ_DONE };
+enum { OP_ADD, OP_REMOVE, OP_STOP, OP_GET_STATS, OP_RESET_STATS };
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Histogram bin of a latency, the bins grow by powers of two.
+ */
+static inline int hist_bin(uint64_t ns) {
+	int bin = ns > 1 ? 63 - __builtin_clzll(ns) : 0;
+	return bin < FLINK_IRQ_HIST_BINS ? bin : FLINK_IRQ_HIST_BINS - 1;
+}
+
+/**
+ * @brief Upper bound of the bin containing a percentile of the latencies.
+ */
+static uint64_t percentile(const flink_irq_stats* stats, uint32_t percent) {
+	uint64_t rank = (stats->calls * percent + 99) / 100, sum = 0;
+	int bin;
+
+	for(bin = 0; bin < FLINK_IRQ_HIST_BINS; bin++) {
+		sum += stats->histogram[bin];
+		if(sum >= rank) break;
+	}
+	if(bin >= FLINK_IRQ_HIST_BINS - 1) return stats->latency_max_ns;
+	return (2ull << bin) < stats->latency_max_ns ? (2ull << bin) : stats->latency_max_ns;
+}
+
+/**
+ * @brief Records a handler call in the statistics of an IRQ.
+ */
+static void record(flink_irq_stats* stats, uint32_t count, uint64_t latency, uint64_t duration) {
+	if(stats->calls == 0 || latency < stats->latency_min_ns) stats->latency_min_ns = latency;
+	if(stats->calls == 0 || duration < stats->duration_min_ns) stats->duration_min_ns = duration;
+	if(latency > stats->latency_max_ns) stats->latency_max_ns = latency;
+	if(duration > stats->duration_max_ns) stats->duration_max_ns = duration;
+	stats->latency_avg_ns += latency;
+	stats->duration_avg_ns += duration;
+	stats->histogram[hist_bin(latency)]++;
+	stats->count += count;
+	stats->coalesced += count - 1;
+	stats->calls++;
+}
+
+/**
+ * @brief Copies the statistics of an IRQ, turning the sums into averages.
+ */
+static void get_stats(const flink_irq_stats* sums, flink_irq_stats* stats) {
+	*stats = *sums;
+	if(stats->calls == 0) return;
+	stats->latency_avg_ns /= stats->calls;
+	stats->duration_avg_ns /= stats->calls;
+	stats->latency_p50_ns = percentile(sums, 50);
+	stats->latency_p99_ns = percentile(sums, 99);
+}
+
+static inline int slot_used(const flink_irq_slot* slot) {
+	return slot->handler != NULL || slot->batch_handler != NULL;
+}
+
+/**
+ * @brief Executes a request in the dispatcher thread.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+static int execute(flink_irq_dispatcher* disp, int op, uint32_t irq, void* arg) {
+	flink_irq_slot* slot;
+	flink_irq_slot* add = arg;
+
+	if(op == OP_STOP) {
+		disp->stop = 1;
+		return EXIT_SUCCESS;
+	}
+	if(irq >= IRQ_DISPATCH_MAX || !sigismember(&disp->signals, disp->signal_offset + irq)) {
+		flink_error(FLINK_EINVALCHAN);
+		return EXIT_ERROR;
+	}
+	slot = &disp->slots[irq];
+
+	switch(op) {
+		case OP_ADD:
+			if(!slot_used(slot)) {
+				if(flink_register_irq(disp->dev, irq) < 0) return EXIT_ERROR;
+				memset(&slot->batch, 0, sizeof(slot->batch));
+				memset(&slot->stats, 0, sizeof(slot->stats));
+			}
+			slot->handler = add->handler;
+			slot->batch_handler = add->batch_handler;
+			slot->arg = add->arg;
+			slot->max_events = add->max_events;
+			slot->max_delay_ns = add->max_delay_ns;
+			return EXIT_SUCCESS;
+		case OP_REMOVE:
+			if(!slot_used(slot)) {
+				flink_error(FLINK_EINVALCHAN);
+				return EXIT_ERROR;
+			}
+			slot->handler = NULL;
+			slot->batch_handler = NULL;
+			slot->arg = NULL;
+			return flink_unregister_irq(disp->dev, irq);
+		case OP_GET_STATS:
+			get_stats(&slot->stats, arg);
+			return EXIT_SUCCESS;
+		default: // OP_RESET_STATS
+			memset(&slot->stats, 0, sizeof(slot->stats));
+			return EXIT_SUCCESS;
+	}
+}
+
+/**
+ * @brief Passes a request to the dispatcher thread and waits for its result.
+ *
+ * Handlers run in the dispatcher thread and execute their requests directly.
+ */
+static int request(flink_irq_dispatcher* disp, int op, uint32_t irq, void* arg) {
+	uint64_t wake = 1;
+	int ret, err;
+
+	if(pthread_equal(pthread_self(), disp->thread)) {
+		return execute(disp, op, irq, arg);
+	}
+
+	pthread_mutex_lock(&disp->lock);
+	while(disp->req_state != REQ_IDLE) pthread_cond_wait(&disp->cond, &disp->lock);
+	disp->req_op = op;
+	disp->req_irq = irq;
+	disp->req_arg = arg;
+	disp->req_state = REQ_PENDING;
+	if(write(disp->efd, &wake, sizeof(wake)) != sizeof(wake)) {
+		disp->req_state = REQ_IDLE;
+		pthread_mutex_unlock(&disp->lock);
+		libc_error();
+		return EXIT_ERROR;
+	}
+	while(disp->req_state != REQ_DONE) pthread_cond_wait(&disp->cond, &disp->lock);
+	ret = disp->req_result;
+	err = disp->req_error;
+	disp->req_state = REQ_IDLE;
+	pthread_cond_broadcast(&disp->cond);
+	pthread_mutex_unlock(&disp->lock);
+
+	if(ret < 0) flink_error(err);
+	return ret;
+}
+
+/**
+ * @brief Executes the pending request.
+ */
+static void serve_request(flink_irq_dispatcher* disp) {
+	uint64_t wake;
+
+	if(read(disp->efd, &wake, sizeof(wake)) != sizeof(wake)) return;
+	pthread_mutex_lock(&disp->lock);
+	if(disp->req_state == REQ_PENDING) {
+		disp->req_result = execute(disp, disp->req_op, disp->req_irq, disp->req_arg);
+		disp->req_error = flink_errno;
+		disp->req_state = REQ_DONE;
+		pthread_cond_broadcast(&disp->cond);
+	}
+	pthread_mutex_unlock(&disp->lock);
+}
+
+/**
+ * @brief Reads all pending interrupts into the batches of their IRQs.
+ */
+static void receive(flink_irq_dispatcher* disp, uint64_t received) {
+	struct signalfd_siginfo info[IRQ_READ_BATCH];
+	flink_irq_batch* batch;
+	uint32_t irq;
+	ssize_t size;
+	size_t k;
+
+	while((size = read(disp->sfd, info, sizeof(info))) > 0) {
+		for(k = 0; k < size / sizeof(info[0]); k++) {
+			irq = info[k].ssi_signo - disp->signal_offset;
+			if(irq >= IRQ_DISPATCH_MAX || !slot_used(&disp->slots[irq])) continue;
+			PROBE1(irq_receive, irq);
+			batch = &disp->slots[irq].batch;
+			if(batch->count == 0) batch->first_ns = received;
+			batch->last_ns = received;
+			batch->count++;
+		}
+	}
+}
+
+/**
+ * @brief Delivers the batches which are due to their handlers.
+ * @return uint64_t: Time the next batch is due, NO_DEADLINE if none is pending.
+ */
+static uint64_t deliver(flink_irq_dispatcher* disp, uint64_t now) {
+	uint64_t deadline = NO_DEADLINE, due, start, end;
+	flink_irq_slot* slot;
+	flink_irq_batch batch;
+	uint32_t irq;
+
+	for(irq = 0; irq < IRQ_DISPATCH_MAX; irq++) {
+		slot = &disp->slots[irq];
+		if(slot->batch.count == 0 || !slot_used(slot)) continue;
+		due = slot->max_delay_ns ? slot->batch.first_ns + slot->max_delay_ns : NO_DEADLINE;
+		if(slot->max_events || slot->max_delay_ns) {
+			if((slot->max_events == 0 || slot->batch.count < slot->max_events) && now < due) {
+				if(due < deadline) deadline = due;
+				continue;
+			}
+		}
+
+		batch = slot->batch;
+		batch.irq = irq;
+		memset(&slot->batch, 0, sizeof(slot->batch));
+		start = flink_now_ns();
+		PROBE3(irq_deliver_entry, irq, batch.count, start - batch.first_ns);
+		if(slot->batch_handler != NULL) slot->batch_handler(disp->dev, &batch, slot->arg);
+		else                            slot->handler(disp->dev, irq, batch.count, slot->arg);
+		end = flink_now_ns();
+		PROBE2(irq_deliver_return, irq, batch.count);
+		record(&slot->stats, batch.count, start - batch.first_ns, end - start);
+	}
+	return deadline;
+}
+
+/**
+ * @brief Dispatcher thread.
+ */
+static void* run(void* arg) {
+	flink_irq_dispatcher* disp = arg;
+	struct pollfd pfd[2];
+	struct timespec timeout;
+	uint64_t deadline = NO_DEADLINE, now;
+	uint32_t irq;
+	int ret;
+
+	pthread_sigmask(SIG_BLOCK, &disp->signals, NULL);
+	pfd[0].fd = disp->sfd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = disp->efd;
+	pfd[1].events = POLLIN;
+
+	while(!disp->stop) {
+		if(deadline != NO_DEADLINE) {
+			now = flink_now_ns();
+			now = deadline > now ? deadline - now : 0;
+			timeout.tv_sec = now / 1000000000ull;
+			timeout.tv_nsec = now % 1000000000ull;
+		}
+		ret = ppoll(pfd, 2, deadline != NO_DEADLINE ? &timeout : NULL, NULL);
+		now = flink_now_ns();
+		if(ret > 0 && (pfd[0].revents & POLLIN)) receive(disp, now);
+		if(ret > 0 && (pfd[1].revents & POLLIN)) serve_request(disp);
+		deadline = deliver(disp, now);
+	}
+
+	for(irq = 0; irq < IRQ_DISPATCH_MAX; irq++) {
+		if(slot_used(&disp->slots[irq])) flink_unregister_irq(disp->dev, irq);
+	}
+	return NULL;
+}
+
+static void free_dispatcher(flink_irq_dispatcher* disp) {
+	if(disp->sfd >= 0) close(disp->sfd);
+	if(disp->efd >= 0) close(disp->efd);
+	pthread_cond_destroy(&disp->cond);
+	pthread_mutex_destroy(&disp->lock);
+	free(disp);
+}
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Starts a thread dispatching the IRQs of a device to their handlers.
+ * @param dev: Flink device.
+ * @param cpu: CPU the thread is pinned to, -1 for no pinning.
+ * @param priority: SCHED_FIFO priority of the thread, 0 for the default scheduling.
+ * @return flink_irq_dispatcher*: Dispatcher or NULL in case of failure.
+ */
+flink_irq_dispatcher* flink_irq_dispatcher_start(flink_dev* dev, int cpu, int priority) {
+	flink_irq_dispatcher* disp;
+	uint32_t irq;
+
+	if(!validate_flink_dev(dev)) {
+		flink_error(FLINK_EINVALDEV);
+		return NULL;
+	}
+	disp = calloc(1, sizeof(flink_irq_dispatcher));
+	if(disp == NULL) {
+		libc_error();
+		return NULL;
+	}
+	disp->dev = dev;
+	disp->sfd = -1;
+	disp->efd = -1;
+	pthread_mutex_init(&disp->lock, NULL);
+	pthread_cond_init(&disp->cond, NULL);
+
+	if(flink_get_signal_offset(dev, &disp->signal_offset) != EXIT_SUCCESS) {
+		free_dispatcher(disp);
+		return NULL;
+	}
+	sigemptyset(&disp->signals);
+	for(irq = 0; irq < IRQ_DISPATCH_MAX && disp->signal_offset + irq <= (uint32_t)SIGRTMAX; irq++) {
+		sigaddset(&disp->signals, disp->signal_offset + irq);
+	}
+	disp->sfd = signalfd(-1, &disp->signals, SFD_NONBLOCK | SFD_CLOEXEC);
+	disp->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(disp->sfd < 0 || disp->efd < 0) {
+		libc_error();
+		free_dispatcher(disp);
+		return NULL;
+	}
+
+	if(flink_thread_start(&disp->thread, cpu, priority, run, disp) != EXIT_SUCCESS) {
+		free_dispatcher(disp);
+		return NULL;
+	}
+	dbg_print("  --> irq dispatcher started, signal offset %u\n", disp->signal_offset);
+	return disp;
+}
+
+/**
+ * @brief Registers an IRQ and its handler, or replaces the handler of a registered IRQ.
+ *
+ * The handler is called in the dispatcher thread with the nof interrupts of the IRQ
+ * read in one wake-up. It may add and remove handlers itself. Adding a handler to a 
+ * registered IRQ replaces its handler and coalescing.
+ *
+ * @param disp: Dispatcher.
+ * @param irq: IRQ number.
+ * @param handler: Function to call.
+ * @param arg: Argument passed to the handler.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_irq_dispatcher_add(flink_irq_dispatcher* disp, uint32_t irq, flink_irq_handler handler, void* arg) {
+	flink_irq_slot add = { 0 };
+
+	if(disp == NULL || handler == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	add.handler = handler;
+	add.arg = arg;
+	return request(disp, OP_ADD, irq, &add);
+}
+
+/**
+ * @brief Registers an IRQ whose interrupts are delivered in batches.
+ *
+ * A batch is delivered as soon as it contains max_events interrupts or max_delay_us after
+ * its first interrupt, whatever comes first. 0 disables a limit. Interrupts read in the
+ * same wake-up are delivered in the same batch. The latency in the 
+ * statistics of the IRQ includes the time the batch is held back.
+ *
+ * @param disp: Dispatcher.
+ * @param irq: IRQ number.
+ * @param max_events: Maximum nof interrupts in a batch, 0 for no limit.
+ * @param max_delay_us: Maximum age of a batch in us, 0 for no limit.
+ * @param handler: Function to call with the batch.
+ * @param arg: Argument passed to the handler.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_irq_dispatcher_add_coalesced(flink_irq_dispatcher* disp, uint32_t irq, uint32_t max_events, uint32_t max_delay_us,
+                                       flink_irq_batch_handler handler, void* arg) {
+	flink_irq_slot add = { 0 };
+
+	if(disp == NULL || handler == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	add.batch_handler = handler;
+	add.arg = arg;
+	add.max_events = max_events;
+	add.max_delay_ns = (uint64_t)max_delay_us * 1000;
+	return request(disp, OP_ADD, irq, &add);
+}
+
+/**
+ * @brief Unregisters an IRQ. The handler is not called anymore when the function returns.
+ * @param disp: Dispatcher.
+ * @param irq: IRQ number.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_irq_dispatcher_remove(flink_irq_dispatcher* disp, uint32_t irq) {
+	if(disp == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	return request(disp, OP_REMOVE, irq, NULL);
+}
+
+/**
+ * @brief Unregisters all IRQs and stops the dispatcher thread. Must not be called from a handler.
+ * @param disp: Dispatcher.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_irq_dispatcher_stop(flink_irq_dispatcher* disp) {
+	if(disp == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(pthread_equal(pthread_self(), disp->thread)) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	if(request(disp, OP_STOP, 0, NULL) != EXIT_SUCCESS) return EXIT_ERROR;
+	pthread_join(disp->thread, NULL);
+	free_dispatcher(disp);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Reads the statistics of an IRQ.
+ *
+ * The statistics are kept after the IRQ is removed and reset when it is added again.
+ *
+ * @param disp: Dispatcher.
+ * @param irq: IRQ number.
+ * @param stats: Contains the statistics.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_irq_dispatcher_get_stats(flink_irq_dispatcher* disp, uint32_t irq, flink_irq_stats* stats) {
+	if(disp == NULL || stats == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	return request(disp, OP_GET_STATS, irq, stats);
+}
+
+/**
+ * @brief Clears the statistics of an IRQ.
+ * @param disp: Dispatcher.
+ * @param irq: IRQ number.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_irq_dispatcher_reset_stats(flink_irq_dispatcher* disp, uint32_t irq) {
+	if(disp == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	return request(disp, OP_RESET_STATS, irq, NULL);
+}
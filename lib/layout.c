@@ -0,0 +1,86 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, register layout                       *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file layout.c
+ *  @brief Register layout of the subdevice functions.
+ *
+ *  The only place where the register maps of the functions are
+ *  calculated from the number of channels.
+ */
+
+#include "flinklib.h"
+#include "types.h"
+#include "layout.h"
+
+#define FUNC_OFFSET		(HEADER_SIZE + SUBHEADER_SIZE)
+#define NOF_STEPPER_REGS	8
+
+
+/**
+ * @brief Calculates the register layout of a subdevice from its function and number of channels.
+ * @param subdev: Subdevice with function and number of channels read from the device.
+ */
+void flink_layout_init(flink_subdev* subdev) {
+	uint32_t* layout = subdev->layout;
+	uint32_t n = subdev->nof_channels * REGISTER_WITH; // size of a group
+	int i;
+
+	for(i = 0; i < LAYOUT_SIZE; i++) layout[i] = FUNC_OFFSET;
+
+	switch(subdev->function_id) {
+		case GPIO_INTERFACE_ID:
+			layout[LAYOUT_DIO_DIRECTION] = FUNC_OFFSET + REGISTER_WITH;
+			layout[LAYOUT_DIO_VALUE]     = layout[LAYOUT_DIO_DIRECTION] + layout_bit_words(subdev) * REGISTER_WITH;
+			layout[LAYOUT_DIO_DEBOUNCE]  = layout[LAYOUT_DIO_VALUE] + layout_bit_words(subdev) * REGISTER_WITH;
+			break;
+		case PWM_INTERFACE_ID:
+			layout[LAYOUT_PERIOD]   = FUNC_OFFSET + PWM_FIRSTPWM_OFFSET;
+			layout[LAYOUT_HIGHTIME] = layout[LAYOUT_PERIOD] + n;
+			break;
+		case PPWA_INTERFACE_ID:
+			layout[LAYOUT_PERIOD]   = FUNC_OFFSET + PPWA_FIRSTPPWA_OFFSET;
+			layout[LAYOUT_HIGHTIME] = layout[LAYOUT_PERIOD] + n;
+			break;
+		case ANALOG_INPUT_INTERFACE_ID:
+			layout[LAYOUT_VALUE] = FUNC_OFFSET + ANALOG_INPUT_FIRST_VALUE_OFFSET;
+			break;
+		case ANALOG_OUTPUT_INTERFACE_ID:
+			layout[LAYOUT_VALUE] = FUNC_OFFSET + ANALOG_OUTPUT_FIRST_VALUE_OFFSET;
+			break;
+		case SENSOR_INTERFACE_ID:
+			layout[LAYOUT_VALUE]       = FUNC_OFFSET + REFLECTIVE_SENSOR_FIRST_VALUE_OFFSET;
+			layout[LAYOUT_UPPER_LEVEL] = layout[LAYOUT_VALUE] + n;
+			layout[LAYOUT_LOWER_LEVEL] = layout[LAYOUT_UPPER_LEVEL] + n;
+			break;
+		case COUNTER_INTERFACE_ID: // no constant, values start at the first register
+			layout[LAYOUT_VALUE] = FUNC_OFFSET;
+			break;
+		case WD_INTERFACE_ID:
+			layout[LAYOUT_WD_COUNTER] = FUNC_OFFSET + WD_FIRST_COUNTER_OFFSET;
+			break;
+		case STEPPER_MOTOR_INTERFACE_ID:
+			for(i = 0; i < NOF_STEPPER_REGS; i++) {
+				layout[LAYOUT_STEPPER + i] = FUNC_OFFSET + STEPPER_MOTOR_FIRST_CONF_OFFSET + i * n;
+			}
+			break;
+		case IRQ_MULTIPLEXER_INTERFACE_ID:
+			layout[LAYOUT_IRQ] = FUNC_OFFSET;
+			break;
+		case INFO_DEVICE_ID:
+			layout[LAYOUT_DESCRIPTION] = FUNC_OFFSET + REGISTER_WITH;
+			break;
+		default:
+			break;
+	}
+}
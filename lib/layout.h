@@ -0,0 +1,75 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, register layout                       *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file layout.h
+ *  @brief Register layout of the subdevice functions.
+ *
+ *  Every subdevice gets a table with the offset of each register group
+ *  of its function when the device is opened. A register group holds
+ *  one register per channel, or one bit per channel for the digital
+ *  I/O directions and values. The meaning of a group index depends on
+ *  the function.
+ */
+
+#ifndef FLINKLIB_LAYOUT_H_
+#define FLINKLIB_LAYOUT_H_
+
+#include "types.h"
+
+// All functions
+#define LAYOUT_CONSTANT			0	// base clock or resolution
+// Digital I/O
+#define LAYOUT_DIO_DIRECTION	1	// one bit per channel
+#define LAYOUT_DIO_VALUE		2	// one bit per channel
+#define LAYOUT_DIO_DEBOUNCE		3
+// PWM and PPWA
+#define LAYOUT_PERIOD			1
+#define LAYOUT_HIGHTIME			2
+// Analog input and output, counter, reflective sensor
+#define LAYOUT_VALUE			1
+#define LAYOUT_UPPER_LEVEL		2
+#define LAYOUT_LOWER_LEVEL		3
+// Watchdog
+#define LAYOUT_WD_COUNTER		1
+// Stepper motor, followed by one group per stepper register
+#define LAYOUT_STEPPER			1
+// Irq multiplexer
+#define LAYOUT_IRQ				1
+// Info
+#define LAYOUT_DESCRIPTION		1
+
+/**
+ * @brief Offset of the register of a channel.
+ */
+static inline uint32_t layout_reg(flink_subdev* subdev, int group, uint32_t channel) {
+	return subdev->layout[group] + channel * REGISTER_WITH;
+}
+
+/**
+ * @brief Offset of the register holding the bit of a channel.
+ */
+static inline uint32_t layout_bit_reg(flink_subdev* subdev, int group, uint32_t channel) {
+	return subdev->layout[group] + (channel / (REGISTER_WITH * 8)) * REGISTER_WITH;
+}
+
+/**
+ * @brief Number of registers of a group with one bit per channel.
+ */
+static inline uint32_t layout_bit_words(flink_subdev* subdev) {
+	return (subdev->nof_channels - 1) / (REGISTER_WITH * 8) + 1;
+}
+
+void flink_layout_init(flink_subdev* subdev);
+
+#endif // FLINKLIB_LAYOUT_H_
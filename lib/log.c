@@ -0,0 +1,266 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, logging                               *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file log.c
+ *  @brief Runtime configurable logging of errors and debug messages.
+ *
+ *  Messages up to the configured level are passed to a handler, by default
+ *  one printing to stderr. Threads which must not block, e.g. a control loop,
+ *  configure a ring instead: every thread appends its messages without lock
+ *  and one thread drains them with flink_log_read(). When the ring is full,
+ *  new messages are dropped and counted.
+ */
+
+#include "flinklib.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+typedef struct _log_slot {
+	uint64_t        seq;			/// Position the slot is free for (seq == pos) or filled at (seq == pos + 1)
+	flink_log_entry entry;
+} log_slot;
+
+typedef struct _log_ring {
+	uint32_t        mask;			/// Capacity - 1, the capacity is a power of two
+	uint64_t        tail;			/// Next position to read, by the reading thread only
+	log_slot*       slots;
+	uint64_t        head __attribute__((aligned(CACHE_LINE_SIZE)));	/// Next position to write
+} log_ring;
+
+int flink_log_level = FLINK_LOG_ERROR;
+
+static flink_log_handler log_handler = NULL;
+static void*             log_arg = NULL;
+static log_ring*         ring = NULL;
+static uint64_t          dropped = 0;
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Default handler, prints the message to stderr.
+ */
+static void print_entry(const flink_log_entry* entry, void* arg) {
+	(void)arg;
+	if(entry->level == FLINK_LOG_DEBUG) fprintf(stderr, "[flinklib] DEBUG: %s\n", entry->message);
+	else                                fprintf(stderr, "%s\n", entry->message);
+}
+
+/**
+ * @brief Claims the next free slot of the ring.
+ * @return log_slot*: Slot to fill, NULL if the ring is full.
+ */
+static log_slot* ring_claim(log_ring* r, uint64_t* pos) {
+	uint64_t p = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+	log_slot* slot;
+	int64_t diff;
+
+	for(;;) {
+		slot = &r->slots[p & r->mask];
+		diff = (int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - p);
+		if(diff == 0) {
+			if(__atomic_compare_exchange_n(&r->head, &p, p + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+		}
+		else if(diff < 0) { // the slot still holds the message of the previous round
+			return NULL;
+		}
+		else {
+			p = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+		}
+	}
+	*pos = p;
+	return slot;
+}
+
+/**
+ * @brief Formats a message into an entry, without trailing newline.
+ */
+static void format_entry(flink_log_entry* entry, int level, int error, const char* fmt, va_list args) {
+	size_t len;
+
+	entry->timestamp_ns = flink_now_ns();
+	entry->level = level;
+	entry->error = error;
+	vsnprintf(entry->message, sizeof(entry->message), fmt, args);
+	len = strlen(entry->message);
+	if(len > 0 && entry->message[len - 1] == '\n') entry->message[len - 1] = '\0';
+}
+
+/**
+ * @brief Logs a message, called by flink_error(), libc_error() and dbg_print.
+ * @param level: FLINK_LOG_ERROR or FLINK_LOG_DEBUG.
+ * @param error: Error code, 0 for debug messages.
+ * @param fmt: printf format of the message.
+ */
+void flink_log(int level, int error, const char* fmt, ...) {
+	log_ring* r = __atomic_load_n(&ring, __ATOMIC_ACQUIRE);
+	flink_log_handler handler;
+	flink_log_entry entry;
+	log_slot* slot;
+	uint64_t pos;
+	va_list args;
+
+	if(!flink_log_enabled(level)) return;
+	va_start(args, fmt);
+	if(r != NULL) {
+		slot = ring_claim(r, &pos);
+		if(slot == NULL) {
+			__atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+		}
+		else {
+			format_entry(&slot->entry, level, error, fmt, args);
+			__atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+		}
+	}
+	else {
+		format_entry(&entry, level, error, fmt, args);
+		handler = __atomic_load_n(&log_handler, __ATOMIC_ACQUIRE);
+		if(handler != NULL) handler(&entry, __atomic_load_n(&log_arg, __ATOMIC_RELAXED));
+		else                print_entry(&entry, NULL);
+	}
+	va_end(args);
+}
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Sets the level of the messages logged, for all devices and threads.
+ * @param level: FLINK_LOG_OFF, FLINK_LOG_ERROR (default) or FLINK_LOG_DEBUG.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_log_set_level(int level) {
+	if(level < FLINK_LOG_OFF || level > FLINK_LOG_DEBUG) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	__atomic_store_n(&flink_log_level, level, __ATOMIC_RELAXED);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Returns the level of the messages logged.
+ * @return int: FLINK_LOG_OFF, FLINK_LOG_ERROR or FLINK_LOG_DEBUG.
+ */
+int flink_log_get_level(void) {
+	return __atomic_load_n(&flink_log_level, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Sets the handler called with every message if no ring is configured.
+ *
+ * The handler is called in the thread of the failing call, it must be thread safe.
+ *
+ * @param handler: Called with each message, NULL to print to stderr (default).
+ * @param arg: Argument passed to the handler.
+ */
+void flink_log_set_handler(flink_log_handler handler, void* arg) {
+	__atomic_store_n(&log_arg, arg, __ATOMIC_RELAXED);
+	__atomic_store_n(&log_handler, handler, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Logs the messages into a ring instead of calling the handler.
+ *
+ * Logging into the ring takes no lock and makes no system call. The ring must
+ * be set up or removed while no other thread uses the library.
+ *
+ * @param capacity: Nof messages the ring holds, rounded up to a power of two. 0 removes the ring.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_log_set_ring(uint32_t capacity) {
+	log_ring* r = NULL;
+	uint32_t size = 1, i;
+
+	if(capacity > 0) {
+		if(capacity > (1u << 31)) {
+			flink_error(FLINK_ENOTSUPPORTED);
+			return EXIT_ERROR;
+		}
+		while(size < capacity) size <<= 1;
+		r = aligned_alloc(CACHE_LINE_SIZE, sizeof(log_ring));
+		if(r == NULL) {
+			libc_error();
+			return EXIT_ERROR;
+		}
+		memset(r, 0, sizeof(log_ring));
+		r->slots = calloc(size, sizeof(log_slot));
+		if(r->slots == NULL) {
+			libc_error();
+			free(r);
+			return EXIT_ERROR;
+		}
+		r->mask = size - 1;
+		for(i = 0; i < size; i++) r->slots[i].seq = i;
+	}
+	r = __atomic_exchange_n(&ring, r, __ATOMIC_ACQ_REL);
+	if(r != NULL) {
+		free(r->slots);
+		free(r);
+	}
+	__atomic_store_n(&dropped, 0, __ATOMIC_RELAXED);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Takes the oldest messages out of the ring. Only one thread may read.
+ * @param entries: Contains the messages, oldest first.
+ * @param max_entries: Nof entries the buffer holds.
+ * @return int: Nof messages read, 0 if the ring is empty, -1 in case of failure.
+ */
+int flink_log_read(flink_log_entry* entries, uint32_t max_entries) {
+	log_ring* r = __atomic_load_n(&ring, __ATOMIC_ACQUIRE);
+	log_slot* slot;
+	uint32_t n = 0;
+
+	if(entries == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(r == NULL) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	while(n < max_entries) {
+		slot = &r->slots[r->tail & r->mask];
+		if(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != r->tail + 1) break; // empty or being filled
+		entries[n++] = slot->entry;
+		__atomic_store_n(&slot->seq, r->tail + r->mask + 1, __ATOMIC_RELEASE);
+		r->tail++;
+	}
+	return n;
+}
+
+/**
+ * @brief Returns the nof messages dropped because the ring was full.
+ * @return uint64_t: Nof dropped messages since the ring was set up.
+ */
+uint64_t flink_log_get_dropped(void) {
+	return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
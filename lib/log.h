@@ -13,7 +13,10 @@
  *******************************************************************/
 
 /** @file log.h
- *  @brief Debug utilities.
+ *  @brief Logging of errors and debug messages.
+ *
+ *  The level is set at runtime with flink_log_set_level(). A disabled
+ *  dbg_print costs a relaxed load and a predicted branch.
  *
  *  @author Martin Züger
  */
@@ -21,11 +24,16 @@
 #ifndef FLINKLIB_LOGGING_H_
 #define FLINKLIB_LOGGING_H_
 
-#include <stdio.h>
+#include "flinklib.h"
+
+extern int flink_log_level;
+
+void flink_log(int level, int error, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
 
-#define PRINT_ERRORS_TO_STDERR 1
-#define DEBUG 0
+static inline int flink_log_enabled(int level) {
+	return __builtin_expect(__atomic_load_n(&flink_log_level, __ATOMIC_RELAXED) >= level, 0);
+}
 
-#define dbg_print(fmt, ...)      do { if(DEBUG) { printf("[flinklib] DEBUG: "); printf(fmt, ##__VA_ARGS__); } } while(0)
+#define dbg_print(fmt, ...)      do { if(flink_log_enabled(FLINK_LOG_DEBUG)) flink_log(FLINK_LOG_DEBUG, 0, fmt, ##__VA_ARGS__); } while(0)
 
 #endif // FLINKLIB_LOGGING_H_
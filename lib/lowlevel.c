@@ -24,14 +24,15 @@
  */
 
 #include "flinklib.h"
-#include "flinkioctl.h"
 #include "types.h"
 #include "error.h"
 #include "log.h"
 #include "valid.h"
-
-#include <sys/ioctl.h>
-#include <unistd.h>
+#include "backend.h"
+#include "cache.h"
+#include "lowlevel.h"
+#include "stats.h"
+#include "probe.h"
 
 
 /**
@@ -51,10 +52,11 @@ int flink_ioctl(flink_dev* dev, int cmd, void* arg) {
 		return EXIT_ERROR;
 	}
 	
-	ret = ioctl(dev->fd, cmd, arg);
-	if(ret < 0) {
-		libc_error();
-	}
+	PROBE1(ioctl_entry, cmd);
+	STATS_START(start);
+	ret = dev->backend->ioctl(dev, cmd, arg);
+	STATS_CALL(&dev->stats, ioctls, NULL, ret, start);
+	PROBE2(ioctl_return, cmd, ret);
 	
 	return ret;
 }
@@ -70,11 +72,6 @@ int flink_ioctl(flink_dev* dev, int cmd, void* arg) {
  */
 ssize_t flink_read(flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata) {
 	ssize_t read_size = 0;
-	ioctl_container_t ioctl_arg;
-	ioctl_arg.subdevice = subdev->id;
-	ioctl_arg.offset    = offset;
-	ioctl_arg.size      = size;
-	ioctl_arg.data      = rdata;
 	
 	// Check data pointer
 	if(rdata == NULL) {
@@ -89,9 +86,12 @@ ssize_t flink_read(flink_subdev* subdev, uint32_t offset, uint8_t size, void* rd
 	}
 
 	// read data from device
-	read_size = flink_ioctl(subdev->parent, SELECT_AND_READ, &ioctl_arg);
-	if(read_size == -1) {
-		libc_error();
+	PROBE3(read_entry, subdev->id, offset, size);
+	STATS_START(start);
+	read_size = subdev->parent->backend->read(subdev, offset, size, rdata);
+	STATS_CALL(&subdev->stats, reads, &subdev->stats.bytes_read, read_size, start);
+	PROBE4(read_return, subdev->id, offset, size, read_size);
+	if(read_size < 0) {
 		return EXIT_ERROR;
 	}
 	
@@ -109,11 +109,6 @@ ssize_t flink_read(flink_subdev* subdev, uint32_t offset, uint8_t size, void* rd
  */
 ssize_t flink_write(flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata) {
 	ssize_t write_size = 0;
-	ioctl_container_t ioctl_arg;
-	ioctl_arg.subdevice = subdev->id;
-	ioctl_arg.offset    = offset;
-	ioctl_arg.size      = size;
-	ioctl_arg.data      = wdata;
 	
 	// Check data pointer
 	if(wdata == NULL) {
@@ -127,10 +122,33 @@ ssize_t flink_write(flink_subdev* subdev, uint32_t offset, uint8_t size, void* w
 		return EXIT_ERROR;
 	}
 	
-	// write data to device
-	write_size = flink_ioctl(subdev->parent, SELECT_AND_WRITE, &ioctl_arg);
-	if(write_size == -1) {
-		libc_error();
+	// write uncached data to the device without locking
+	PROBE3(write_entry, subdev->id, offset, size);
+	STATS_START(start);
+	if(__atomic_load_n(&subdev->shadow, __ATOMIC_ACQUIRE) == NULL) {
+		write_size = subdev->parent->backend->write(subdev, offset, size, wdata);
+		STATS_CALL(&subdev->stats, writes, &subdev->stats.bytes_written, write_size, start);
+		PROBE4(write_return, subdev->id, offset, size, write_size);
+		if(write_size < 0) {
+			return EXIT_ERROR;
+		}
+		return write_size;
+	}
+	
+	// write data to the cache or the device, the cache is locked
+	pthread_mutex_lock(&subdev->lock);
+	write_size = flink_cache_write(subdev, offset, size, wdata);
+	if(write_size > 0) {
+		write_size = size;
+	}
+	else if(write_size == 0) {
+		write_size = subdev->parent->backend->write(subdev, offset, size, wdata);
+		if(write_size >= 0 && subdev->shadow) flink_cache_written(subdev, offset, size, wdata);
+	}
+	pthread_mutex_unlock(&subdev->lock);
+	STATS_CALL(&subdev->stats, writes, &subdev->stats.bytes_written, write_size, start);
+	PROBE4(write_return, subdev->id, offset, size, write_size);
+	if(write_size < 0) {
 		return EXIT_ERROR;
 	}
 	
@@ -147,10 +165,7 @@ ssize_t flink_write(flink_subdev* subdev, uint32_t offset, uint8_t size, void* w
  * @return int: 0 on succes, else -1.
  */
 int flink_read_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, void* rdata) {
-	ioctl_bit_container_t ioctl_arg;
-	ioctl_arg.offset    = offset;
-	ioctl_arg.bit       = bit;
-	ioctl_arg.subdevice = subdev->id;
+	int ret;
 	
 	// Check data pointer
 	if(rdata == NULL) {
@@ -165,14 +180,12 @@ int flink_read_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, void* rda
 	}
 	
 	// select subdevice and read data
-	if(flink_ioctl(subdev->parent, SELECT_AND_READ_BIT, &ioctl_arg) < 0) {
-		libc_error();
-		return EXIT_ERROR;
-	}
-	
-	*((uint8_t*)rdata) = ioctl_arg.value;
-	
-	return EXIT_SUCCESS;
+	PROBE3(read_bit_entry, subdev->id, offset, bit);
+	STATS_START(start);
+	ret = subdev->parent->backend->read_bit(subdev, offset, bit, rdata);
+	STATS_CALL(&subdev->stats, bit_reads, NULL, ret, start);
+	PROBE4(read_bit_return, subdev->id, offset, bit, ret);
+	return ret;
 }
 
 
@@ -185,11 +198,7 @@ int flink_read_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, void* rda
  * @return int
  */
 int flink_write_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, void* wdata) {
-	ioctl_bit_container_t ioctl_arg;
-	ioctl_arg.offset    = offset;
-	ioctl_arg.bit       = bit;
-	ioctl_arg.value     = *((uint8_t*)wdata);
-	ioctl_arg.subdevice = subdev->id;
+	int ret;
 	
 	// Check data pointer
 	if(wdata == NULL) {
@@ -203,11 +212,111 @@ int flink_write_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, void* wd
 		return EXIT_ERROR;
 	}
 	
-	// select subdevice and write data
-	if(flink_ioctl(subdev->parent, SELECT_AND_WRITE_BIT, &ioctl_arg) < 0) {
-		libc_error();
+	// bit writes are read-modify-write, they are serialized per subdevice
+	PROBE4(write_bit_entry, subdev->id, offset, bit, *((uint8_t*)wdata));
+	STATS_START(start);
+	pthread_mutex_lock(&subdev->lock);
+	ret = 0;
+	if(subdev->shadow) ret = flink_cache_write_bit(subdev, offset, bit, *((uint8_t*)wdata));
+	if(ret == 0) {
+		ret = subdev->parent->backend->write_bit(subdev, offset, bit, *((uint8_t*)wdata));
+		if(ret == EXIT_SUCCESS && subdev->shadow) flink_cache_written(subdev, offset, 0, NULL);
+	}
+	pthread_mutex_unlock(&subdev->lock);
+	STATS_CALL(&subdev->stats, bit_writes, NULL, ret, start);
+	PROBE4(write_bit_return, subdev->id, offset, bit, ret);
+	if(ret < 0) {
+		return EXIT_ERROR;
+	}
+	return EXIT_SUCCESS;
+}
+
+
+/**
+ * @brief Updates the bits selected by masks in consecutive registers of a flink subdevice.
+ *
+ * The registers are read and written back like a bit write, serialized with the
+ * bit writes of the subdevice. Registers of a cached subdevice are updated in the cache.
+ *
+ * @param subdev: Subdevice to write to.
+ * @param offset: Offset of the first register, relative to the subdevice base address.
+ * @param count: Nof registers, at most UINT8_MAX / REGISTER_WITH.
+ * @param values: New values of the registers.
+ * @param masks: Bits to update in the registers.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_write_masked(flink_subdev* subdev, uint32_t offset, uint32_t count, const uint32_t* values, const uint32_t* masks) {
+	uint32_t words[UINT8_MAX / REGISTER_WITH];
+	uint8_t size = count * REGISTER_WITH;
+	ssize_t n;
+	uint32_t i;
+	int ret;
+	
+	if(values == NULL || masks == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(!validate_flink_subdev(subdev)) {
+		flink_error(FLINK_EINVALDEV);
+		return EXIT_ERROR;
+	}
+	if(count > UINT8_MAX / REGISTER_WITH) {
+		flink_error(FLINK_EINVALOFFS);
 		return EXIT_ERROR;
 	}
 	
+	pthread_mutex_lock(&subdev->lock);
+	ret = 0;
+	if(subdev->shadow) ret = flink_cache_write_masked(subdev, offset, count, values, masks);
+	if(ret == 0) {
+		PROBE3(read_entry, subdev->id, offset, size);
+		STATS_START(read_start);
+		n = subdev->parent->backend->read(subdev, offset, size, words);
+		STATS_CALL(&subdev->stats, reads, &subdev->stats.bytes_read, n, read_start);
+		PROBE4(read_return, subdev->id, offset, size, n);
+		if(n == size) {
+			for(i = 0; i < count; i++) words[i] = (words[i] & ~masks[i]) | (values[i] & masks[i]);
+			PROBE3(write_entry, subdev->id, offset, size);
+			STATS_START(write_start);
+			n = subdev->parent->backend->write(subdev, offset, size, words);
+			STATS_CALL(&subdev->stats, writes, &subdev->stats.bytes_written, n, write_start);
+			PROBE4(write_return, subdev->id, offset, size, n);
+			if(n == size && subdev->shadow) flink_cache_written(subdev, offset, size, words);
+		}
+		ret = n == size ? EXIT_SUCCESS : EXIT_ERROR;
+	}
+	pthread_mutex_unlock(&subdev->lock);
+	return ret < 0 ? EXIT_ERROR : EXIT_SUCCESS;
+}
+
+
+/**
+ * @brief Prepares a handle for the unchecked accessors flink_fast_read32() and flink_fast_write32().
+ *
+ * The subdevice is validated once here. The accessors read and write the mapped
+ * registers directly or call the backend without any check, so they bypass the
+ * shadow register cache and a cached subdevice is refused.
+ *
+ * @param subdev: Subdevice to access.
+ * @param fast: Handle to fill in.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_fast_open(flink_subdev* subdev, flink_fast_subdev* fast) {
+	if(fast == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(subdev == NULL || !validate_flink_subdev(subdev)) {
+		flink_error(FLINK_EINVALSUBDEV);
+		return EXIT_ERROR;
+	}
+	if(__atomic_load_n(&subdev->shadow, __ATOMIC_ACQUIRE) != NULL) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	fast->regs   = subdev->regs;
+	fast->subdev = subdev;
+	fast->read   = subdev->parent->backend->read;
+	fast->write  = subdev->parent->backend->write;
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,26 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, low-level access                      *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file lowlevel.h
+ *  @brief Low-level operations used within the library.
+ */
+
+#ifndef FLINKLIB_LOWLEVEL_H_
+#define FLINKLIB_LOWLEVEL_H_
+
+#include "types.h"
+
+int flink_write_masked(flink_subdev* subdev, uint32_t offset, uint32_t count, const uint32_t* values, const uint32_t* masks);
+
+#endif // FLINKLIB_LOWLEVEL_H_
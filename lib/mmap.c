@@ -0,0 +1,425 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, memory mapped register access         *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file mmap.c
+ *  @brief Backend with memory mapped register access.
+ *
+ *  Maps the memory of a flink device into the address space of the
+ *  process. Registers of mapped subdevices are then read and written
+ *  with plain volatile loads and stores instead of one ioctl per access.
+ *  Subdevices which are not covered by the mapping, or all of them if
+ *  the driver refuses the mapping, are accessed through ioctl.
+ *
+ *  A regular file can be used in place of the device file. It is then
+ *  treated as an image of the device memory and the subdevices are
+ *  found by scanning the headers, the same way the driver does.
+ */
+
+#include "flinklib.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "backend.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TYPE_OFFSET			0x0000	// byte
+#define MEM_SIZE_OFFSET		0x0004	// byte
+#define NOF_CHANNELS_OFFSET	0x0008	// byte
+#define UNIQUE_ID_OFFSET	0x000C	// byte
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+static inline uint32_t map_read32(volatile uint8_t* addr) {
+	return *((volatile uint32_t*)addr);
+}
+
+static inline void map_write32(volatile uint8_t* addr, uint32_t value) {
+	*((volatile uint32_t*)addr) = value;
+}
+
+/**
+ * @brief Checks if an access lies within the address space of a subdevice.
+ * @param subdev: Subdevice to access.
+ * @param offset: Offset relative to the subdevice base address.
+ * @param size: Nof bytes to access.
+ * @return int: 1 if valid, 0 if not valid.
+ */
+static int check_range(flink_subdev* subdev, uint32_t offset, uint32_t size) {
+	if((uint64_t)offset + size > subdev->mem_size) {
+		flink_error(FLINK_EINVALOFFS);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief Maps a file into memory.
+ * @param dev: Device the file belongs to.
+ * @param size: Nof bytes to map.
+ * @return int: 0 on success, -1 if the mapping was refused.
+ */
+static int map_file(flink_dev* dev, size_t size) {
+	void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, dev->fd, 0);
+	if(map == MAP_FAILED) {
+		dbg_print("mapping device memory failed: %s\n", strerror(errno));
+		return EXIT_ERROR;
+	}
+	dev->map = map;
+	dev->map_size = size;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Assigns the register window to all subdevices lying in the mapping.
+ * @param dev: Mapped device.
+ */
+static void assign_windows(flink_dev* dev) {
+	flink_subdev* subdev;
+	int i;
+
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		subdev = dev->subdevices + i;
+		if((uint64_t)subdev->base_addr + subdev->mem_size <= dev->map_size) {
+			subdev->regs = (volatile uint8_t*)dev->map + subdev->base_addr;
+		}
+		else {
+			subdev->regs = NULL; // not covered, keep using ioctl
+		}
+		dbg_print("  --> subdevice %u mapped: %s\n", subdev->id, subdev->regs ? "yes" : "no");
+	}
+}
+
+/**
+ * @brief Counts the subdevice headers in a mapped image.
+ * @param dev: Mapped device.
+ * @return int: Nof subdevices found.
+ */
+static int count_headers(flink_dev* dev) {
+	volatile uint8_t* map = dev->map;
+	size_t addr = 0;
+	uint32_t mem_size;
+	int n = 0;
+
+	while(addr + HEADER_SIZE + SUBHEADER_SIZE <= dev->map_size && n < UINT8_MAX) {
+		mem_size = map_read32(map + addr + MEM_SIZE_OFFSET);
+		if(mem_size < HEADER_SIZE + SUBHEADER_SIZE || mem_size > dev->map_size - addr) break;
+		addr += mem_size;
+		n++;
+	}
+	return n;
+}
+
+/**
+ * @brief Removes the mapping of a device, if any.
+ * @param dev: Mapped device.
+ */
+static void unmap_device(flink_dev* dev) {
+	int i;
+
+	if(dev->map == NULL) return;
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		dev->subdevices[i].regs = NULL;
+	}
+	munmap(dev->map, dev->map_size);
+	dev->map = NULL;
+	dev->map_size = 0;
+}
+
+/**
+ * @brief Maps the memory of all subdevices of an opened flink device.
+ *
+ * The subdevices have to be read before.
+ *
+ * @param dev: Device to map.
+ * @return int: 0 on success, -1 if the mapping was refused.
+ */
+static int map_device(flink_dev* dev) {
+	long page_size = sysconf(_SC_PAGESIZE);
+	uint64_t end, size = 0;
+	int i;
+
+	dbg_print("mapping device memory...\n");
+
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		end = (uint64_t)dev->subdevices[i].base_addr + dev->subdevices[i].mem_size;
+		if(end > size) size = end;
+	}
+	if(size == 0) return EXIT_ERROR;
+	size = (size + page_size - 1) / page_size * page_size;
+
+	if(map_file(dev, size) < 0) return EXIT_ERROR;
+	assign_windows(dev);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Maps a device image file and counts the subdevice headers.
+ * @param dev: Device with an opened regular file.
+ * @return int: Nof subdevices found, or -1 in case of error.
+ */
+static int image_count(flink_dev* dev) {
+	struct stat st;
+	int n;
+
+	dbg_print("mapping device image...\n");
+
+	if(fstat(dev->fd, &st) < 0) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+	if(st.st_size < HEADER_SIZE + SUBHEADER_SIZE) {
+		flink_error(FLINK_EINVALDEV);
+		return EXIT_ERROR;
+	}
+	if(map_file(dev, st.st_size) < 0) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+
+	n = count_headers(dev);
+	if(n == 0) {
+		unmap_device(dev);
+		flink_error(FLINK_EINVALDEV);
+		return EXIT_ERROR;
+	}
+	dbg_print("  --> %d subdevices found\n", n);
+	return n;
+}
+
+/**
+ * @brief Reads the subdevices from the headers of a mapped image.
+ * @param dev: Device with a mapped image.
+ * @return int: Nof subdevices read.
+ */
+static int image_enumerate(flink_dev* dev) {
+	volatile uint8_t* hdr;
+	flink_subdev* subdev;
+	uint32_t type, addr = 0;
+	int i;
+
+	for(i = 0; i < dev->nof_subdevices; i++) { // for each subdevice
+		subdev = dev->subdevices + i;
+		hdr = (volatile uint8_t*)dev->map + addr;
+		type = map_read32(hdr + TYPE_OFFSET);
+		subdev->id               = i;
+		subdev->function_id      = (uint16_t)(type >> 16);
+		subdev->sub_function_id  = (uint8_t)(type >> 8);
+		subdev->function_version = (uint8_t)type;
+		subdev->base_addr        = addr;
+		subdev->mem_size         = map_read32(hdr + MEM_SIZE_OFFSET);
+		subdev->nof_channels     = map_read32(hdr + NOF_CHANNELS_OFFSET);
+		subdev->unique_id        = map_read32(hdr + UNIQUE_ID_OFFSET);
+		subdev->parent           = dev;
+		addr += subdev->mem_size;
+	}
+
+	assign_windows(dev);
+	return i;
+}
+
+/**
+ * @brief Read from a flink subdevice, directly if it is mapped.
+ * @param subdev: Subdevice to read from.
+ * @param offset: Read offset, relative to the subdevice base address.
+ * @param size: Nof bytes to read.
+ * @param rdata: Pointer to a buffer where the read bytes are written to.
+ * @return ssize_t: Nof bytes read or -1 in case of error.
+ */
+static ssize_t mmap_read(flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata) {
+	volatile uint8_t* src;
+	uint8_t* dst = rdata;
+	uint32_t value;
+	uint16_t half;
+	int i;
+
+	if(subdev->regs == NULL) return flink_ioctl_backend.read(subdev, offset, size, rdata);
+	if(!check_range(subdev, offset, size)) return EXIT_ERROR;
+	src = subdev->regs + offset;
+
+	if(size % REGISTER_WITH == 0 && offset % REGISTER_WITH == 0) {
+		for(i = 0; i < size; i += REGISTER_WITH) {
+			value = map_read32(src + i);
+			memcpy(dst + i, &value, REGISTER_WITH);
+		}
+	}
+	else if(size == 2 && offset % 2 == 0) {
+		half = *((volatile uint16_t*)src);
+		memcpy(dst, &half, 2);
+	}
+	else {
+		for(i = 0; i < size; i++) {
+			dst[i] = src[i];
+		}
+	}
+	return size;
+}
+
+/**
+ * @brief Write to a flink subdevice, directly if it is mapped.
+ * @param subdev: Subdevice to write to.
+ * @param offset: Write offset, relative to the subdevice base address.
+ * @param size: Nof bytes to write.
+ * @param wdata: Data to write.
+ * @return ssize_t: Nof bytes written or -1 in case of error.
+ */
+static ssize_t mmap_write(flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata) {
+	volatile uint8_t* dst;
+	uint8_t* src = wdata;
+	uint32_t value;
+	uint16_t half;
+	int i;
+
+	if(subdev->regs == NULL) return flink_ioctl_backend.write(subdev, offset, size, wdata);
+	if(!check_range(subdev, offset, size)) return EXIT_ERROR;
+	dst = subdev->regs + offset;
+
+	if(size % REGISTER_WITH == 0 && offset % REGISTER_WITH == 0) {
+		for(i = 0; i < size; i += REGISTER_WITH) {
+			memcpy(&value, src + i, REGISTER_WITH);
+			map_write32(dst + i, value);
+		}
+	}
+	else if(size == 2 && offset % 2 == 0) {
+		memcpy(&half, src, 2);
+		*((volatile uint16_t*)dst) = half;
+	}
+	else {
+		for(i = 0; i < size; i++) {
+			dst[i] = src[i];
+		}
+	}
+	return size;
+}
+
+/**
+ * @brief Read a single bit of a register, directly if the subdevice is mapped.
+ * @param subdev: Subdevice to read from.
+ * @param offset: Offset of the register, relative to the subdevice base address.
+ * @param bit: Bit number in the register.
+ * @param value: Contains the bit read.
+ * @return int: 0 on success, else -1.
+ */
+static int mmap_read_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t* value) {
+	if(subdev->regs == NULL) return flink_ioctl_backend.read_bit(subdev, offset, bit, value);
+	if(bit >= REGISTER_WITH * 8 || offset % REGISTER_WITH != 0) {
+		flink_error(FLINK_EINVALOFFS);
+		return EXIT_ERROR;
+	}
+	if(!check_range(subdev, offset, REGISTER_WITH)) return EXIT_ERROR;
+	*value = (map_read32(subdev->regs + offset) >> bit) & 0x1;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Write a single bit of a register, directly if the subdevice is mapped.
+ * @param subdev: Subdevice to write to.
+ * @param offset: Offset of the register, relative to the subdevice base address.
+ * @param bit: Bit number in the register.
+ * @param value: A value of nonzero sets the bit, 0 clears the bit.
+ * @return int: 0 on success, else -1.
+ */
+static int mmap_write_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t value) {
+	uint32_t reg;
+
+	if(subdev->regs == NULL) return flink_ioctl_backend.write_bit(subdev, offset, bit, value);
+	if(bit >= REGISTER_WITH * 8 || offset % REGISTER_WITH != 0) {
+		flink_error(FLINK_EINVALOFFS);
+		return EXIT_ERROR;
+	}
+	if(!check_range(subdev, offset, REGISTER_WITH)) return EXIT_ERROR;
+	reg = map_read32(subdev->regs + offset);
+	if(value) reg |= (1u << bit);
+	else      reg &= ~(1u << bit);
+	map_write32(subdev->regs + offset, reg);
+	return EXIT_SUCCESS;
+}
+
+static const flink_backend image_backend;
+
+/**
+ * @brief Opens a device file, or a regular file as image of the device memory.
+ * @param dev: Device to open.
+ * @param path: Device or image file.
+ * @return int: 0 on success, -1 in case of error.
+ */
+static int mmap_open(flink_dev* dev, const char* path) {
+	struct stat st;
+
+	if(flink_ioctl_backend.open(dev, path) < 0) return EXIT_ERROR;
+	if(fstat(dev->fd, &st) == 0 && S_ISREG(st.st_mode)) {
+		dbg_print("%s is a regular file, using it as device image\n", path);
+		dev->backend = &image_backend;
+	}
+	return EXIT_SUCCESS;
+}
+
+static int mmap_ioctl(flink_dev* dev, int cmd, void* arg) {
+	return flink_ioctl_backend.ioctl(dev, cmd, arg);
+}
+
+static int mmap_close(flink_dev* dev) {
+	unmap_device(dev);
+	return close(dev->fd);
+}
+
+/**
+ * @brief Reads the subdevices through the driver and maps their memory.
+ * @param dev: Device to enumerate.
+ * @return int: Nof subdevices, or -1 in case of error.
+ */
+static int mmap_enumerate(flink_dev* dev) {
+	int n = flink_ioctl_enumerate(dev);
+	if(n >= 0 && map_device(dev) < 0) {
+		dbg_print("  --> mapping refused, falling back to ioctl access\n");
+	}
+	return n;
+}
+
+const flink_backend flink_mmap_backend = {
+	.scheme    = "mmap",
+	.open      = mmap_open,
+	.close     = mmap_close,
+	.count     = flink_ioctl_count,
+	.enumerate = mmap_enumerate,
+	.ioctl     = mmap_ioctl,
+	.read      = mmap_read,
+	.write     = mmap_write,
+	.read_bit  = mmap_read_bit,
+	.write_bit = mmap_write_bit,
+};
+
+static const flink_backend image_backend = {
+	.scheme    = "mmap",
+	.open      = mmap_open,
+	.close     = mmap_close,
+	.count     = image_count,
+	.enumerate = image_enumerate,
+	.ioctl     = flink_emulate_ioctl,
+	.read      = mmap_read,
+	.write     = mmap_write,
+	.read_bit  = mmap_read_bit,
+	.write_bit = mmap_write_bit,
+};
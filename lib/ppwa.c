@@ -25,6 +25,8 @@
 #include "types.h"
 #include "error.h"
 #include "log.h"
+#include "cache.h"
+#include "layout.h"
 
 /**
  * @brief Reads the base clock of a PPWA subdevice
@@ -37,10 +39,10 @@ int flink_ppwa_get_baseclock(flink_subdev* subdev, uint32_t* frequency) {
 	
 	dbg_print("Reading base clock from PPWA subdevice %d\n", subdev->id);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE;
+	offset = subdev->layout[LAYOUT_CONSTANT];
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
-	if(flink_read(subdev, offset, REGISTER_WITH, frequency) != REGISTER_WITH) {
+	if(flink_cache_read_constant(subdev, offset, frequency) < 0) {
 		libc_error();
 		return EXIT_ERROR;
 	}
@@ -59,7 +61,7 @@ int flink_ppwa_get_period(flink_subdev* subdev, uint32_t channel, uint32_t* peri
 	
 	dbg_print("Reading PPWA period for channel %d on subdevice %d\n", subdev->id, channel);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + PPWA_FIRSTPPWA_OFFSET + REGISTER_WITH * channel;
+	offset = layout_reg(subdev, LAYOUT_PERIOD, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_read(subdev, offset, REGISTER_WITH, period) != REGISTER_WITH) {
@@ -81,7 +83,7 @@ int flink_ppwa_get_hightime(flink_subdev* subdev, uint32_t channel, uint32_t* hi
 		
 	dbg_print("Reading PPWA hightime for channel %d on subdevice %d\n", subdev->id, channel);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + PPWA_FIRSTPPWA_OFFSET + subdev->nof_channels * REGISTER_WITH + REGISTER_WITH * channel;
+	offset = layout_reg(subdev, LAYOUT_HIGHTIME, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_read(subdev, offset, REGISTER_WITH, hightime) != REGISTER_WITH) {
@@ -0,0 +1,45 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, static probes                         *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file probe.h
+ *  @brief Static probes (USDT) on the I/O and interrupt paths for perf, bpftrace or SystemTap.
+ *
+ *  With FLINK_PROBES the probes are placed with <sys/sdt.h>: a probe is a single
+ *  nop in the code and a note in the ELF file, a tracer attached to it replaces
+ *  the nop. All probes belong to the provider "flink". Without FLINK_PROBES the
+ *  macros expand to nothing.
+ */
+
+#ifndef FLINKLIB_PROBE_H_
+#define FLINKLIB_PROBE_H_
+
+#ifdef FLINK_PROBES
+
+#include <sys/sdt.h>
+
+#define PROBE1(name, a)                DTRACE_PROBE1(flink, name, a)
+#define PROBE2(name, a, b)             DTRACE_PROBE2(flink, name, a, b)
+#define PROBE3(name, a, b, c)          DTRACE_PROBE3(flink, name, a, b, c)
+#define PROBE4(name, a, b, c, d)       DTRACE_PROBE4(flink, name, a, b, c, d)
+
+#else
+
+#define PROBE1(name, a)                do { } while(0)
+#define PROBE2(name, a, b)             do { } while(0)
+#define PROBE3(name, a, b, c)          do { } while(0)
+#define PROBE4(name, a, b, c, d)       do { } while(0)
+
+#endif // FLINK_PROBES
+
+#endif // FLINKLIB_PROBE_H_
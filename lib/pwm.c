@@ -25,6 +25,8 @@
 #include "types.h"
 #include "error.h"
 #include "log.h"
+#include "cache.h"
+#include "layout.h"
 
 /**
  * @brief Reads the base clock of a PWM subdevice
@@ -37,10 +39,10 @@ int flink_pwm_get_baseclock(flink_subdev* subdev, uint32_t* frequency) {
 	
 	dbg_print("Reading base clock from PWM subdevice %d\n", subdev->id);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE;
+	offset = subdev->layout[LAYOUT_CONSTANT];
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
-	if(flink_read(subdev, offset, REGISTER_WITH, frequency) != REGISTER_WITH) {
+	if(flink_cache_read_constant(subdev, offset, frequency) < 0) {
 		libc_error();
 		return EXIT_ERROR;
 	}
@@ -59,7 +61,7 @@ int flink_pwm_set_period(flink_subdev* subdev, uint32_t channel, uint32_t period
 	
 	dbg_print("Setting PWM period for channel %d on subdevice %d\n", subdev->id, channel);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + PWM_FIRSTPWM_OFFSET + REGISTER_WITH * channel;
+	offset = layout_reg(subdev, LAYOUT_PERIOD, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_write(subdev, offset, REGISTER_WITH, &period) != REGISTER_WITH) {
@@ -82,7 +84,7 @@ int flink_pwm_get_period(flink_subdev* subdev, uint32_t channel, uint32_t* perio
 		
 	dbg_print("Reading period value from pwm %d of subdevice %d\n", channel, subdev->id);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + PWM_FIRSTPWM_OFFSET + REGISTER_WITH * channel;
+	offset = layout_reg(subdev, LAYOUT_PERIOD, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_read(subdev, offset, REGISTER_WITH, period) != REGISTER_WITH) {
@@ -106,7 +108,7 @@ int flink_pwm_set_hightime(flink_subdev* subdev, uint32_t channel, uint32_t high
 		
 	dbg_print("Setting PWM hight time for channel %d on subdevice %d\n", subdev->id, channel);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + PWM_FIRSTPWM_OFFSET + subdev->nof_channels * REGISTER_WITH + REGISTER_WITH * channel;
+	offset = layout_reg(subdev, LAYOUT_HIGHTIME, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_write(subdev, offset, REGISTER_WITH, &hightime) != REGISTER_WITH) {
@@ -128,7 +130,7 @@ int flink_pwm_get_hightime(flink_subdev* subdev, uint32_t channel, uint32_t* hig
 		
 	dbg_print("Reading hightime value from pwm %d of subdevice %d\n", channel, subdev->id);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + PWM_FIRSTPWM_OFFSET + subdev->nof_channels * REGISTER_WITH + REGISTER_WITH * channel;
+	offset = layout_reg(subdev, LAYOUT_HIGHTIME, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_read(subdev, offset, REGISTER_WITH, hightime) != REGISTER_WITH) {
@@ -29,6 +29,8 @@
 #include "types.h"
 #include "error.h"
 #include "log.h"
+#include "cache.h"
+#include "layout.h"
 
 #include <stdint.h>
 
@@ -40,9 +42,9 @@
  */
 int flink_reflectivesensor_get_resolution(flink_subdev* subdev, uint32_t* resolution){
 	uint32_t offset;
-	offset = HEADER_SIZE + SUBHEADER_SIZE;
+	offset = subdev->layout[LAYOUT_CONSTANT];
 	
-	if(flink_read(subdev, offset, REGISTER_WITH, resolution) != REGISTER_WITH) {
+	if(flink_cache_read_constant(subdev, offset, resolution) < 0) {
 		libc_error();
 		return EXIT_ERROR;
 	}
@@ -60,7 +62,7 @@ int flink_reflectivesensor_get_value(flink_subdev* subdev, uint32_t channel, uin
 	uint32_t offset;
 
 	dbg_print("Get value of sensor input for channel %d on subdevice %d\n", subdev->id, channel);
-	offset = HEADER_SIZE + SUBHEADER_SIZE + REFLECTIVE_SENSOR_FIRST_VALUE_OFFSET + channel*REGISTER_WITH;
+	offset = layout_reg(subdev, LAYOUT_VALUE, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 
 	if(flink_read(subdev, offset, REGISTER_WITH, value) != REGISTER_WITH) {
@@ -81,8 +83,7 @@ int flink_reflectivesensor_set_upper_level_int(flink_subdev* subdev, uint32_t ch
 	uint32_t offset;
 
 	dbg_print("Set value of sensor input for channel %d on subdevice %d\n", subdev->id, channel);
-	offset = HEADER_SIZE + SUBHEADER_SIZE + REFLECTIVE_SENSOR_FIRST_VALUE_OFFSET + REGISTER_WITH*subdev->nof_channels;
-	offset += channel*REGISTER_WITH;
+	offset = layout_reg(subdev, LAYOUT_UPPER_LEVEL, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 
 	if(flink_write(subdev, offset, REGISTER_WITH, &value) != REGISTER_WITH) {
@@ -103,8 +104,7 @@ int flink_reflectivesensor_get_upper_level_int(flink_subdev* subdev, uint32_t ch
 	uint32_t offset;
 
 	dbg_print("Get value of sensor input for channel %d on subdevice %d\n", subdev->id, channel);
-	offset = HEADER_SIZE + SUBHEADER_SIZE + REFLECTIVE_SENSOR_FIRST_VALUE_OFFSET + REGISTER_WITH*subdev->nof_channels;
-	offset += channel*REGISTER_WITH;
+	offset = layout_reg(subdev, LAYOUT_UPPER_LEVEL, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 
 	if(flink_read(subdev, offset, REGISTER_WITH, value) != REGISTER_WITH) {
@@ -125,8 +125,7 @@ int flink_reflectivesensor_set_lower_level_int(flink_subdev* subdev, uint32_t ch
 	uint32_t offset;
 
 	dbg_print("Set value of sensor input for channel %d on subdevice %d\n", subdev->id, channel);
-	offset = HEADER_SIZE + SUBHEADER_SIZE + REFLECTIVE_SENSOR_FIRST_VALUE_OFFSET + 2*REGISTER_WITH*subdev->nof_channels;
-	offset += channel*REGISTER_WITH;
+	offset = layout_reg(subdev, LAYOUT_LOWER_LEVEL, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 
 	if(flink_write(subdev, offset, REGISTER_WITH, &value) != REGISTER_WITH) {
@@ -147,8 +146,7 @@ int flink_reflectivesensor_get_lower_level_int(flink_subdev* subdev, uint32_t ch
 	uint32_t offset;
 
 	dbg_print("Get value of sensor input for channel %d on subdevice %d\n", subdev->id, channel);
-	offset = HEADER_SIZE + SUBHEADER_SIZE + REFLECTIVE_SENSOR_FIRST_VALUE_OFFSET + 2*REGISTER_WITH*subdev->nof_channels;
-	offset += channel*REGISTER_WITH;
+	offset = layout_reg(subdev, LAYOUT_LOWER_LEVEL, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 
 	if(flink_read(subdev, offset, REGISTER_WITH, value) != REGISTER_WITH) {
@@ -0,0 +1,332 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, sampler                               *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file sampler.c
+ *  @brief Background sampling of input channels.
+ *
+ *  A sampler reads a set of registers at a fixed period on its own thread
+ *  and publishes every frame with the time its reads started into a ring.
+ *  The ring has a single producer, the sampling thread, and a single
+ *  consumer: each side owns its index and reads the other one with
+ *  acquire semantics, so neither side locks or calls the kernel. A frame
+ *  finding the ring full is dropped and counted, the sampler never waits
+ *  for the consumer.
+ */
+
+#include "flinklib.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "valid.h"
+#include "layout.h"
+#include "thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+static inline void count(uint64_t* counter, uint64_t n) {
+	__atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Publishes the current frame, drops it if the ring is full.
+ */
+static void publish(flink_sampler* smp, uint64_t timestamp) {
+	uint64_t head = smp->head;
+	uint64_t tail = __atomic_load_n(&smp->tail, __ATOMIC_ACQUIRE);
+	uint32_t slot;
+
+	if(head - tail == smp->capacity) {
+		count(&smp->stats.dropped, 1);
+		return;
+	}
+	slot = head & (smp->capacity - 1);
+	smp->timestamps[slot] = timestamp;
+	memcpy(smp->values + (size_t)slot * smp->nof_channels, smp->frame, smp->nof_channels * sizeof(uint32_t));
+	__atomic_store_n(&smp->head, head + 1, __ATOMIC_RELEASE);
+	count(&smp->stats.frames, 1);
+}
+
+/**
+ * @brief Sampling thread.
+ */
+static void* run_sampler(void* arg) {
+	flink_sampler* smp = arg;
+	uint64_t release, start, now, missed;
+
+	release = flink_now_ns();
+	while(!__atomic_load_n(&smp->stop, __ATOMIC_RELAXED)) {
+		flink_sleep_until(release);
+		if(__atomic_load_n(&smp->stop, __ATOMIC_RELAXED)) break;
+
+		start = flink_now_ns();
+		if(flink_txn_commit(smp->reads, NULL) == EXIT_SUCCESS) publish(smp, start);
+		else count(&smp->stats.errors, 1);
+
+		release += smp->period_ns;
+		now = flink_now_ns();
+		if(now > release) {
+			missed = (now - release) / smp->period_ns + 1;
+			count(&smp->stats.overruns, missed);
+			release += missed * smp->period_ns;
+		}
+	}
+	return NULL;
+}
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Creates a sampler.
+ * @param dev: Flink device the channels belong to.
+ * @param period_us: Sampling period in us.
+ * @param capacity: Nof frames the ring holds, rounded up to a power of two.
+ * @return flink_sampler*: Sampler or NULL in case of failure.
+ */
+flink_sampler* flink_sampler_create(flink_dev* dev, uint32_t period_us, uint32_t capacity) {
+	flink_sampler* smp;
+	void* mem;
+
+	if(!validate_flink_dev(dev)) {
+		flink_error(FLINK_EINVALDEV);
+		return NULL;
+	}
+	if(period_us == 0 || capacity == 0 || capacity > (1u << 31)) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return NULL;
+	}
+	if(posix_memalign(&mem, CACHE_LINE_SIZE, sizeof(flink_sampler)) != 0) {
+		libc_error();
+		return NULL;
+	}
+	smp = memset(mem, 0, sizeof(flink_sampler));
+	smp->dev = dev;
+	smp->period_ns = (uint64_t)period_us * 1000;
+	smp->capacity = 1;
+	while(smp->capacity < capacity) smp->capacity <<= 1;
+	smp->reads = flink_txn_begin(dev);
+	if(smp->reads == NULL) {
+		free(smp);
+		return NULL;
+	}
+	return smp;
+}
+
+/**
+ * @brief Adds the value of a channel to the frames.
+ * @param smp: Sampler, not started yet.
+ * @param subdev: Analog input, analog output, counter or reflective sensor of the sampler's device.
+ * @param channel: Channel number.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_sampler_add_channel(flink_sampler* smp, flink_subdev* subdev, uint32_t channel) {
+	if(subdev == NULL || !validate_flink_subdev(subdev)) {
+		flink_error(FLINK_EINVALSUBDEV);
+		return EXIT_ERROR;
+	}
+	switch(subdev->function_id) {
+		case ANALOG_INPUT_INTERFACE_ID:
+		case ANALOG_OUTPUT_INTERFACE_ID:
+		case COUNTER_INTERFACE_ID:
+		case SENSOR_INTERFACE_ID:
+			break;
+		default:
+			flink_error(FLINK_WRONGSUBDEVT);
+			return EXIT_ERROR;
+	}
+	if(channel >= subdev->nof_channels) {
+		flink_error(FLINK_EINVALCHAN);
+		return EXIT_ERROR;
+	}
+	return flink_sampler_add_register(smp, subdev, layout_reg(subdev, LAYOUT_VALUE, channel));
+}
+
+/**
+ * @brief Adds a register to the frames.
+ *
+ * A register following the previous one of the same subdevice is read
+ * with the same operation.
+ *
+ * @param smp: Sampler, not started yet.
+ * @param subdev: Subdevice of the sampler's device.
+ * @param offset: Register offset, relative to the subdevice base address.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_sampler_add_register(flink_sampler* smp, flink_subdev* subdev, uint32_t offset) {
+	flink_op* last;
+
+	if(smp == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(smp->values != NULL) { // ring allocated by the first start
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	if(offset % REGISTER_WITH) {
+		flink_error(FLINK_EINVALOFFS);
+		return EXIT_ERROR;
+	}
+
+	last = smp->reads->nof_ops ? smp->reads->ops + smp->reads->nof_ops - 1 : NULL;
+	if(last && last->subdev == subdev && last->offset + last->size == offset && last->size + REGISTER_WITH <= UINT8_MAX) {
+		last->size += REGISTER_WITH;
+	}
+	else if(flink_txn_add_read(smp->reads, subdev, offset, REGISTER_WITH, smp) != EXIT_SUCCESS) { // buffer set on start
+		return EXIT_ERROR;
+	}
+	smp->nof_channels++;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Starts the sampling thread.
+ * @param smp: Sampler with at least one channel.
+ * @param cpu: CPU the thread is pinned to, -1 for no pinning.
+ * @param priority: SCHED_FIFO priority of the thread, 0 for the default scheduling.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_sampler_start(flink_sampler* smp, int cpu, int priority) {
+	uint32_t* dst;
+	size_t i;
+
+	if(smp == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(smp->running || smp->nof_channels == 0) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	if(smp->values == NULL) {
+		smp->frame = calloc(smp->nof_channels, sizeof(uint32_t));
+		smp->timestamps = calloc(smp->capacity, sizeof(uint64_t));
+		smp->values = calloc((size_t)smp->capacity * smp->nof_channels, sizeof(uint32_t));
+		if(smp->frame == NULL || smp->timestamps == NULL || smp->values == NULL) {
+			libc_error();
+			free(smp->frame);
+			free(smp->timestamps);
+			free(smp->values);
+			smp->frame = NULL;
+			smp->timestamps = NULL;
+			smp->values = NULL;
+			return EXIT_ERROR;
+		}
+		for(i = 0, dst = smp->frame; i < smp->reads->nof_ops; i++) { // the operations fill the frame in order
+			smp->reads->ops[i].data = dst;
+			dst += smp->reads->ops[i].size / REGISTER_WITH;
+		}
+	}
+
+	__atomic_store_n(&smp->stop, 0, __ATOMIC_RELAXED);
+	if(flink_thread_start(&smp->thread, cpu, priority, run_sampler, smp) != EXIT_SUCCESS) return EXIT_ERROR;
+	smp->running = 1;
+	dbg_print("sampler started with %u channels in %zu reads\n", smp->nof_channels, smp->reads->nof_ops);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Takes the oldest frames out of the ring.
+ *
+ * Never blocks. Only one thread at a time may read the frames of a sampler.
+ *
+ * @param smp: Sampler.
+ * @param timestamps: Receives the start of the reads of each frame in ns of CLOCK_MONOTONIC. May be NULL.
+ * @param values: Receives the values, one frame after the other, nof channels values per frame.
+ * @param max_frames: Maximum nof frames to take.
+ * @return ssize_t: Nof frames taken, 0 if the ring is empty, -1 in case of failure.
+ */
+ssize_t flink_sampler_read(flink_sampler* smp, uint64_t* timestamps, uint32_t* values, size_t max_frames) {
+	uint64_t head, tail;
+	uint32_t slot;
+	size_t i, n;
+
+	if(smp == NULL || values == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(smp->values == NULL) return 0; // never started
+
+	tail = smp->tail;
+	head = __atomic_load_n(&smp->head, __ATOMIC_ACQUIRE);
+	n = head - tail < max_frames ? head - tail : max_frames;
+	for(i = 0; i < n; i++) {
+		slot = (tail + i) & (smp->capacity - 1);
+		if(timestamps) timestamps[i] = smp->timestamps[slot];
+		memcpy(values + i * smp->nof_channels, smp->values + (size_t)slot * smp->nof_channels, smp->nof_channels * sizeof(uint32_t));
+	}
+	__atomic_store_n(&smp->tail, tail + n, __ATOMIC_RELEASE);
+	return n;
+}
+
+/**
+ * @brief Reads the statistics of a sampler. May be called while it runs.
+ * @param smp: Sampler.
+ * @param stats: Contains the statistics.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_sampler_get_stats(flink_sampler* smp, flink_sampler_stats* stats) {
+	if(smp == NULL || stats == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	stats->frames   = __atomic_load_n(&smp->stats.frames, __ATOMIC_RELAXED);
+	stats->dropped  = __atomic_load_n(&smp->stats.dropped, __ATOMIC_RELAXED);
+	stats->overruns = __atomic_load_n(&smp->stats.overruns, __ATOMIC_RELAXED);
+	stats->errors   = __atomic_load_n(&smp->stats.errors, __ATOMIC_RELAXED);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Stops the sampling thread after the current period. The frames in the ring can still be read.
+ * @param smp: Sampler.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_sampler_stop(flink_sampler* smp) {
+	if(smp == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(!smp->running) return EXIT_SUCCESS;
+	__atomic_store_n(&smp->stop, 1, __ATOMIC_RELAXED);
+	pthread_join(smp->thread, NULL);
+	smp->running = 0;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Stops and frees a sampler.
+ * @param smp: Sampler, may be NULL.
+ */
+void flink_sampler_free(flink_sampler* smp) {
+	if(smp == NULL) return;
+	flink_sampler_stop(smp);
+	flink_txn_free(smp->reads);
+	free(smp->frame);
+	free(smp->timestamps);
+	free(smp->values);
+	free(smp);
+}
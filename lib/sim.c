@@ -0,0 +1,806 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, register simulator                    *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file sim.c
+ *  @brief Backend simulating a flink device in process memory.
+ *
+ *  Opened with "sim:<design>[;latency=<ns>]". The design is a comma
+ *  separated list of subdevices "<function>[:<channels>]", e.g.
+ *  "sim:info,dio:32,pwm:4;latency=2000". "sim:" alone opens a design
+ *  containing one subdevice of every standard function.
+ *
+ *  The simulator implements the header and subheader of every subdevice
+ *  and the register maps used by the subdevice functions of this library:
+ *  constant registers (base clock, resolution) and inputs are read only,
+ *  digital outputs only change channels configured as output, the stepper
+ *  motor atomic registers set and clear bits of the local configuration
+ *  and the reset bit restores the default values. Inputs are driven from
+ *  the test with flink_sim_poke().
+ *
+ *  Every register operation waits for the configured latency to model
+ *  the cost of a system call. Accesses to different subdevices run in
+ *  parallel, each subdevice has its own lock like the register banks of
+ *  independent IP cores.
+ *
+ *  IRQs are registered like with the driver and raised from the test with
+ *  flink_sim_trigger_irq(), which queues the real-time signal of the IRQ
+ *  to the thread that registered it.
+ */
+
+#define _GNU_SOURCE	// pthread_sigqueue
+
+#include "flinklib.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "backend.h"
+#include "flinkioctl.h"
+
+#include <stdlib.h>
+#include <signal.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#define SIM_DEFAULT_DESIGN	"info,dio:32,pwm:4,ppwa:4,ain:8,aout:4,counter:4,wd,stepper:2,sensor:4,irqmux:8"
+#define SIM_DESCRIPTION		"flink simulator"
+#define SIM_BASE_CLOCK		100000000	// Hz
+#define SIM_RESOLUTION		4096		// steps
+#define SIM_MAX_CHANNELS	1024
+
+#define FUNC_OFFSET			(HEADER_SIZE + SUBHEADER_SIZE)	// first function register
+#define TYPE_OFFSET			0x0000	// byte
+#define MEM_SIZE_OFFSET		0x0004	// byte
+#define NOF_CHANNELS_OFFSET	0x0008	// byte
+#define UNIQUE_ID_OFFSET	0x000C	// byte
+#define WD_ARM_BIT			0
+#define WD_FIRED_BIT		0
+#define NOF_STEPPER_REGS	8
+
+typedef struct _sim_function {
+	const char* name;			/// Name used in the design
+	uint16_t    function_id;	/// Function of the subdevice
+	uint32_t    channels;		/// Default nof channels
+} sim_function;
+
+typedef struct _sim_subdev {
+	pthread_mutex_t lock;		/// Serializes the register accesses of the subdevice
+	uint32_t        nof_regs;	/// Nof function registers
+	uint8_t         armed;		/// Watchdog armed
+	uint8_t         fired;		/// Watchdog expired
+	struct timespec triggered;	/// Last watchdog retrigger
+} sim_subdev;
+
+typedef struct _sim_device {
+	pthread_mutex_t lock;			/// Protects the IRQ registrations
+	uint32_t        latency_ns;		/// Simulated duration of every access
+	uint8_t*        mem;			/// Device memory
+	uint32_t        mem_size;		/// Size of the device memory
+	uint8_t         nof_subdevices;	/// Nof subdevices of the design
+	uint16_t*       functions;		/// Function of each subdevice
+	uint32_t*       channels;		/// Nof channels of each subdevice
+	sim_subdev*     state;			/// Simulation state of each subdevice
+	uint32_t        irqs;			/// Registered IRQs, one bit per IRQ
+	pthread_t       irq_threads[REGISTER_WITH * 8];	/// Thread which registered each IRQ
+} sim_device;
+
+static const sim_function functions[] = {
+	{ "info",    INFO_DEVICE_ID,               0 },
+	{ "ain",     ANALOG_INPUT_INTERFACE_ID,    8 },
+	{ "aout",    ANALOG_OUTPUT_INTERFACE_ID,   4 },
+	{ "dio",     GPIO_INTERFACE_ID,           32 },
+	{ "counter", COUNTER_INTERFACE_ID,         4 },
+	{ "pwm",     PWM_INTERFACE_ID,             4 },
+	{ "ppwa",    PPWA_INTERFACE_ID,            4 },
+	{ "wd",      WD_INTERFACE_ID,              1 },
+	{ "stepper", STEPPER_MOTOR_INTERFACE_ID,   2 },
+	{ "sensor",  SENSOR_INTERFACE_ID,          4 },
+	{ "irqmux",  IRQ_MULTIPLEXER_INTERFACE_ID, 8 },
+};
+#define NOF_FUNCTIONS (sizeof(functions) / sizeof(functions[0]))
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+static inline sim_device* sim_of(flink_subdev* subdev) {
+	return subdev->parent->priv;
+}
+
+static inline void lock_subdev(sim_device* sim, flink_subdev* subdev) {
+	pthread_mutex_lock(&sim->state[subdev->id].lock);
+}
+
+static inline void unlock_subdev(sim_device* sim, flink_subdev* subdev) {
+	pthread_mutex_unlock(&sim->state[subdev->id].lock);
+}
+
+/**
+ * @brief Nof words of a digital I/O bit register for a given nof channels.
+ */
+static inline uint32_t dio_words(uint32_t n) {
+	return (n - 1) / (REGISTER_WITH * 8) + 1;
+}
+
+/**
+ * @brief Nof function registers of a subdevice.
+ */
+static uint32_t nof_function_regs(uint16_t function, uint32_t n) {
+	switch(function) {
+		case INFO_DEVICE_ID:               return 1 + INFO_DESC_SIZE / REGISTER_WITH;
+		case ANALOG_INPUT_INTERFACE_ID:    return 1 + n;
+		case ANALOG_OUTPUT_INTERFACE_ID:   return 1 + n;
+		case GPIO_INTERFACE_ID:            return 1 + 2 * dio_words(n) + n;
+		case COUNTER_INTERFACE_ID:         return n;
+		case PWM_INTERFACE_ID:             return 1 + 2 * n;
+		case PPWA_INTERFACE_ID:            return 1 + 2 * n;
+		case WD_INTERFACE_ID:              return 1 + n;
+		case STEPPER_MOTOR_INTERFACE_ID:   return 1 + NOF_STEPPER_REGS * n;
+		case SENSOR_INTERFACE_ID:          return 1 + 3 * n;
+		case IRQ_MULTIPLEXER_INTERFACE_ID: return n;
+		default:                           return n;
+	}
+}
+
+/**
+ * @brief Memory size of a subdevice, a power of two like in real designs.
+ */
+static uint32_t subdev_mem_size(uint32_t nof_regs) {
+	uint32_t needed = FUNC_OFFSET + nof_regs * REGISTER_WITH;
+	uint32_t size = 0x40;
+	while(size < needed) size <<= 1;
+	return size;
+}
+
+static inline uint32_t* raw_reg(sim_device* sim, flink_subdev* subdev, uint32_t offset) {
+	return (uint32_t*)(sim->mem + subdev->base_addr + offset);
+}
+
+static void elapsed_since(const struct timespec* start, struct timespec* now, uint64_t* ns) {
+	clock_gettime(CLOCK_MONOTONIC, now);
+	*ns = (uint64_t)(now->tv_sec - start->tv_sec) * 1000000000ull + now->tv_nsec - start->tv_nsec;
+}
+
+/**
+ * @brief Busy waits for the simulated access latency.
+ */
+static void sim_delay(sim_device* sim) {
+	uint32_t latency = __atomic_load_n(&sim->latency_ns, __ATOMIC_RELAXED);
+	struct timespec start, now;
+	uint64_t ns;
+
+	if(latency == 0) return;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		elapsed_since(&start, &now, &ns);
+	} while(ns < latency);
+}
+
+/**
+ * @brief Sets all function registers of a subdevice to their default values.
+ */
+static void reset_subdev(sim_device* sim, flink_subdev* subdev) {
+	sim_subdev* state = sim->state + subdev->id;
+	uint32_t* regs = raw_reg(sim, subdev, FUNC_OFFSET);
+	const char* desc = SIM_DESCRIPTION;
+	uint32_t i, k, word;
+
+	memset(regs, 0, state->nof_regs * REGISTER_WITH);
+	state->armed = 0;
+	state->fired = 0;
+
+	switch(subdev->function_id) {
+		case INFO_DEVICE_ID:
+			regs[0] = sim->mem_size;
+			for(i = 0; i < INFO_DESC_SIZE / REGISTER_WITH; i++) {
+				word = 0;
+				for(k = 0; k < REGISTER_WITH; k++) {
+					word <<= 8;
+					if(*desc) word |= (uint8_t)*desc++;
+				}
+				regs[1 + i] = word;
+			}
+			break;
+		case ANALOG_INPUT_INTERFACE_ID:
+		case ANALOG_OUTPUT_INTERFACE_ID:
+		case SENSOR_INTERFACE_ID:
+			regs[0] = SIM_RESOLUTION;
+			break;
+		case GPIO_INTERFACE_ID:
+		case PWM_INTERFACE_ID:
+		case PPWA_INTERFACE_ID:
+		case WD_INTERFACE_ID:
+		case STEPPER_MOTOR_INTERFACE_ID:
+			regs[0] = SIM_BASE_CLOCK;
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief Updates the watchdog status from the time passed since the last retrigger.
+ */
+static void update_wd(sim_device* sim, flink_subdev* subdev) {
+	sim_subdev* state = sim->state + subdev->id;
+	uint32_t base_clk = *raw_reg(sim, subdev, FUNC_OFFSET);
+	uint32_t counter = *raw_reg(sim, subdev, FUNC_OFFSET + REGISTER_WITH);
+	struct timespec now;
+	uint64_t ns;
+
+	if(state->armed && !state->fired) {
+		elapsed_since(&state->triggered, &now, &ns);
+		if(ns * base_clk / 1000000000ull > counter) state->fired = 1;
+	}
+	*raw_reg(sim, subdev, STATUS_OFFSET) = state->fired << WD_FIRED_BIT;
+}
+
+static uint32_t read_reg(sim_device* sim, flink_subdev* subdev, uint32_t offset) {
+	if(subdev->function_id == WD_INTERFACE_ID && offset == STATUS_OFFSET) {
+		update_wd(sim, subdev);
+	}
+	return *raw_reg(sim, subdev, offset);
+}
+
+/**
+ * @brief Handles a write to the configuration register of the subheader.
+ */
+static void write_config(sim_device* sim, flink_subdev* subdev, uint32_t value) {
+	sim_subdev* state = sim->state + subdev->id;
+	uint32_t i, n = subdev->nof_channels;
+
+	if(subdev->function_id == WD_INTERFACE_ID) { // the watchdog uses bit 0 to arm
+		if(value & (1u << WD_ARM_BIT)) {
+			state->armed = 1;
+			clock_gettime(CLOCK_MONOTONIC, &state->triggered);
+		}
+		return;
+	}
+	if(subdev->function_id == STEPPER_MOTOR_INTERFACE_ID && (value & (1u << GLOBAL_STEP_RESET))) {
+		for(i = 0; i < n; i++) {
+			*raw_reg(sim, subdev, FUNC_OFFSET + STEPPER_MOTOR_FIRST_CONF_OFFSET + (7 * n + i) * REGISTER_WITH) = 0;
+		}
+	}
+	if(value & (1u << RESET_BIT)) {
+		reset_subdev(sim, subdev);
+	}
+}
+
+/**
+ * @brief Writes a register with the semantics of the subdevice function.
+ */
+static void write_reg(sim_device* sim, flink_subdev* subdev, uint32_t offset, uint32_t value) {
+	uint32_t* reg = raw_reg(sim, subdev, offset);
+	uint32_t n = subdev->nof_channels;
+	uint32_t r, dir, group;
+
+	if(offset == CONFIG_OFFSET) {
+		write_config(sim, subdev, value);
+		return;
+	}
+	if(offset < FUNC_OFFSET) return; // header, status and reserved registers are read only
+
+	r = (offset - FUNC_OFFSET) / REGISTER_WITH;
+	switch(subdev->function_id) {
+		case INFO_DEVICE_ID:
+		case ANALOG_INPUT_INTERFACE_ID:
+		case COUNTER_INTERFACE_ID:
+		case PPWA_INTERFACE_ID:
+			return; // inputs only
+		case SENSOR_INTERFACE_ID:
+			if(r <= n) return; // resolution and values
+			break;
+		case GPIO_INTERFACE_ID:
+			if(r == 0) return;
+			if(r > dio_words(n) && r <= 2 * dio_words(n)) { // values, only outputs are written
+				dir = *raw_reg(sim, subdev, offset - dio_words(n) * REGISTER_WITH);
+				value = (*reg & ~dir) | (value & dir);
+			}
+			break;
+		case WD_INTERFACE_ID:
+			if(r == 0) return;
+			clock_gettime(CLOCK_MONOTONIC, &sim->state[subdev->id].triggered);
+			break;
+		case STEPPER_MOTOR_INTERFACE_ID:
+			if(r == 0) return;
+			group = (r - 1) / n;
+			reg = raw_reg(sim, subdev, FUNC_OFFSET + STEPPER_MOTOR_FIRST_CONF_OFFSET + ((r - 1) % n) * REGISTER_WITH);
+			if(group == 1) value = *reg | value;        // set bits atomic
+			else if(group == 2) value = *reg & ~value;  // reset bits atomic
+			else if(group == 7) return;                 // steps done
+			else reg = raw_reg(sim, subdev, offset);
+			break;
+		default:
+			if(r == 0 && subdev->function_id != IRQ_MULTIPLEXER_INTERFACE_ID) return; // constant register
+			break;
+	}
+	*reg = value;
+}
+
+static int check_range(flink_subdev* subdev, uint32_t offset, uint32_t size) {
+	if((uint64_t)offset + size > subdev->mem_size) {
+		flink_error(FLINK_EINVALOFFS);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief Parses the design of a simulated device.
+ * @param sim: Simulated device to fill in.
+ * @param design: Design description, modified while parsing.
+ * @return int: 0 on success, -1 in case of error.
+ */
+static int parse_design(sim_device* sim, char* design) {
+	char* save = NULL;
+	char* token;
+	char* channels;
+	unsigned int i, n = 0;
+
+	sim->functions = calloc(UINT8_MAX, sizeof(uint16_t));
+	sim->channels = calloc(UINT8_MAX, sizeof(uint32_t));
+	if(sim->functions == NULL || sim->channels == NULL) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+
+	for(token = strtok_r(design, ",", &save); token; token = strtok_r(NULL, ",", &save)) {
+		channels = strchr(token, ':');
+		if(channels) *channels++ = '\0';
+		for(i = 0; i < NOF_FUNCTIONS; i++) {
+			if(strcmp(token, functions[i].name) == 0) break;
+		}
+		if(i == NOF_FUNCTIONS || n == UINT8_MAX) {
+			dbg_print("unknown simulated function '%s'\n", token);
+			flink_error(FLINK_EINVALDEV);
+			return EXIT_ERROR;
+		}
+		sim->functions[n] = functions[i].function_id;
+		sim->channels[n] = channels ? strtoul(channels, NULL, 0) : functions[i].channels;
+		if(sim->channels[n] > SIM_MAX_CHANNELS || (sim->channels[n] == 0 && functions[i].function_id != INFO_DEVICE_ID)) {
+			flink_error(FLINK_EINVALCHAN);
+			return EXIT_ERROR;
+		}
+		n++;
+	}
+	if(n == 0) {
+		flink_error(FLINK_EINVALDEV);
+		return EXIT_ERROR;
+	}
+	sim->nof_subdevices = n;
+	return EXIT_SUCCESS;
+}
+
+static void free_sim(sim_device* sim) {
+	int i;
+
+	for(i = 0; sim->state && i < sim->nof_subdevices; i++) {
+		pthread_mutex_destroy(&sim->state[i].lock);
+	}
+	pthread_mutex_destroy(&sim->lock);
+	free(sim->functions);
+	free(sim->channels);
+	free(sim->state);
+	free(sim->mem);
+	free(sim);
+}
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Backend operations                                             *
+ *                                                                 *
+ *******************************************************************/
+
+static int sim_open(flink_dev* dev, const char* path) {
+	sim_device* sim;
+	char* spec;
+	char* options;
+	int ret;
+
+	sim = calloc(1, sizeof(sim_device));
+	spec = strdup(*path ? path : SIM_DEFAULT_DESIGN);
+	if(sim == NULL || spec == NULL) {
+		libc_error();
+		free(sim);
+		free(spec);
+		return EXIT_ERROR;
+	}
+	pthread_mutex_init(&sim->lock, NULL);
+
+	options = strchr(spec, ';');
+	if(options) {
+		*options++ = '\0';
+		if(strncmp(options, "latency=", 8) == 0) sim->latency_ns = strtoul(options + 8, NULL, 0);
+	}
+	ret = parse_design(sim, *spec ? spec : strcpy(spec, SIM_DEFAULT_DESIGN));
+	free(spec);
+	if(ret < 0) {
+		free_sim(sim);
+		return EXIT_ERROR;
+	}
+
+	dev->fd = -1;
+	dev->priv = sim;
+	return EXIT_SUCCESS;
+}
+
+static int sim_close(flink_dev* dev) {
+	free_sim(dev->priv);
+	dev->priv = NULL;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Signal of an IRQ, 0 if the IRQ has no real-time signal.
+ */
+static int irq_signal(uint32_t irq) {
+	if(irq >= REGISTER_WITH * 8 || SIGRTMIN + (int)irq > SIGRTMAX) return 0;
+	return SIGRTMIN + irq;
+}
+
+/**
+ * @brief Emulates the IRQ commands of the driver, other commands are emulated on the registers.
+ */
+static int sim_ioctl(flink_dev* dev, int cmd, void* arg) {
+	sim_device* sim = dev->priv;
+	ioctl_container_t* container = arg;
+	uint32_t irq;
+	int sig;
+
+	switch(cmd) {
+		case GET_SIGNAL_OFFSET:
+			*((uint32_t*)container->data) = SIGRTMIN;
+			return EXIT_SUCCESS;
+		case REGISTER_IRQ:
+		case UNREGISTER_IRQ:
+			irq = *((uint32_t*)container->data);
+			sig = irq_signal(irq);
+			if(sig == 0) {
+				flink_error(FLINK_EINVALCHAN);
+				return EXIT_ERROR;
+			}
+			pthread_mutex_lock(&sim->lock);
+			if(cmd == REGISTER_IRQ) {
+				sim->irqs |= (1u << irq);
+				sim->irq_threads[irq] = pthread_self();
+			}
+			else {
+				sim->irqs &= ~(1u << irq);
+			}
+			pthread_mutex_unlock(&sim->lock);
+			return cmd == REGISTER_IRQ ? sig : EXIT_SUCCESS;
+		default:
+			return flink_emulate_ioctl(dev, cmd, arg);
+	}
+}
+
+static int sim_count(flink_dev* dev) {
+	return ((sim_device*)dev->priv)->nof_subdevices;
+}
+
+static int sim_enumerate(flink_dev* dev) {
+	sim_device* sim = dev->priv;
+	flink_subdev* subdev;
+	uint32_t addr = 0, nof_regs, type;
+	int i;
+
+	sim->state = calloc(sim->nof_subdevices, sizeof(sim_subdev));
+	if(sim->state == NULL) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+
+	for(i = 0; i < dev->nof_subdevices; i++) { // place the subdevices one after the other
+		subdev = dev->subdevices + i;
+		nof_regs = nof_function_regs(sim->functions[i], sim->channels[i]);
+		subdev->id           = i;
+		subdev->function_id  = sim->functions[i];
+		subdev->base_addr    = addr;
+		subdev->mem_size     = subdev_mem_size(nof_regs);
+		subdev->nof_channels = sim->channels[i];
+		subdev->unique_id    = i + 1;
+		subdev->parent       = dev;
+		sim->state[i].nof_regs = nof_regs;
+		pthread_mutex_init(&sim->state[i].lock, NULL);
+		addr += subdev->mem_size;
+	}
+
+	sim->mem_size = addr;
+	sim->mem = calloc(addr / REGISTER_WITH, REGISTER_WITH);
+	if(sim->mem == NULL) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		subdev = dev->subdevices + i;
+		type = (uint32_t)subdev->function_id << 16 | subdev->sub_function_id << 8 | subdev->function_version;
+		*raw_reg(sim, subdev, TYPE_OFFSET)         = type;
+		*raw_reg(sim, subdev, MEM_SIZE_OFFSET)     = subdev->mem_size;
+		*raw_reg(sim, subdev, NOF_CHANNELS_OFFSET) = subdev->nof_channels;
+		*raw_reg(sim, subdev, UNIQUE_ID_OFFSET)    = subdev->unique_id;
+		reset_subdev(sim, subdev);
+	}
+	return dev->nof_subdevices;
+}
+
+/**
+ * @brief Reads registers of a subdevice, the subdevice must be locked.
+ */
+static void read_regs(sim_device* sim, flink_subdev* subdev, uint32_t offset, uint8_t size, uint8_t* dst) {
+	uint32_t value = 0, pos;
+	int i;
+
+	for(i = 0; i < size; i++) {
+		pos = offset + i;
+		if(i == 0 || pos % REGISTER_WITH == 0) value = read_reg(sim, subdev, pos & ~(REGISTER_WITH - 1));
+		dst[i] = (uint8_t)(value >> (8 * (pos % REGISTER_WITH)));
+	}
+}
+
+/**
+ * @brief Writes registers of a subdevice, the subdevice must be locked.
+ */
+static void write_regs(sim_device* sim, flink_subdev* subdev, uint32_t offset, uint8_t size, const uint8_t* src) {
+	uint32_t value = 0, pos, word;
+	int i;
+
+	for(i = 0; i < size; i++) {
+		pos = offset + i;
+		word = pos & ~(REGISTER_WITH - 1);
+		if(i == 0 || pos % REGISTER_WITH == 0) value = *raw_reg(sim, subdev, word);
+		value &= ~(0xffu << (8 * (pos % REGISTER_WITH)));
+		value |= (uint32_t)src[i] << (8 * (pos % REGISTER_WITH));
+		if(i == size - 1 || (pos + 1) % REGISTER_WITH == 0) write_reg(sim, subdev, word, value);
+	}
+}
+
+static ssize_t sim_read(flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata) {
+	sim_device* sim = sim_of(subdev);
+
+	sim_delay(sim);
+	if(!check_range(subdev, offset, size)) return EXIT_ERROR;
+
+	lock_subdev(sim, subdev);
+	read_regs(sim, subdev, offset, size, rdata);
+	unlock_subdev(sim, subdev);
+	return size;
+}
+
+static ssize_t sim_write(flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata) {
+	sim_device* sim = sim_of(subdev);
+
+	sim_delay(sim);
+	if(!check_range(subdev, offset, size)) return EXIT_ERROR;
+
+	lock_subdev(sim, subdev);
+	write_regs(sim, subdev, offset, size, wdata);
+	unlock_subdev(sim, subdev);
+	return size;
+}
+
+/**
+ * @brief Executes all operations of a transaction as one access.
+ *
+ * The subdevices of the transaction are locked in the order of their ids
+ * for the whole transaction, so it reads and writes them at one moment.
+ */
+static int sim_transfer(flink_dev* dev, flink_op* ops, size_t nof_ops, ssize_t* results) {
+	sim_device* sim = dev->priv;
+	uint32_t used[(UINT8_MAX + 1) / 32] = { 0 };
+	int ret = EXIT_SUCCESS;
+	size_t i;
+	int id;
+
+	sim_delay(sim);
+	for(i = 0; i < nof_ops; i++) {
+		id = ops[i].subdev->id;
+		used[id / 32] |= 1u << (id % 32);
+	}
+	for(id = 0; id < sim->nof_subdevices; id++) {
+		if(used[id / 32] & (1u << (id % 32))) pthread_mutex_lock(&sim->state[id].lock);
+	}
+	for(i = 0; i < nof_ops; i++) {
+		if(!check_range(ops[i].subdev, ops[i].offset, ops[i].size)) {
+			results[i] = EXIT_ERROR;
+			ret = EXIT_ERROR;
+			continue;
+		}
+		if(ops[i].write) write_regs(sim, ops[i].subdev, ops[i].offset, ops[i].size, ops[i].data);
+		else             read_regs(sim, ops[i].subdev, ops[i].offset, ops[i].size, ops[i].data);
+		results[i] = ops[i].size;
+	}
+	for(id = 0; id < sim->nof_subdevices; id++) {
+		if(used[id / 32] & (1u << (id % 32))) pthread_mutex_unlock(&sim->state[id].lock);
+	}
+	return ret;
+}
+
+static int sim_read_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t* value) {
+	sim_device* sim = sim_of(subdev);
+
+	sim_delay(sim);
+	if(bit >= REGISTER_WITH * 8 || offset % REGISTER_WITH != 0) {
+		flink_error(FLINK_EINVALOFFS);
+		return EXIT_ERROR;
+	}
+	if(!check_range(subdev, offset, REGISTER_WITH)) return EXIT_ERROR;
+
+	lock_subdev(sim, subdev);
+	*value = (read_reg(sim, subdev, offset) >> bit) & 0x1;
+	unlock_subdev(sim, subdev);
+	return EXIT_SUCCESS;
+}
+
+static int sim_write_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t value) {
+	sim_device* sim = sim_of(subdev);
+	uint32_t reg;
+
+	sim_delay(sim);
+	if(bit >= REGISTER_WITH * 8 || offset % REGISTER_WITH != 0) {
+		flink_error(FLINK_EINVALOFFS);
+		return EXIT_ERROR;
+	}
+	if(!check_range(subdev, offset, REGISTER_WITH)) return EXIT_ERROR;
+
+	lock_subdev(sim, subdev);
+	reg = *raw_reg(sim, subdev, offset);
+	if(value) reg |= (1u << bit);
+	else      reg &= ~(1u << bit);
+	write_reg(sim, subdev, offset, reg);
+	unlock_subdev(sim, subdev);
+	return EXIT_SUCCESS;
+}
+
+const flink_backend flink_sim_backend = {
+	.scheme    = "sim",
+	.open      = sim_open,
+	.close     = sim_close,
+	.count     = sim_count,
+	.enumerate = sim_enumerate,
+	.ioctl     = sim_ioctl,
+	.read      = sim_read,
+	.write     = sim_write,
+	.read_bit  = sim_read_bit,
+	.write_bit = sim_write_bit,
+	.transfer  = sim_transfer,
+};
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Checks if a subdevice belongs to a simulated device.
+ * @param subdev: Subdevice to check.
+ * @return int: 1 if simulated, 0 if not.
+ */
+static int validate_sim_subdev(flink_subdev* subdev) {
+	if(subdev == NULL || subdev->parent == NULL || subdev->parent->backend != &flink_sim_backend) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief Sets the duration of every register access of a simulated device.
+ * @param dev: Simulated device.
+ * @param latency_ns: Access latency in ns.
+ * @return int: 0 on success, -1 if the device is not simulated.
+ */
+int flink_sim_set_latency(flink_dev* dev, uint32_t latency_ns) {
+	if(dev == NULL || dev->backend != &flink_sim_backend) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	__atomic_store_n(&((sim_device*)dev->priv)->latency_ns, latency_ns, __ATOMIC_RELAXED);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Writes a register of a simulated subdevice from the hardware side.
+ *
+ * Read only registers like inputs, counters or the header are written as well.
+ *
+ * @param subdev: Simulated subdevice.
+ * @param offset: Register offset, relative to the subdevice base address.
+ * @param value: Value to write.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_sim_poke(flink_subdev* subdev, uint32_t offset, uint32_t value) {
+	sim_device* sim;
+
+	if(!validate_sim_subdev(subdev)) return EXIT_ERROR;
+	if(offset % REGISTER_WITH != 0 || !check_range(subdev, offset, REGISTER_WITH)) {
+		flink_error(FLINK_EINVALOFFS);
+		return EXIT_ERROR;
+	}
+	sim = sim_of(subdev);
+	lock_subdev(sim, subdev);
+	*raw_reg(sim, subdev, offset) = value;
+	unlock_subdev(sim, subdev);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Reads a register of a simulated subdevice from the hardware side.
+ * @param subdev: Simulated subdevice.
+ * @param offset: Register offset, relative to the subdevice base address.
+ * @param value: Contains the register value.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_sim_peek(flink_subdev* subdev, uint32_t offset, uint32_t* value) {
+	sim_device* sim;
+
+	if(!validate_sim_subdev(subdev)) return EXIT_ERROR;
+	if(offset % REGISTER_WITH != 0 || !check_range(subdev, offset, REGISTER_WITH)) {
+		flink_error(FLINK_EINVALOFFS);
+		return EXIT_ERROR;
+	}
+	sim = sim_of(subdev);
+	lock_subdev(sim, subdev);
+	*value = read_reg(sim, subdev, offset);
+	unlock_subdev(sim, subdev);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Raises an IRQ of a simulated device.
+ *
+ * The signal of the IRQ is queued to the thread which registered the IRQ, 
+ * an IRQ which is not registered is dropped like by the driver.
+ *
+ * @param dev: Simulated device.
+ * @param irq: IRQ number.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_sim_trigger_irq(flink_dev* dev, uint32_t irq) {
+	sim_device* sim;
+	uint32_t registered;
+	pthread_t thread;
+	int sig, ret;
+
+	if(dev == NULL || dev->backend != &flink_sim_backend) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	sig = irq_signal(irq);
+	if(sig == 0) {
+		flink_error(FLINK_EINVALCHAN);
+		return EXIT_ERROR;
+	}
+	sim = dev->priv;
+	pthread_mutex_lock(&sim->lock);
+	registered = sim->irqs & (1u << irq);
+	thread = sim->irq_threads[irq];
+	pthread_mutex_unlock(&sim->lock);
+	if(!registered) return EXIT_SUCCESS;
+
+	ret = pthread_sigqueue(thread, sig, (union sigval){ .sival_int = (int)irq });
+	if(ret != 0) {
+		errno = ret;
+		libc_error();
+		return EXIT_ERROR;
+	}
+	return EXIT_SUCCESS;
+}
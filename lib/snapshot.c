@@ -0,0 +1,194 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, snapshots                             *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file snapshot.c
+ *  @brief Coherent reads of registers across subdevices.
+ *
+ *  A snapshot declares a set of registers once, each with the offset of
+ *  the field of a caller's struct receiving it. A capture reads all of
+ *  them with one transaction straight into the struct, so backends with
+ *  a transfer operation read the whole set in one call. Neighbouring
+ *  registers going to neighbouring fields are read with one operation.
+ */
+
+#include "flinklib.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "valid.h"
+#include "layout.h"
+#include "thread.h"
+
+#include <stdlib.h>
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Creates an empty snapshot of a device.
+ * @param dev: Flink device handle.
+ * @return flink_snapshot*: Snapshot or NULL in case of failure.
+ */
+flink_snapshot* flink_snapshot_create(flink_dev* dev) {
+	flink_snapshot* snap;
+
+	if(!validate_flink_dev(dev)) {
+		flink_error(FLINK_EINVALDEV);
+		return NULL;
+	}
+	snap = calloc(1, sizeof(flink_snapshot));
+	if(snap == NULL) {
+		libc_error();
+		return NULL;
+	}
+	snap->reads = flink_txn_begin(dev);
+	if(snap->reads == NULL) {
+		free(snap);
+		return NULL;
+	}
+	return snap;
+}
+
+/**
+ * @brief Adds registers to a snapshot.
+ * @param snap: Snapshot.
+ * @param subdev: Subdevice of the snapshot's device.
+ * @param offset: Register offset, relative to the subdevice base address.
+ * @param size: Nof bytes to read.
+ * @param field: Offset of the field receiving the bytes in the caller's struct, e.g. offsetof().
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_snapshot_add_register(flink_snapshot* snap, flink_subdev* subdev, uint32_t offset, uint8_t size, size_t field) {
+	flink_op* last;
+	size_t* fields;
+	size_t n;
+
+	if(snap == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(size == 0) {
+		flink_error(FLINK_EINVALOFFS);
+		return EXIT_ERROR;
+	}
+
+	n = snap->reads->nof_ops;
+	last = n ? snap->reads->ops + n - 1 : NULL;
+	if(last && last->subdev == subdev && last->offset + last->size == offset &&
+	   snap->fields[n - 1] + last->size == field && last->size + size <= UINT8_MAX) {
+		last->size += size;
+	}
+	else {
+		fields = realloc(snap->fields, (n + 1) * sizeof(size_t));
+		if(fields == NULL) {
+			libc_error();
+			return EXIT_ERROR;
+		}
+		snap->fields = fields;
+		if(flink_txn_add_read(snap->reads, subdev, offset, size, snap) != EXIT_SUCCESS) return EXIT_ERROR;
+		fields[n] = field;
+	}
+	if(field + size > snap->size) snap->size = field + size;
+	snap->data = NULL; // operations point to the struct again on the next capture
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Adds the registers of a channel to a snapshot.
+ *
+ * The field receives the value of an analog input, analog output, counter or
+ * reflective sensor as uint32_t. For PWM and PPWA it receives the period followed
+ * by the high time, two uint32_t.
+ *
+ * @param snap: Snapshot.
+ * @param subdev: Subdevice of the snapshot's device.
+ * @param channel: Channel number.
+ * @param field: Offset of the field in the caller's struct, e.g. offsetof().
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_snapshot_add_channel(flink_snapshot* snap, flink_subdev* subdev, uint32_t channel, size_t field) {
+	if(subdev == NULL || !validate_flink_subdev(subdev)) {
+		flink_error(FLINK_EINVALSUBDEV);
+		return EXIT_ERROR;
+	}
+	if(channel >= subdev->nof_channels) {
+		flink_error(FLINK_EINVALCHAN);
+		return EXIT_ERROR;
+	}
+	switch(subdev->function_id) {
+		case ANALOG_INPUT_INTERFACE_ID:
+		case ANALOG_OUTPUT_INTERFACE_ID:
+		case COUNTER_INTERFACE_ID:
+		case SENSOR_INTERFACE_ID:
+			return flink_snapshot_add_register(snap, subdev, layout_reg(subdev, LAYOUT_VALUE, channel), REGISTER_WITH, field);
+		case PWM_INTERFACE_ID:
+		case PPWA_INTERFACE_ID:
+			if(flink_snapshot_add_register(snap, subdev, layout_reg(subdev, LAYOUT_PERIOD, channel), REGISTER_WITH, field) < 0) {
+				return EXIT_ERROR;
+			}
+			return flink_snapshot_add_register(snap, subdev, layout_reg(subdev, LAYOUT_HIGHTIME, channel), REGISTER_WITH, field + REGISTER_WITH);
+		default:
+			flink_error(FLINK_WRONGSUBDEVT);
+			return EXIT_ERROR;
+	}
+}
+
+/**
+ * @brief Reads all registers of a snapshot into a struct.
+ * @param snap: Snapshot.
+ * @param data: Struct receiving the registers in its fields.
+ * @param size: Size of the struct.
+ * @param timestamp_ns: Receives the middle of the read in ns of CLOCK_MONOTONIC. May be NULL.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_snapshot_capture(flink_snapshot* snap, void* data, size_t size, uint64_t* timestamp_ns) {
+	uint64_t start;
+	size_t i;
+	int ret;
+
+	if(snap == NULL || data == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(size < snap->size) {
+		flink_error(FLINK_EINVALOFFS);
+		return EXIT_ERROR;
+	}
+	if(data != snap->data) { // another struct than on the last capture
+		for(i = 0; i < snap->reads->nof_ops; i++) {
+			snap->reads->ops[i].data = (uint8_t*)data + snap->fields[i];
+		}
+		snap->data = data;
+	}
+
+	start = flink_now_ns();
+	ret = flink_txn_commit(snap->reads, NULL);
+	if(timestamp_ns) *timestamp_ns = start + (flink_now_ns() - start) / 2;
+	return ret;
+}
+
+/**
+ * @brief Releases a snapshot.
+ * @param snap: Snapshot, may be NULL.
+ */
+void flink_snapshot_free(flink_snapshot* snap) {
+	if(snap == NULL) return;
+	flink_txn_free(snap->reads);
+	free(snap->fields);
+	free(snap);
+}
@@ -0,0 +1,160 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, access statistics                     *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file stats.c
+ *  @brief Access statistics per device and subdevice.
+ *
+ *  The register accesses, bit accesses, ioctls and transactions are counted
+ *  with the bytes moved, the failures and the time spent in the calls, if the
+ *  library is built with the CMake option FLINK_STATS. Otherwise the counters
+ *  are compiled out and reading them fails.
+ */
+
+#include "flinklib.h"
+#include "types.h"
+#include "error.h"
+#include "valid.h"
+#include "stats.h"
+
+#include <string.h>
+
+#define NOF_COUNTERS (sizeof(flink_stats) / sizeof(uint64_t))
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+#ifdef FLINK_STATS
+
+/**
+ * @brief Adds the counters of src to dst, the maximum time is the larger one.
+ */
+static void add_stats(flink_stats* dst, flink_stats* src) {
+	uint64_t* d = (uint64_t*)dst;
+	uint64_t* s = (uint64_t*)src;
+	size_t i;
+
+	for(i = 0; i < NOF_COUNTERS; i++) {
+		if(s + i == &src->max_time_ns) continue;
+		d[i] += __atomic_load_n(s + i, __ATOMIC_RELAXED);
+	}
+	flink_stats_max(&dst->max_time_ns, __atomic_load_n(&src->max_time_ns, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Clears the counters.
+ */
+static void clear_stats(flink_stats* stats) {
+	uint64_t* c = (uint64_t*)stats;
+	size_t i;
+
+	for(i = 0; i < NOF_COUNTERS; i++) __atomic_store_n(c + i, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Counts a committed transaction on the device and its operations on their subdevices.
+ * @param txn: Committed transaction.
+ * @param results: Result of each operation.
+ * @param start: Time the commit started.
+ */
+void flink_stats_txn(flink_txn* txn, const ssize_t* results, uint64_t start) {
+	flink_stats* stats = &txn->dev->stats;
+	uint64_t time = flink_now_ns() - start;
+	size_t i;
+
+	__atomic_fetch_add(&stats->transactions, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&stats->time_ns, time, __ATOMIC_RELAXED);
+	flink_stats_max(&stats->max_time_ns, time);
+	for(i = 0; i < txn->nof_ops; i++) {
+		flink_op* op = txn->ops + i;
+		flink_stats* sub = &op->subdev->stats;
+		__atomic_fetch_add(op->write ? &sub->writes : &sub->reads, 1, __ATOMIC_RELAXED);
+		if(results[i] < 0) __atomic_fetch_add(&sub->errors, 1, __ATOMIC_RELAXED);
+		else __atomic_fetch_add(op->write ? &sub->bytes_written : &sub->bytes_read, results[i], __ATOMIC_RELAXED);
+	}
+}
+
+#endif // FLINK_STATS
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Reads the access statistics of a subdevice or of the whole device.
+ *
+ * The device statistics contain the accesses of all subdevices plus the ioctls,
+ * system calls and transactions. The time of a transaction is counted on the device.
+ *
+ * @param dev: Flink device.
+ * @param subdev: Subdevice of the device, NULL for the whole device.
+ * @param stats: Contains the statistics.
+ * @return int: 0 on success, -1 in case of failure or if the library is built without FLINK_STATS.
+ */
+int flink_get_stats(flink_dev* dev, flink_subdev* subdev, flink_stats* stats) {
+	if(stats == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(!validate_flink_dev(dev)) {
+		flink_error(FLINK_EINVALDEV);
+		return EXIT_ERROR;
+	}
+	if(subdev != NULL && (!validate_flink_subdev(subdev) || subdev->parent != dev)) {
+		flink_error(FLINK_EINVALSUBDEV);
+		return EXIT_ERROR;
+	}
+#ifdef FLINK_STATS
+	memset(stats, 0, sizeof(flink_stats));
+	if(subdev != NULL) {
+		add_stats(stats, &subdev->stats);
+	}
+	else {
+		uint8_t i;
+		add_stats(stats, &dev->stats);
+		for(i = 0; i < dev->nof_subdevices; i++) add_stats(stats, &dev->subdevices[i].stats);
+	}
+	return EXIT_SUCCESS;
+#else
+	flink_error(FLINK_ENOTSUPPORTED);
+	return EXIT_ERROR;
+#endif
+}
+
+/**
+ * @brief Clears the access statistics of a device and all its subdevices.
+ * @param dev: Flink device.
+ * @return int: 0 on success, -1 in case of failure or if the library is built without FLINK_STATS.
+ */
+int flink_reset_stats(flink_dev* dev) {
+	if(!validate_flink_dev(dev)) {
+		flink_error(FLINK_EINVALDEV);
+		return EXIT_ERROR;
+	}
+#ifdef FLINK_STATS
+	uint8_t i;
+	clear_stats(&dev->stats);
+	for(i = 0; i < dev->nof_subdevices; i++) clear_stats(&dev->subdevices[i].stats);
+	return EXIT_SUCCESS;
+#else
+	flink_error(FLINK_ENOTSUPPORTED);
+	return EXIT_ERROR;
+#endif
+}
@@ -0,0 +1,69 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, access statistics                     *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file stats.h
+ *  @brief Access statistics, counted only if the library is built with FLINK_STATS.
+ *
+ *  The counters are updated with relaxed atomics by any thread. Without FLINK_STATS
+ *  the macros expand to nothing and the counters do not exist.
+ */
+
+#ifndef FLINKLIB_STATS_H_
+#define FLINKLIB_STATS_H_
+
+#include "types.h"
+
+#ifdef FLINK_STATS
+
+#include "thread.h"
+
+#define STATS_START(start)                            uint64_t start = flink_now_ns()
+#define STATS_INC(stats, counter)                     __atomic_fetch_add(&(stats)->counter, 1, __ATOMIC_RELAXED)
+#define STATS_CALL(stats, counter, bytes, result, start) flink_stats_call(stats, &(stats)->counter, bytes, result, start)
+#define STATS_TXN(txn, results, start)                flink_stats_txn(txn, results, start)
+
+void flink_stats_txn(flink_txn* txn, const ssize_t* results, uint64_t start);
+
+/**
+ * @brief Raises a counter to a value if the value is larger.
+ */
+static inline void flink_stats_max(uint64_t* counter, uint64_t value) {
+	uint64_t old = __atomic_load_n(counter, __ATOMIC_RELAXED);
+	while(value > old && !__atomic_compare_exchange_n(counter, &old, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Counts a call, its bytes or its failure and the time spent since start.
+ * @param bytes: Byte counter, NULL for calls without bytes.
+ */
+static inline void flink_stats_call(flink_stats* stats, uint64_t* counter, uint64_t* bytes, ssize_t result, uint64_t start) {
+	uint64_t time = flink_now_ns() - start;
+
+	__atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+	if(result < 0) __atomic_fetch_add(&stats->errors, 1, __ATOMIC_RELAXED);
+	else if(bytes != NULL) __atomic_fetch_add(bytes, result, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&stats->time_ns, time, __ATOMIC_RELAXED);
+	flink_stats_max(&stats->max_time_ns, time);
+}
+
+#else
+
+#define STATS_START(start)
+#define STATS_INC(stats, counter)                     do { } while(0)
+#define STATS_CALL(stats, counter, bytes, result, start) do { } while(0)
+#define STATS_TXN(txn, results, start)                do { } while(0)
+
+#endif // FLINK_STATS
+
+#endif // FLINKLIB_STATS_H_
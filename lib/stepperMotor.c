@@ -25,6 +25,8 @@
 #include "types.h"
 #include "error.h"
 #include "log.h"
+#include "cache.h"
+#include "layout.h"
 
 #define LOCAL_CONF_OFFSET 0              //number of first register with one channel
 #define LOCAL_CONF_SET_ATOMIC_OFFSET 1   //number to set bit(s) atomic with one channel
@@ -43,15 +45,11 @@
  * private write function
  */
 int flink_stepperMotor_set(flink_subdev* subdev, uint32_t channel, uint32_t register_offset, uint32_t data) {
-	uint32_t offset_header;
-	uint32_t offset_subdev;
 	uint32_t offset;
 
 	dbg_print(" --> Setting stepperMotor register for channel %d on subdevice %d\n", subdev->id, channel);
 	
-	offset_header = HEADER_SIZE + SUBHEADER_SIZE;
-	offset_subdev = STEPPER_MOTOR_FIRST_CONF_OFFSET + subdev->nof_channels * REGISTER_WITH * register_offset+ REGISTER_WITH * channel;
-	offset = offset_header + offset_subdev;
+	offset = layout_reg(subdev, LAYOUT_STEPPER + register_offset, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 
 	if(flink_write(subdev, offset, REGISTER_WITH, &data) != REGISTER_WITH) {
@@ -66,15 +64,11 @@ int flink_stepperMotor_set(flink_subdev* subdev, uint32_t channel, uint32_t regi
  * private read function
  */
 int flink_stepperMotor_get(flink_subdev* subdev, uint32_t channel, uint32_t register_offset, uint32_t* data) {
-	uint32_t offset_header;
-	uint32_t offset_subdev;
 	uint32_t offset;
 		
 	dbg_print("Reading period value from pwm %d of subdevice %d\n", channel, subdev->id);
 	
-	offset_header = HEADER_SIZE + SUBHEADER_SIZE;
-	offset_subdev = STEPPER_MOTOR_FIRST_CONF_OFFSET + subdev->nof_channels * REGISTER_WITH * register_offset+ REGISTER_WITH * channel;
-	offset = offset_header + offset_subdev;
+	offset = layout_reg(subdev, LAYOUT_STEPPER + register_offset, channel);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_read(subdev, offset, REGISTER_WITH, data) != REGISTER_WITH) {
@@ -100,10 +94,10 @@ int flink_stepperMotor_get_baseclock(flink_subdev* subdev, uint32_t* frequency)
 
 	dbg_print("Reading base clock from stepperMotor subdevice %d\n", subdev->id);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE;
+	offset = subdev->layout[LAYOUT_CONSTANT];
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
-	if(flink_read(subdev, offset, REGISTER_WITH, frequency) != REGISTER_WITH) {
+	if(flink_cache_read_constant(subdev, offset, frequency) < 0) {
 		libc_error();
 		return EXIT_ERROR;
 	}
@@ -0,0 +1,121 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, threads                               *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file thread.c
+ *  @brief Threads of the library with CPU pinning and real-time scheduling.
+ *
+ *  A cpu of -1 leaves the thread unpinned, a priority of 0 keeps the
+ *  scheduling of the caller. A priority greater than 0 selects SCHED_FIFO,
+ *  which usually needs CAP_SYS_NICE or an rtprio limit.
+ */
+
+#define _GNU_SOURCE	// pthread_attr_setaffinity_np, pthread_setaffinity_np
+
+#include "flinklib.h"
+#include "error.h"
+#include "thread.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+
+/**
+ * @brief Starts a thread.
+ * @param thread: Contains the started thread.
+ * @param cpu: CPU the thread is pinned to, -1 for no pinning.
+ * @param priority: SCHED_FIFO priority, 0 for the scheduling of the caller.
+ * @param run: Thread function.
+ * @param arg: Argument passed to the thread function.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_thread_start(pthread_t* thread, int cpu, int priority, void* (*run)(void*), void* arg) {
+	pthread_attr_t attr;
+	struct sched_param param;
+	cpu_set_t cpus;
+	int ret;
+
+	pthread_attr_init(&attr);
+	if(cpu >= 0) {
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+	}
+	if(priority > 0) {
+		param.sched_priority = priority;
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+		pthread_attr_setschedparam(&attr, &param);
+	}
+	ret = pthread_create(thread, &attr, run, arg);
+	pthread_attr_destroy(&attr);
+	if(ret != 0) {
+		errno = ret;
+		libc_error();
+		return EXIT_ERROR;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Pins the calling thread to a CPU and sets its real-time priority.
+ * @param cpu: CPU to pin the thread to, -1 for no pinning.
+ * @param priority: SCHED_FIFO priority, 0 to keep the scheduling.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_thread_set_realtime(int cpu, int priority) {
+	struct sched_param param;
+	cpu_set_t cpus;
+	int ret;
+
+	if(cpu >= 0) {
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+		if(ret != 0) {
+			errno = ret;
+			libc_error();
+			return EXIT_ERROR;
+		}
+	}
+	if(priority > 0) {
+		param.sched_priority = priority;
+		ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if(ret != 0) {
+			errno = ret;
+			libc_error();
+			return EXIT_ERROR;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Current time of CLOCK_MONOTONIC in ns.
+ */
+uint64_t flink_now_ns(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+/**
+ * @brief Sleeps until an absolute time of CLOCK_MONOTONIC.
+ * @param ns: Wake up time in ns.
+ */
+void flink_sleep_until(uint64_t ns) {
+	struct timespec t;
+	t.tv_sec = ns / 1000000000ull;
+	t.tv_nsec = ns % 1000000000ull;
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR);
+}
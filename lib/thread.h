@@ -0,0 +1,30 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, threads                               *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file thread.h
+ *  @brief Threads of the library with CPU pinning and real-time scheduling.
+ */
+
+#ifndef FLINKLIB_THREAD_H_
+#define FLINKLIB_THREAD_H_
+
+#include <pthread.h>
+#include <stdint.h>
+
+int      flink_thread_start(pthread_t* thread, int cpu, int priority, void* (*run)(void*), void* arg);
+int      flink_thread_set_realtime(int cpu, int priority);
+uint64_t flink_now_ns(void);
+void     flink_sleep_until(uint64_t ns);
+
+#endif // FLINKLIB_THREAD_H_
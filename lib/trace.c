@@ -0,0 +1,692 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, record and replay                     *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file trace.c
+ *  @brief Backends recording the register traffic of a device and replaying it.
+ *
+ *  "record:<device>;trace=<file>" opens <device> with its own backend and
+ *  appends every register and bit access to the trace file: time, subdevice,
+ *  offset, size or bit, direction, failure and data. The records are collected
+ *  in a buffer which is written when full, on flink_record_flush() and on close.
+ *
+ *  "replay:<file>" opens a device without hardware from a trace. It has the
+ *  recorded subdevices and serves the recorded reads: an access is matched
+ *  with the next record of the same kind, subdevice, offset and size, records
+ *  of accesses not made any more are skipped. A read without later record gets
+ *  the data of the latest earlier one. Written data is compared with the
+ *  recording, writes without record are accepted. The replay does not wait for the recorded times.
+ *
+ *  Trace file: a trace_header, one trace_subdev per subdevice, then the records.
+ *  A record is a trace_record followed by its data, size bytes for a register
+ *  access and one byte for a bit access. A failed read has no data, a failed
+ *  access ends with the error code. All values are in host byte order.
+ */
+
+#include "flinklib.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "backend.h"
+#include "thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TRACE_MAGIC			"FLINKTRC"
+#define TRACE_VERSION		1
+#define TRACE_OPTION		";trace="
+#define TRACE_BUFFER_SIZE	65536	// byte
+
+// Kinds of records
+#define TRACE_READ			0
+#define TRACE_WRITE			1
+#define TRACE_READ_BIT		2
+#define TRACE_WRITE_BIT		3
+
+typedef struct _trace_header {
+	char     magic[8];				/// TRACE_MAGIC
+	uint32_t version;				/// TRACE_VERSION
+	uint32_t nof_subdevices;		/// Nof trace_subdev following the header
+} trace_header;
+
+typedef struct _trace_subdev {
+	uint16_t function_id;
+	uint8_t  id;
+	uint8_t  sub_function_id;
+	uint8_t  function_version;
+	uint8_t  reserved[3];
+	uint32_t base_addr;
+	uint32_t mem_size;
+	uint32_t nof_channels;
+	uint32_t unique_id;
+} trace_subdev;
+
+typedef struct _trace_record {
+	uint64_t timestamp_ns;			/// Time the access completed, since the device was opened
+	uint32_t offset;				/// Register offset within the subdevice
+	uint8_t  subdev;				/// Subdevice id
+	uint8_t  kind;					/// TRACE_READ, TRACE_WRITE, TRACE_READ_BIT or TRACE_WRITE_BIT
+	uint8_t  size;					/// Nof bytes, the bit number for bit accesses
+	uint8_t  failed;				/// Access failed, the data is followed by the error code
+} trace_record;
+
+typedef struct _recorder {
+	const flink_backend* inner;		/// Backend of the recorded device, uses the priv of the device
+	int            fd;				/// Trace file
+	uint64_t       start_ns;		/// Time the device was opened
+	pthread_mutex_t lock;			/// Protects the buffer
+	uint8_t        failed;			/// Writing the trace failed, recording stopped
+	size_t         used;			/// Bytes in the buffer
+	uint8_t        buffer[TRACE_BUFFER_SIZE];
+} recorder;
+
+typedef struct _replayer {
+	uint8_t*       data;			/// Trace file
+	size_t         size;			/// Size of the trace file
+	trace_subdev*  subdevs;			/// Recorded subdevices
+	uint32_t       nof_subdevs;
+	size_t*        records;			/// Position of every record in data
+	size_t         nof_records;
+	size_t         cursor;			/// Next record to match
+	pthread_mutex_t lock;			/// Protects the cursor and the statistics
+	flink_replay_stats stats;
+} replayer;
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Nof data bytes of a record.
+ */
+static inline size_t data_size(const trace_record* rec) {
+	if(rec->failed && (rec->kind == TRACE_READ || rec->kind == TRACE_READ_BIT)) return 0;
+	return (rec->kind == TRACE_READ || rec->kind == TRACE_WRITE) ? rec->size : 1;
+}
+
+/**
+ * @brief Nof bytes following a record.
+ */
+static inline size_t payload_size(const trace_record* rec) {
+	return data_size(rec) + (rec->failed ? sizeof(int32_t) : 0);
+}
+
+/**
+ * @brief Writes a block completely to a file.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+static int write_all(int fd, const uint8_t* data, size_t size) {
+	ssize_t n;
+
+	while(size > 0) {
+		n = write(fd, data, size);
+		if(n < 0) {
+			libc_error();
+			return EXIT_ERROR;
+		}
+		data += n;
+		size -= n;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Writes the buffer to the trace file, the recorder must be locked.
+ */
+static int flush_buffer(recorder* rec) {
+	int ret = EXIT_SUCCESS;
+
+	if(rec->used > 0 && !rec->failed) {
+		ret = write_all(rec->fd, rec->buffer, rec->used);
+		if(ret != EXIT_SUCCESS) rec->failed = 1;
+	}
+	rec->used = 0;
+	return ret;
+}
+
+/**
+ * @brief Appends a block to the buffer, the recorder must be locked.
+ */
+static void append(recorder* rec, const void* data, size_t size) {
+	if(rec->used + size > TRACE_BUFFER_SIZE) flush_buffer(rec);
+	if(size > TRACE_BUFFER_SIZE) { // larger than the buffer, e.g. the subdevice table of a large device
+		if(!rec->failed && write_all(rec->fd, data, size) != EXIT_SUCCESS) rec->failed = 1;
+		return;
+	}
+	memcpy(rec->buffer + rec->used, data, size);
+	rec->used += size;
+}
+
+/**
+ * @brief Appends an access to the trace, the recorder must be locked.
+ */
+static void append_access(recorder* rec, uint64_t now, flink_subdev* subdev, uint8_t kind, uint32_t offset, uint8_t size, int32_t error, const void* data) {
+	trace_record r = { .timestamp_ns = now - rec->start_ns, .offset = offset, .subdev = subdev->id, .kind = kind, .size = size, .failed = error != 0 };
+
+	append(rec, &r, sizeof(r));
+	append(rec, data, data_size(&r));
+	if(error) append(rec, &error, sizeof(error));
+}
+
+/**
+ * @brief Records an access.
+ */
+static void record(flink_dev* dev, flink_subdev* subdev, uint8_t kind, uint32_t offset, uint8_t size, int failed, const void* data) {
+	recorder* rec = dev->recorder;
+	int32_t error = failed ? flink_errno : 0;
+	uint64_t now = flink_now_ns();
+
+	pthread_mutex_lock(&rec->lock);
+	append_access(rec, now, subdev, kind, offset, size, error, data);
+	pthread_mutex_unlock(&rec->lock);
+}
+
+/**
+ * @brief Reads a whole trace file into memory.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+static int load_trace(replayer* rp, const char* path) {
+	struct stat st;
+	ssize_t n;
+	size_t pos = 0;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if(fd < 0 || fstat(fd, &st) < 0) {
+		libc_error();
+		if(fd >= 0) close(fd);
+		return EXIT_ERROR;
+	}
+	rp->size = st.st_size;
+	rp->data = malloc(rp->size > 0 ? rp->size : 1);
+	if(rp->data == NULL) {
+		libc_error();
+		close(fd);
+		return EXIT_ERROR;
+	}
+	while(pos < rp->size && (n = read(fd, rp->data + pos, rp->size - pos)) > 0) pos += n;
+	close(fd);
+	if(pos < rp->size) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Checks the header of a loaded trace and finds its records.
+ *
+ * A trace ending within a record, e.g. of a process which was killed, ends
+ * with the last complete record.
+ *
+ * @return int: 0 on success, -1 if the file is not a trace.
+ */
+static int index_trace(replayer* rp) {
+	trace_header* hdr = (trace_header*)rp->data;
+	trace_record rec;
+	size_t pos, n = 0;
+
+	if(rp->size < sizeof(trace_header) || memcmp(hdr->magic, TRACE_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != TRACE_VERSION) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	rp->nof_subdevs = hdr->nof_subdevices;
+	pos = sizeof(trace_header) + (size_t)rp->nof_subdevs * sizeof(trace_subdev);
+	if(rp->nof_subdevs > UINT8_MAX + 1 || pos > rp->size) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	rp->subdevs = (trace_subdev*)(rp->data + sizeof(trace_header));
+
+	// count the records, then store their positions
+	for(; pos + sizeof(rec) <= rp->size; n++) {
+		memcpy(&rec, rp->data + pos, sizeof(rec));
+		if(pos + sizeof(rec) + payload_size(&rec) > rp->size) break;
+		pos += sizeof(rec) + payload_size(&rec);
+	}
+	rp->records = malloc((n > 0 ? n : 1) * sizeof(size_t));
+	if(rp->records == NULL) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+	pos = sizeof(trace_header) + (size_t)rp->nof_subdevs * sizeof(trace_subdev);
+	for(rp->nof_records = 0; rp->nof_records < n; rp->nof_records++) {
+		rp->records[rp->nof_records] = pos;
+		memcpy(&rec, rp->data + pos, sizeof(rec));
+		pos += sizeof(rec) + payload_size(&rec);
+	}
+	rp->stats.records = rp->nof_records;
+	dbg_print("trace with %u subdevices and %zu records\n", rp->nof_subdevs, rp->nof_records);
+	return EXIT_SUCCESS;
+}
+
+static void free_replayer(replayer* rp) {
+	if(rp == NULL) return;
+	pthread_mutex_destroy(&rp->lock);
+	free(rp->records);
+	free(rp->data);
+	free(rp);
+}
+
+static inline int matches(const trace_record* rec, flink_subdev* subdev, uint8_t kind, uint32_t offset, uint8_t size) {
+	return rec->kind == kind && rec->subdev == subdev->id && rec->offset == offset && rec->size == size;
+}
+
+/**
+ * @brief Finds the record of an access and advances the cursor past it.
+ *
+ * Records before the match are skipped. A read without later record gets the latest
+ * earlier one and the cursor is kept.
+ *
+ * @param rec: Contains the record header.
+ * @return uint8_t*: Data of the record, NULL if the access is not in the trace.
+ */
+static const uint8_t* find_record(replayer* rp, flink_subdev* subdev, uint8_t kind, uint32_t offset, uint8_t size, trace_record* rec) {
+	const uint8_t* data = NULL;
+	size_t i;
+
+	pthread_mutex_lock(&rp->lock);
+	for(i = rp->cursor; i < rp->nof_records; i++) {
+		memcpy(rec, rp->data + rp->records[i], sizeof(*rec));
+		if(matches(rec, subdev, kind, offset, size)) {
+			rp->stats.skipped += i - rp->cursor;
+			rp->stats.matched++;
+			rp->cursor = i + 1;
+			data = rp->data + rp->records[i] + sizeof(*rec);
+			break;
+		}
+	}
+	for(i = rp->cursor; data == NULL && (kind == TRACE_READ || kind == TRACE_READ_BIT) && i > 0; i--) {
+		memcpy(rec, rp->data + rp->records[i - 1], sizeof(*rec));
+		if(matches(rec, subdev, kind, offset, size)) {
+			rp->stats.repeated++;
+			data = rp->data + rp->records[i - 1] + sizeof(*rec);
+		}
+	}
+	if(data == NULL) rp->stats.missing++;
+	pthread_mutex_unlock(&rp->lock);
+	return data;
+}
+
+/**
+ * @brief Counts written data differing from the recording.
+ */
+static void compare_write(replayer* rp, const uint8_t* recorded, const void* data, size_t size) {
+	if(recorded != NULL && memcmp(recorded, data, size) != 0) {
+		pthread_mutex_lock(&rp->lock);
+		rp->stats.mismatched++;
+		pthread_mutex_unlock(&rp->lock);
+	}
+}
+
+/**
+ * @brief Fails an access like the recorded one.
+ * @return int: -1.
+ */
+static int replay_error(const trace_record* rec, const uint8_t* data) {
+	int32_t error;
+
+	memcpy(&error, data + data_size(rec), sizeof(error));
+	flink_error(error);
+	return EXIT_ERROR;
+}
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Record backend operations                                      *
+ *                                                                 *
+ *******************************************************************/
+
+static int record_open(flink_dev* dev, const char* path) {
+	const flink_backend* inner;
+	const char* inner_path;
+	const char* option = NULL;
+	const char* p;
+	recorder* rec;
+	char* name;
+
+	for(p = strstr(path, TRACE_OPTION); p != NULL; p = strstr(p + 1, TRACE_OPTION)) option = p;
+	if(option == NULL || option[strlen(TRACE_OPTION)] == '\0') {
+		flink_error(FLINK_EINVALDEV);
+		return EXIT_ERROR;
+	}
+	name = strndup(path, option - path);
+	rec = calloc(1, sizeof(recorder));
+	if(name == NULL || rec == NULL) {
+		libc_error();
+		free(name);
+		free(rec);
+		return EXIT_ERROR;
+	}
+	rec->fd = open(option + strlen(TRACE_OPTION), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if(rec->fd < 0) {
+		libc_error();
+		free(name);
+		free(rec);
+		return EXIT_ERROR;
+	}
+
+	// the recorded device is opened with its own backend, which may replace itself
+	inner = flink_find_backend(name, &inner_path);
+	if(inner == &flink_record_backend) flink_error(FLINK_EINVALDEV);
+	dev->backend = inner;
+	if(inner == &flink_record_backend || inner->open(dev, inner_path) < 0) {
+		close(rec->fd);
+		free(name);
+		free(rec);
+		dev->backend = &flink_record_backend;
+		return EXIT_ERROR;
+	}
+	free(name);
+	pthread_mutex_init(&rec->lock, NULL);
+	rec->inner = dev->backend;
+	rec->start_ns = flink_now_ns();
+	dev->backend = &flink_record_backend;
+	dev->recorder = rec;
+	return EXIT_SUCCESS;
+}
+
+static int record_close(flink_dev* dev) {
+	recorder* rec = dev->recorder;
+	int ret;
+
+	pthread_mutex_lock(&rec->lock);
+	flush_buffer(rec);
+	pthread_mutex_unlock(&rec->lock);
+	close(rec->fd);
+	ret = rec->inner->close(dev);
+	pthread_mutex_destroy(&rec->lock);
+	free(rec);
+	dev->recorder = NULL;
+	return ret;
+}
+
+static int record_count(flink_dev* dev) {
+	return ((recorder*)dev->recorder)->inner->count(dev);
+}
+
+/**
+ * @brief Enumerates the recorded device and writes the header of the trace with its subdevices.
+ */
+static int record_enumerate(flink_dev* dev) {
+	recorder* rec = dev->recorder;
+	trace_header hdr = { .magic = TRACE_MAGIC, .version = TRACE_VERSION, .nof_subdevices = dev->nof_subdevices };
+	trace_subdev sub;
+	int n, i;
+
+	n = rec->inner->enumerate(dev);
+	if(n < 0) return n;
+
+	pthread_mutex_lock(&rec->lock);
+	append(rec, &hdr, sizeof(hdr));
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		flink_subdev* subdev = dev->subdevices + i;
+		memset(&sub, 0, sizeof(sub));
+		sub.function_id      = subdev->function_id;
+		sub.id               = subdev->id;
+		sub.sub_function_id  = subdev->sub_function_id;
+		sub.function_version = subdev->function_version;
+		sub.base_addr        = subdev->base_addr;
+		sub.mem_size         = subdev->mem_size;
+		sub.nof_channels     = subdev->nof_channels;
+		sub.unique_id        = subdev->unique_id;
+		append(rec, &sub, sizeof(sub));
+	}
+	pthread_mutex_unlock(&rec->lock);
+	return n;
+}
+
+static int record_ioctl(flink_dev* dev, int cmd, void* arg) {
+	return ((recorder*)dev->recorder)->inner->ioctl(dev, cmd, arg);
+}
+
+static ssize_t record_read(flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata) {
+	ssize_t ret = ((recorder*)subdev->parent->recorder)->inner->read(subdev, offset, size, rdata);
+	record(subdev->parent, subdev, TRACE_READ, offset, size, ret < 0, rdata);
+	return ret;
+}
+
+static ssize_t record_write(flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata) {
+	ssize_t ret = ((recorder*)subdev->parent->recorder)->inner->write(subdev, offset, size, wdata);
+	record(subdev->parent, subdev, TRACE_WRITE, offset, size, ret < 0, wdata);
+	return ret;
+}
+
+static int record_read_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t* value) {
+	int ret = ((recorder*)subdev->parent->recorder)->inner->read_bit(subdev, offset, bit, value);
+	record(subdev->parent, subdev, TRACE_READ_BIT, offset, bit, ret < 0, value);
+	return ret;
+}
+
+static int record_write_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t value) {
+	int ret = ((recorder*)subdev->parent->recorder)->inner->write_bit(subdev, offset, bit, value);
+	record(subdev->parent, subdev, TRACE_WRITE_BIT, offset, bit, ret < 0, &value);
+	return ret;
+}
+
+/**
+ * @brief Executes a transaction with the recorded backend and records its operations together.
+ */
+static int record_transfer(flink_dev* dev, flink_op* ops, size_t nof_ops, ssize_t* results) {
+	recorder* rec = dev->recorder;
+	const flink_backend* inner = rec->inner;
+	int ret = EXIT_SUCCESS;
+	uint64_t now;
+	size_t i;
+
+	if(inner->transfer) {
+		ret = inner->transfer(dev, ops, nof_ops, results);
+	}
+	else {
+		for(i = 0; i < nof_ops; i++) {
+			flink_op* op = ops + i;
+			if(op->write) results[i] = inner->write(op->subdev, op->offset, op->size, op->data);
+			else          results[i] = inner->read(op->subdev, op->offset, op->size, op->data);
+			if(results[i] < 0) ret = EXIT_ERROR;
+		}
+	}
+
+	now = flink_now_ns();
+	pthread_mutex_lock(&rec->lock);
+	for(i = 0; i < nof_ops; i++) {
+		flink_op* op = ops + i;
+		append_access(rec, now, op->subdev, op->write ? TRACE_WRITE : TRACE_READ, op->offset, op->size, results[i] < 0 ? flink_errno : 0, op->data);
+	}
+	pthread_mutex_unlock(&rec->lock);
+	return ret;
+}
+
+const flink_backend flink_record_backend = {
+	.scheme    = "record",
+	.open      = record_open,
+	.close     = record_close,
+	.count     = record_count,
+	.enumerate = record_enumerate,
+	.ioctl     = record_ioctl,
+	.read      = record_read,
+	.write     = record_write,
+	.read_bit  = record_read_bit,
+	.write_bit = record_write_bit,
+	.transfer  = record_transfer,
+};
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Replay backend operations                                      *
+ *                                                                 *
+ *******************************************************************/
+
+static int replay_open(flink_dev* dev, const char* path) {
+	replayer* rp = calloc(1, sizeof(replayer));
+
+	if(rp == NULL) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+	pthread_mutex_init(&rp->lock, NULL);
+	if(load_trace(rp, path) != EXIT_SUCCESS || index_trace(rp) != EXIT_SUCCESS) {
+		free_replayer(rp);
+		return EXIT_ERROR;
+	}
+	dev->fd = -1;
+	dev->priv = rp;
+	return EXIT_SUCCESS;
+}
+
+static int replay_close(flink_dev* dev) {
+	free_replayer(dev->priv);
+	dev->priv = NULL;
+	return EXIT_SUCCESS;
+}
+
+static int replay_count(flink_dev* dev) {
+	return ((replayer*)dev->priv)->nof_subdevs;
+}
+
+static int replay_enumerate(flink_dev* dev) {
+	replayer* rp = dev->priv;
+	int i;
+
+	for(i = 0; i < dev->nof_subdevices; i++) {
+		flink_subdev* subdev = dev->subdevices + i;
+		trace_subdev* sub = rp->subdevs + i;
+		subdev->id               = sub->id;
+		subdev->function_id      = sub->function_id;
+		subdev->sub_function_id  = sub->sub_function_id;
+		subdev->function_version = sub->function_version;
+		subdev->base_addr        = sub->base_addr;
+		subdev->mem_size         = sub->mem_size;
+		subdev->nof_channels     = sub->nof_channels;
+		subdev->unique_id        = sub->unique_id;
+		subdev->parent           = dev;
+	}
+	return dev->nof_subdevices;
+}
+
+static ssize_t replay_read(flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata) {
+	trace_record rec;
+	const uint8_t* data = find_record(subdev->parent->priv, subdev, TRACE_READ, offset, size, &rec);
+
+	if(data == NULL) {
+		flink_error(FLINK_EINVALOFFS);
+		return EXIT_ERROR;
+	}
+	if(rec.failed) return replay_error(&rec, data);
+	memcpy(rdata, data, size);
+	return size;
+}
+
+static ssize_t replay_write(flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata) {
+	trace_record rec;
+	const uint8_t* data = find_record(subdev->parent->priv, subdev, TRACE_WRITE, offset, size, &rec);
+
+	compare_write(subdev->parent->priv, data, wdata, size);
+	if(data != NULL && rec.failed) return replay_error(&rec, data);
+	return size;
+}
+
+static int replay_read_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t* value) {
+	trace_record rec;
+	const uint8_t* data = find_record(subdev->parent->priv, subdev, TRACE_READ_BIT, offset, bit, &rec);
+
+	if(data == NULL) {
+		flink_error(FLINK_EINVALOFFS);
+		return EXIT_ERROR;
+	}
+	if(rec.failed) return replay_error(&rec, data);
+	*value = *data;
+	return EXIT_SUCCESS;
+}
+
+static int replay_write_bit(flink_subdev* subdev, uint32_t offset, uint8_t bit, uint8_t value) {
+	trace_record rec;
+	const uint8_t* data = find_record(subdev->parent->priv, subdev, TRACE_WRITE_BIT, offset, bit, &rec);
+
+	compare_write(subdev->parent->priv, data, &value, 1);
+	if(data != NULL && rec.failed) return replay_error(&rec, data);
+	return EXIT_SUCCESS;
+}
+
+const flink_backend flink_replay_backend = {
+	.scheme    = "replay",
+	.open      = replay_open,
+	.close     = replay_close,
+	.count     = replay_count,
+	.enumerate = replay_enumerate,
+	.ioctl     = flink_emulate_ioctl,
+	.read      = replay_read,
+	.write     = replay_write,
+	.read_bit  = replay_read_bit,
+	.write_bit = replay_write_bit,
+};
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Writes the buffered records of a recorded device to its trace file.
+ * @param dev: Device opened with "record:".
+ * @return int: 0 on success, -1 in case of failure or if the device is not recorded.
+ */
+int flink_record_flush(flink_dev* dev) {
+	recorder* rec;
+	int ret;
+
+	if(dev == NULL || dev->backend != &flink_record_backend) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	rec = dev->recorder;
+	pthread_mutex_lock(&rec->lock);
+	ret = flush_buffer(rec);
+	if(rec->failed) ret = EXIT_ERROR;
+	pthread_mutex_unlock(&rec->lock);
+	return ret;
+}
+
+/**
+ * @brief Reads how the accesses of a replayed device matched the trace.
+ * @param dev: Device opened with "replay:".
+ * @param stats: Contains the statistics.
+ * @return int: 0 on success, -1 in case of failure or if the device is not replayed.
+ */
+int flink_replay_get_stats(flink_dev* dev, flink_replay_stats* stats) {
+	replayer* rp;
+
+	if(stats == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(dev == NULL || dev->backend != &flink_replay_backend) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return EXIT_ERROR;
+	}
+	rp = dev->priv;
+	pthread_mutex_lock(&rp->lock);
+	*stats = rp->stats;
+	pthread_mutex_unlock(&rp->lock);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+/*******************************************************************
+ *   _________     _____      _____    ____  _____    ___  ____    *
+ *  |_   ___  |  |_   _|     |_   _|  |_   \|_   _|  |_  ||_  _|   *
+ *    | |_  \_|    | |         | |      |   \ | |      | |_/ /     *
+ *    |  _|        | |   _     | |      | |\ \| |      |  __'.     *
+ *   _| |_        _| |__/ |   _| |_    _| |_\   |_    _| |  \ \_   *
+ *  |_____|      |________|  |_____|  |_____|\____|  |____||____|  *
+ *                                                                 *
+ *******************************************************************
+ *                                                                 *
+ *  flink userspace library, register transactions                 *
+ *                                                                 *
+ *******************************************************************/
+
+/** @file txn.c
+ *  @brief Vectored register accesses.
+ *
+ *  A transaction collects register reads and writes on any subdevices
+ *  of one device and submits them to the backend at once. Backends with
+ *  a transfer operation execute the whole transaction in one access,
+ *  all others execute the operations one after the other.
+ *
+ *  A committed transaction keeps its operations, so a cyclic application
+ *  builds it once and commits it in every cycle.
+ */
+
+#include "flinklib.h"
+#include "types.h"
+#include "error.h"
+#include "log.h"
+#include "valid.h"
+#include "backend.h"
+#include "cache.h"
+#include "stats.h"
+
+#include <stdlib.h>
+
+#define TXN_INITIAL_CAPACITY 16
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+static int add_op(flink_txn* txn, flink_subdev* subdev, uint32_t offset, uint8_t size, void* data, uint8_t write) {
+	flink_op* ops;
+	ssize_t* results;
+	size_t capacity;
+
+	if(txn == NULL || data == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(subdev == NULL || !validate_flink_subdev(subdev) || subdev->parent != txn->dev) {
+		flink_error(FLINK_EINVALSUBDEV);
+		return EXIT_ERROR;
+	}
+
+	if(txn->nof_ops == txn->capacity) { // grow
+		capacity = txn->capacity ? 2 * txn->capacity : TXN_INITIAL_CAPACITY;
+		ops = realloc(txn->ops, capacity * sizeof(flink_op));
+		if(ops == NULL) {
+			libc_error();
+			return EXIT_ERROR;
+		}
+		txn->ops = ops;
+		results = realloc(txn->results, capacity * sizeof(ssize_t));
+		if(results == NULL) {
+			libc_error();
+			return EXIT_ERROR;
+		}
+		txn->results = results;
+		txn->capacity = capacity;
+	}
+
+	ops = txn->ops + txn->nof_ops++;
+	ops->subdev = subdev;
+	ops->offset = offset;
+	ops->size   = size;
+	ops->write  = write;
+	ops->data   = data;
+	return EXIT_SUCCESS;
+}
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Starts a new transaction on a device.
+ * @param dev: Flink device handle.
+ * @return flink_txn*: Empty transaction or NULL in case of failure.
+ */
+flink_txn* flink_txn_begin(flink_dev* dev) {
+	flink_txn* txn;
+
+	if(!validate_flink_dev(dev)) {
+		flink_error(FLINK_EINVALDEV);
+		return NULL;
+	}
+
+	txn = calloc(1, sizeof(flink_txn));
+	if(txn == NULL) {
+		libc_error();
+		return NULL;
+	}
+	txn->dev = dev;
+	return txn;
+}
+
+
+/**
+ * @brief Adds a register read to a transaction.
+ * @param txn: Transaction.
+ * @param subdev: Subdevice to read from, must belong to the device of the transaction.
+ * @param offset: Read offset, relative to the subdevice base address.
+ * @param size: Nof bytes to read.
+ * @param rdata: Buffer receiving the bytes when the transaction is committed.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_txn_add_read(flink_txn* txn, flink_subdev* subdev, uint32_t offset, uint8_t size, void* rdata) {
+	return add_op(txn, subdev, offset, size, rdata, 0);
+}
+
+
+/**
+ * @brief Adds a register write to a transaction.
+ *
+ * The data is taken from the buffer when the transaction is committed.
+ *
+ * @param txn: Transaction.
+ * @param subdev: Subdevice to write to, must belong to the device of the transaction.
+ * @param offset: Write offset, relative to the subdevice base address.
+ * @param size: Nof bytes to write.
+ * @param wdata: Buffer holding the bytes to write.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_txn_add_write(flink_txn* txn, flink_subdev* subdev, uint32_t offset, uint8_t size, void* wdata) {
+	return add_op(txn, subdev, offset, size, wdata, 1);
+}
+
+
+/**
+ * @brief Executes all operations of a transaction in the order they were added.
+ *
+ * Writes to cached subdevices are written to the device after the pending writes
+ * of these subdevices, the caches take the written values.
+ *
+ * @param txn: Transaction.
+ * @param results: Array with one entry per operation, receiving the nof bytes
+ *                 transferred or -1. May be NULL.
+ * @return int: 0 if all operations succeeded, -1 if at least one failed.
+ */
+int flink_txn_commit(flink_txn* txn, ssize_t* results) {
+	ssize_t* res;
+	size_t i;
+
+	if(txn == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(txn->nof_ops == 0) return EXIT_SUCCESS;
+
+	dbg_print("committing transaction with %zu operations\n", txn->nof_ops);
+
+	res = results ? results : txn->results;
+	for(i = 0; i < txn->nof_ops; i++) {
+		if(txn->ops[i].write && __atomic_load_n(&txn->ops[i].subdev->shadow, __ATOMIC_ACQUIRE) != NULL) {
+			return flink_cache_commit(txn, res);
+		}
+	}
+	return flink_txn_transfer(txn, res);
+}
+
+
+/**
+ * @brief Executes the operations of a transaction with the backend, bypassing the caches.
+ * @param txn: Transaction with at least one operation.
+ * @param results: Array with one entry per operation, receiving the nof bytes transferred or -1.
+ * @return int: 0 if all operations succeeded, -1 if at least one failed.
+ */
+int flink_txn_transfer(flink_txn* txn, ssize_t* results) {
+	const flink_backend* backend = txn->dev->backend;
+	int ret = EXIT_SUCCESS;
+	size_t i;
+
+	STATS_START(start);
+	if(backend->transfer) {
+		ret = backend->transfer(txn->dev, txn->ops, txn->nof_ops, results);
+	}
+	else {
+		for(i = 0; i < txn->nof_ops; i++) { // no batch access, one access per operation
+			flink_op* op = txn->ops + i;
+			if(op->write) results[i] = backend->write(op->subdev, op->offset, op->size, op->data);
+			else          results[i] = backend->read(op->subdev, op->offset, op->size, op->data);
+			if(results[i] < 0) ret = EXIT_ERROR;
+		}
+	}
+	STATS_TXN(txn, results, start);
+	return ret;
+}
+
+
+/**
+ * @brief Releases a transaction.
+ * @param txn: Transaction, may be NULL.
+ */
+void flink_txn_free(flink_txn* txn) {
+	if(txn == NULL) return;
+	free(txn->ops);
+	free(txn->results);
+	free(txn);
+}
@@ -23,12 +23,32 @@
 #define FLINKLIB_TYPES_H_
 
 #include "stdint.h"
+#include <stddef.h>
+#include <sys/types.h>
+#include <signal.h>
+#include <pthread.h>
 #include "flinklib.h"
 
+#define LAYOUT_SIZE 9	// register groups per subdevice
+#define IRQ_DISPATCH_MAX 32	// IRQs handled by a dispatcher
+#define CACHE_LINE_SIZE 64	// byte
+
+typedef struct _flink_backend flink_backend;
+
 struct _flink_dev {
+	const flink_backend* backend;		/// Transport used to access the device
+	void*          priv;				/// Private data of the backend
 	int            fd;					/// File descriptor of open flink device file
 	uint8_t        nof_subdevices;		/// Number of subdevices
 	flink_subdev*  subdevices;			/// Linked list of all subdevices of a device
+	void*          map;					/// Mapped device memory, NULL if accessed by ioctl
+	size_t         map_size;			/// Size of the mapped device memory
+	flink_txn*     flush_txn;			/// Transaction writing the dirty cached registers of all subdevices
+	pthread_mutex_t flush_lock;			/// Serializes the flushes of all subdevices
+	void*          recorder;			/// Trace of the record backend, priv belongs to the recorded backend
+#ifdef FLINK_STATS
+	flink_stats    stats;				/// Device wide counters, the subdevice counters are added on reading
+#endif
 };
 
 struct _flink_subdev {
@@ -41,6 +61,124 @@ struct _flink_subdev {
 	uint32_t       nof_channels;		/// Number of channels
 	uint32_t       unique_id;			/// Unique id, must be unique for a certain subdevice
 	flink_dev*     parent;				/// The device this subdevice belongs to
+	volatile uint8_t* regs;				/// Mapped registers of the subdevice, NULL if accessed by ioctl
+	uint32_t*      shadow;				/// Cached registers, NULL if not cached
+	uint32_t*      dirty;				/// Bitmap of cached registers to write
+	uint32_t       shadow_size;			/// Size of the cached register range
+	uint32_t       constant;			/// Base clock or resolution, valid if constant_valid is set
+	uint8_t        constant_valid;		/// Constant was read from the device
+	uint32_t       layout[LAYOUT_SIZE];	/// Offsets of the register groups of the function
+	flink_txn*     flush_txn;			/// Transaction writing the dirty cached registers of this subdevice
+	pthread_mutex_t lock;				/// Protects the cache and serializes bit writes
+#ifdef FLINK_STATS
+	flink_stats    stats;				/// Accesses of this subdevice
+#endif
+};
+
+typedef struct _flink_op {
+	flink_subdev*  subdev;				/// Subdevice to access
+	uint32_t       offset;				/// Register offset within the subdevice
+	uint8_t        size;				/// Nof bytes to transfer
+	uint8_t        write;				/// 1 for a write, 0 for a read
+	void*          data;				/// Buffer of the caller
+} flink_op;
+
+struct _flink_txn {
+	flink_dev*     dev;					/// Device all operations belong to
+	size_t         nof_ops;				/// Number of collected operations
+	size_t         capacity;			/// Number of allocated operations
+	flink_op*      ops;					/// Collected operations
+	ssize_t*       results;				/// Results of the last commit
+};
+
+struct _flink_snapshot {
+	flink_txn*     reads;				/// Reads of the registers, neighbouring registers in one operation
+	size_t*        fields;				/// Offset in the caller's struct of each operation
+	size_t         size;				/// Struct size needed, end of the last field
+	void*          data;				/// Struct the operations point to since the last capture
+};
+
+struct _flink_irq {
+	flink_dev*     dev;					/// Device the IRQs are registered on
+	int            fd;					/// signalfd receiving the signals of the IRQs
+	uint8_t        nof_irqs;			/// Number of registered IRQs
+	uint32_t*      irqs;				/// Registered IRQ numbers
+	int*           signals;				/// Signal number of each IRQ
+};
+
+typedef struct _flink_irq_slot {
+	flink_irq_handler handler;			/// Called with the count of a batch
+	flink_irq_batch_handler batch_handler;	/// Called with the batch, the IRQ is unused if both handlers are NULL
+	void*          arg;					/// Argument passed to the handler
+	uint32_t       max_events;			/// Batch is delivered when it has this many interrupts, 0 for no limit
+	uint64_t       max_delay_ns;		/// Batch is delivered this long after its first interrupt, 0 for no limit
+	flink_irq_batch batch;				/// Interrupts received but not delivered yet
+	flink_irq_stats stats;				/// Counters, the averages hold the sums
+} flink_irq_slot;
+
+struct _flink_irq_dispatcher {
+	flink_dev*     dev;					/// Device the IRQs are registered on
+	pthread_t      thread;				/// Thread registering the IRQs and calling the handlers
+	int            sfd;					/// signalfd receiving the signals of the IRQs
+	int            efd;					/// eventfd waking the thread for a request
+	uint32_t       signal_offset;		/// Signal of IRQ 0
+	sigset_t       signals;				/// Signals of all IRQs the dispatcher handles
+	uint8_t        stop;				/// Set by the stop request
+	pthread_mutex_t lock;				/// Protects the request
+	pthread_cond_t cond;				/// Signals a change of the request state
+	int            req_state;			/// Idle, pending or done
+	int            req_op;				/// Add, remove or stop
+	uint32_t       req_irq;				/// IRQ of the request
+	void*          req_arg;				/// Slot to add or statistics to read
+	int            req_result;			/// Result of the request
+	int            req_error;			/// Error code of a failed request
+	flink_irq_slot slots[IRQ_DISPATCH_MAX];	/// Handler of each IRQ, accessed by the thread only
+};
+
+struct _flink_cyclic {
+	flink_dev*     dev;					/// Device accessed by the cycles
+	uint64_t       period_ns;			/// Cycle period
+	flink_cycle_handler handler;		/// Called in every cycle, may be NULL
+	void*          arg;					/// Argument passed to the handler
+	flink_txn*     reads;				/// Read set, committed before the handler
+	flink_txn*     writes;				/// Write set, committed after the handler
+	int            cpu;					/// CPU the running thread is pinned to, -1 for none
+	int            priority;			/// SCHED_FIFO priority of the running thread, 0 for none
+	uint8_t        lock_memory;			/// Lock the memory of the process before running
+	uint8_t        stop;				/// Set to end the run
+	pthread_mutex_t lock;				/// Protects the statistics
+	flink_cyclic_stats stats;			/// Counters, the averages hold the sums
+};
+
+struct _flink_wd_service {
+	flink_subdev*  subdev;				/// Watchdog subdevice
+	uint32_t       counter;				/// Counter value of the timeout
+	uint64_t       timeout_ns;			/// Watchdog timeout
+	uint64_t       heartbeat_ns;		/// Maximum age of the heartbeat for a kick, 0 to kick always
+	uint64_t       heartbeat;			/// Time of the last heartbeat
+	uint64_t       last_kick;			/// Time of the last kick, 0 before arming
+	int            tfd;					/// timerfd of the kick period
+	int            efd;					/// eventfd waking the thread to stop
+	pthread_t      thread;				/// Thread kicking the watchdog
+	pthread_mutex_t lock;				/// Protects the statistics
+	flink_wd_stats stats;				/// Statistics
+};
+
+struct _flink_sampler {
+	flink_dev*     dev;					/// Device the channels belong to
+	uint64_t       period_ns;			/// Sampling period
+	flink_txn*     reads;				/// Reads of one frame, neighbouring registers in one operation
+	uint32_t       nof_channels;		/// Values per frame
+	uint32_t*      frame;				/// Values of the frame being read
+	uint32_t       capacity;			/// Frames in the ring, a power of two
+	uint64_t*      timestamps;			/// Ring of the frame timestamps
+	uint32_t*      values;				/// Ring of the frame values, nof_channels per frame
+	pthread_t      thread;				/// Sampling thread
+	uint8_t        running;				/// Thread is started
+	uint8_t        stop;				/// Set to end the thread
+	flink_sampler_stats stats;			/// Written by the sampling thread, read with atomics
+	uint64_t       head __attribute__((aligned(CACHE_LINE_SIZE)));	/// Frames written, by the sampling thread only
+	uint64_t       tail __attribute__((aligned(CACHE_LINE_SIZE)));	/// Frames read, by the consumer only
 };
 
 #endif // FLINKLIB_TYPES_H_
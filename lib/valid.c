@@ -26,7 +26,7 @@
  * @return int: 1 if valid, 0 if not valid.
  */
 int validate_flink_dev(flink_dev* dev) {
-	if(dev && dev->fd != 0) {
+	if(dev && dev->backend) {
 		return 1; // device struct valid
 	}
 	return 0;
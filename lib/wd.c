@@ -18,6 +18,11 @@
  *  Contains the high-level functions for a flink subdevice
  *  which realizes the function "watchdog".
  *
+ *  The watchdog service retriggers a watchdog from a thread woken by a
+ *  timerfd at half the timeout. With a heartbeat period, a kick is only
+ *  done if the application signalled a heartbeat within this period, so
+ *  a stalled control loop lets the watchdog expire.
+ *
  *  @author Martin Züger
  */
 
@@ -25,6 +30,94 @@
 #include "types.h"
 #include "error.h"
 #include "log.h"
+#include "cache.h"
+#include "layout.h"
+#include "thread.h"
+#include "valid.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#define WD_KICKS_PER_TIMEOUT	2	// kick period is timeout / WD_KICKS_PER_TIMEOUT
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Internal (private) methods                                     *
+ *                                                                 *
+ *******************************************************************/
+
+/**
+ * @brief Retriggers the watchdog and records the slack of the kick.
+ */
+static void kick(flink_wd_service* wds, uint64_t now, uint8_t healthy, uint64_t expirations) {
+	uint64_t interval = now - wds->last_kick;
+	uint8_t expired = 0, error = 0;
+
+	if(flink_wd_get_status(wds->subdev, &expired) != EXIT_SUCCESS) error = 1;
+	if(healthy) {
+		if(flink_wd_set_counter(wds->subdev, wds->counter) != EXIT_SUCCESS) error = 1;
+		else wds->last_kick = now;
+	}
+
+	pthread_mutex_lock(&wds->lock);
+	wds->stats.timer_overruns += expirations - 1;
+	wds->stats.expired = expired;
+	wds->stats.errors += error;
+	if(!healthy) {
+		wds->stats.missed_heartbeats++;
+	}
+	else if(!error) {
+		wds->stats.kicks++;
+		if(interval > wds->stats.kick_interval_max_ns) wds->stats.kick_interval_max_ns = interval;
+		interval = interval < wds->timeout_ns ? wds->timeout_ns - interval : 0;
+		if(interval < wds->stats.slack_min_ns) wds->stats.slack_min_ns = interval;
+	}
+	pthread_mutex_unlock(&wds->lock);
+}
+
+/**
+ * @brief Watchdog service thread.
+ */
+static void* run_service(void* arg) {
+	flink_wd_service* wds = arg;
+	struct pollfd pfd[2];
+	uint64_t expirations, now, heartbeat;
+
+	pfd[0].fd = wds->tfd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = wds->efd;
+	pfd[1].events = POLLIN;
+
+	for(;;) {
+		if(poll(pfd, 2, -1) < 0) continue; // EINTR
+		if(pfd[1].revents & POLLIN) break;
+		if(!(pfd[0].revents & POLLIN)) continue;
+		if(read(wds->tfd, &expirations, sizeof(expirations)) != sizeof(expirations)) continue;
+
+		now = flink_now_ns();
+		heartbeat = __atomic_load_n(&wds->heartbeat, __ATOMIC_ACQUIRE);
+		kick(wds, now, wds->heartbeat_ns == 0 || now - heartbeat <= wds->heartbeat_ns, expirations);
+	}
+	return NULL;
+}
+
+static void free_service(flink_wd_service* wds) {
+	if(wds->tfd >= 0) close(wds->tfd);
+	if(wds->efd >= 0) close(wds->efd);
+	pthread_mutex_destroy(&wds->lock);
+	free(wds);
+}
+
+
+/*******************************************************************
+ *                                                                 *
+ *  Public methods                                                 *
+ *                                                                 *
+ *******************************************************************/
 
 /**
  * @brief Reads the base clock of a watchdog subdevice
@@ -37,10 +130,10 @@ int flink_wd_get_baseclock(flink_subdev* subdev, uint32_t* base_clk) {
 	
 	dbg_print("Reading base clock from watchdog subdevice %d\n", subdev->id);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE;
+	offset = subdev->layout[LAYOUT_CONSTANT];
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
-	if(flink_read(subdev, offset, REGISTER_WITH, base_clk) != REGISTER_WITH) {
+	if(flink_cache_read_constant(subdev, offset, base_clk) < 0) {
 		libc_error();
 		return EXIT_ERROR;
 	}
@@ -81,7 +174,7 @@ int flink_wd_set_counter(flink_subdev* subdev, uint32_t counter){
 	
 	dbg_print("Setting WD counter on subdevice %d to %d (%x)\n", subdev->id, counter, counter);
 	
-	offset = HEADER_SIZE + SUBHEADER_SIZE + REGISTER_WITH;
+	offset = layout_reg(subdev, LAYOUT_WD_COUNTER, 0);
 	dbg_print("  --> calculated offset is 0x%x!\n", offset);
 	
 	if(flink_write(subdev, offset, REGISTER_WITH, &counter) != REGISTER_WITH) {
@@ -113,3 +206,136 @@ int flink_wd_arm(flink_subdev* subdev){
 	
 	return EXIT_SUCCESS;
 }
+
+/**
+ * @brief Arms a watchdog and starts a thread retriggering it.
+ *
+ * The counter is calculated from the base clock and the timeout. The watchdog is 
+ * armed before the function returns and kicked every timeout / 2 afterwards.
+ *
+ * @param subdev: Watchdog subdevice.
+ * @param timeout_ms: Watchdog timeout in ms.
+ * @param heartbeat_ms: Maximum age of the last flink_wd_service_heartbeat() for a kick, 0 to kick without heartbeat.
+ * @param cpu: CPU the thread is pinned to, -1 for no pinning.
+ * @param priority: SCHED_FIFO priority of the thread, 0 for the default scheduling.
+ * @return flink_wd_service*: Watchdog service or NULL in case of failure.
+ */
+flink_wd_service* flink_wd_service_start(flink_subdev* subdev, uint32_t timeout_ms, uint32_t heartbeat_ms, int cpu, int priority) {
+	flink_wd_service* wds;
+	struct itimerspec period = { { 0, 0 }, { 0, 0 } };
+	uint32_t base_clk;
+	uint64_t counter, kick_ns;
+
+	if(!validate_flink_subdev(subdev) || subdev->function_id != WD_INTERFACE_ID) {
+		flink_error(FLINK_WRONGSUBDEVT);
+		return NULL;
+	}
+	if(timeout_ms == 0) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return NULL;
+	}
+	if(flink_wd_get_baseclock(subdev, &base_clk) != EXIT_SUCCESS) return NULL;
+	counter = (uint64_t)base_clk * timeout_ms / 1000;
+	if(counter > UINT32_MAX) {
+		flink_error(FLINK_ENOTSUPPORTED);
+		return NULL;
+	}
+
+	wds = calloc(1, sizeof(flink_wd_service));
+	if(wds == NULL) {
+		libc_error();
+		return NULL;
+	}
+	wds->subdev = subdev;
+	wds->counter = (uint32_t)counter;
+	wds->timeout_ns = (uint64_t)timeout_ms * 1000000;
+	wds->heartbeat_ns = (uint64_t)heartbeat_ms * 1000000;
+	wds->stats.slack_min_ns = wds->timeout_ns;
+	pthread_mutex_init(&wds->lock, NULL);
+	wds->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	wds->efd = eventfd(0, EFD_CLOEXEC);
+	if(wds->tfd < 0 || wds->efd < 0) {
+		libc_error();
+		free_service(wds);
+		return NULL;
+	}
+
+	// Arm with the first kick
+	if(flink_wd_set_counter(subdev, wds->counter) != EXIT_SUCCESS || flink_wd_arm(subdev) != EXIT_SUCCESS) {
+		free_service(wds);
+		return NULL;
+	}
+	wds->last_kick = flink_now_ns();
+	wds->heartbeat = wds->last_kick;
+
+	kick_ns = wds->timeout_ns / WD_KICKS_PER_TIMEOUT;
+	period.it_interval.tv_sec = kick_ns / 1000000000ull;
+	period.it_interval.tv_nsec = kick_ns % 1000000000ull;
+	period.it_value = period.it_interval;
+	if(timerfd_settime(wds->tfd, 0, &period, NULL) < 0) {
+		libc_error();
+		free_service(wds);
+		return NULL;
+	}
+	if(flink_thread_start(&wds->thread, cpu, priority, run_service, wds) != EXIT_SUCCESS) {
+		free_service(wds);
+		return NULL;
+	}
+	dbg_print("watchdog service: counter %u, kick every %llu ns\n", wds->counter, (unsigned long long)kick_ns);
+	return wds;
+}
+
+/**
+ * @brief Signals that the application is alive. Called from the control loop.
+ * @param wds: Watchdog service.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_wd_service_heartbeat(flink_wd_service* wds) {
+	if(wds == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	__atomic_store_n(&wds->heartbeat, flink_now_ns(), __ATOMIC_RELEASE);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Reads the statistics of a watchdog service.
+ *
+ * The smallest slack tells how much the timeout could be shortened.
+ *
+ * @param wds: Watchdog service.
+ * @param stats: Contains the statistics.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_wd_service_get_stats(flink_wd_service* wds, flink_wd_stats* stats) {
+	if(wds == NULL || stats == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	pthread_mutex_lock(&wds->lock);
+	*stats = wds->stats;
+	pthread_mutex_unlock(&wds->lock);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Stops kicking the watchdog. The watchdog stays armed and expires after the timeout.
+ * @param wds: Watchdog service.
+ * @return int: 0 on success, -1 in case of failure.
+ */
+int flink_wd_service_stop(flink_wd_service* wds) {
+	uint64_t wake = 1;
+
+	if(wds == NULL) {
+		flink_error(FLINK_ENULLPTR);
+		return EXIT_ERROR;
+	}
+	if(write(wds->efd, &wake, sizeof(wake)) != sizeof(wake)) {
+		libc_error();
+		return EXIT_ERROR;
+	}
+	pthread_join(wds->thread, NULL);
+	free_service(wds);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,463 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <ctype.h>
+#include <time.h>
+
+#include <flinklib.h>
+
+#define DEFAULT_DEV        "/dev/flink0"
+#define DEFAULT_CALLS      10000
+#define WARMUP_CALLS       100
+#define MAX_VALUES         64
+#define FUNC_OFFSET        (HEADER_SIZE + SUBHEADER_SIZE)
+#define PERIOD_OFFSET      (FUNC_OFFSET + PWM_FIRSTPWM_OFFSET)
+#define ANY_SUBDEV         0xffff	// any subdevice, the first one is used
+#define NO_SUBDEV          0xfffe	// device functions
+
+// Benchmark flags
+#define WRITES             0x01	// changes the device, only run with -w
+#define SLOW               0x02	// runs a tenth of the calls
+
+typedef struct {
+	const char*       dev_name;
+	flink_dev*        dev;
+	flink_subdev*     subdev;	// subdevice of the benchmark
+	flink_subdev*     last;		// last subdevice of the device
+	flink_fast_subdev fast;
+	flink_txn*        txn;
+	flink_snapshot*   snap;
+	uint32_t          u32;
+	uint8_t           u8;
+	uint32_t          values[MAX_VALUES];
+	uint32_t          masks[MAX_VALUES];
+	char              desc[INFO_DESC_SIZE + 1];
+} bench_ctx;
+
+typedef struct {
+	const char* name;
+	uint16_t    function;		// function of the subdevice used, ANY_SUBDEV or NO_SUBDEV
+	uint8_t     flags;
+	int       (*call)(bench_ctx* c);
+} bench;
+
+typedef struct {
+	uint32_t calls;
+	uint64_t median_ns, p99_ns, p999_ns, max_ns;
+	double   calls_per_s;
+} bench_result;
+
+/*
+ * Device and subdevices
+ */
+static int b_open_close(bench_ctx* c) {
+	flink_dev* dev = flink_open(c->dev_name);
+	if(dev == NULL) return -1;
+	return flink_close(dev);
+}
+static int b_open_mapped_close(bench_ctx* c) {
+	flink_dev* dev = flink_open_mapped(c->dev_name);
+	if(dev == NULL) return -1;
+	return flink_close(dev);
+}
+static int b_get_nof_subdevices(bench_ctx* c) { return flink_get_nof_subdevices(c->dev) > 0 ? 0 : -1; }
+static int b_get_subdevice_by_id(bench_ctx* c) { return flink_get_subdevice_by_id(c->dev, flink_subdevice_get_id(c->last)) != NULL ? 0 : -1; }
+static int b_get_subdevice_by_unique_id(bench_ctx* c) { return flink_get_subdevice_by_unique_id(c->dev, flink_subdevice_get_unique_id(c->last)) != NULL ? 0 : -1; }
+static int b_get_id(bench_ctx* c) { c->u8 = flink_subdevice_get_id(c->subdev); return 0; }
+static int b_get_function(bench_ctx* c) { c->u32 = flink_subdevice_get_function(c->subdev); return 0; }
+static int b_get_subfunction(bench_ctx* c) { c->u8 = flink_subdevice_get_subfunction(c->subdev); return 0; }
+static int b_get_function_version(bench_ctx* c) { c->u8 = flink_subdevice_get_function_version(c->subdev); return 0; }
+static int b_get_baseaddr(bench_ctx* c) { c->u32 = flink_subdevice_get_baseaddr(c->subdev); return 0; }
+static int b_get_memsize(bench_ctx* c) { c->u32 = flink_subdevice_get_memsize(c->subdev); return 0; }
+static int b_get_nofchannels(bench_ctx* c) { c->u32 = flink_subdevice_get_nofchannels(c->subdev); return 0; }
+static int b_get_unique_id(bench_ctx* c) { c->u32 = flink_subdevice_get_unique_id(c->subdev); return 0; }
+static int b_id2str(bench_ctx* c) { return flink_subdevice_id2str(flink_subdevice_get_id(c->subdev)) != NULL ? 0 : -1; }
+static int b_select(bench_ctx* c) { return flink_subdevice_select(c->subdev, NONEXCL_ACCESS); }
+static int b_reset(bench_ctx* c) { return flink_subdevice_reset(c->subdev); }
+static int b_set_cached(bench_ctx* c) { return flink_subdevice_set_cached(c->subdev, 0); }
+static int b_refresh(bench_ctx* c) { return flink_subdevice_refresh(c->subdev); }
+static int b_flush(bench_ctx* c) { return flink_flush(c->dev); }
+
+/*
+ * Low level access, reads use the header of the subdevice, writes the period of pwm channel 0
+ */
+static int b_read(bench_ctx* c) { return flink_read(c->subdev, 0, REGISTER_WITH, &c->u32) == REGISTER_WITH ? 0 : -1; }
+static int b_read_header(bench_ctx* c) { return flink_read(c->subdev, 0, HEADER_SIZE, c->values) == HEADER_SIZE ? 0 : -1; }
+static int b_write(bench_ctx* c) { return flink_write(c->subdev, PERIOD_OFFSET, REGISTER_WITH, &c->u32) == REGISTER_WITH ? 0 : -1; }
+static int b_read_bit(bench_ctx* c) { return flink_read_bit(c->subdev, 0, 0, &c->u8); }
+static int b_write_bit(bench_ctx* c) { c->u8 = 0; return flink_write_bit(c->subdev, PERIOD_OFFSET, 0, &c->u8); }
+static int b_fast_read32(bench_ctx* c) {
+	if(c->fast.subdev == NULL) return -1;
+	c->u32 = flink_fast_read32(&c->fast, 0);
+	return 0;
+}
+static int b_fast_write32(bench_ctx* c) {
+	if(c->fast.subdev == NULL) return -1;
+	flink_fast_write32(&c->fast, PERIOD_OFFSET, 0);
+	return 0;
+}
+static int b_txn_begin_free(bench_ctx* c) {
+	flink_txn* txn = flink_txn_begin(c->dev);
+	if(txn == NULL) return -1;
+	flink_txn_free(txn);
+	return 0;
+}
+static int b_txn_commit(bench_ctx* c) { return c->txn != NULL ? flink_txn_commit(c->txn, NULL) : -1; }
+static int b_snapshot_capture(bench_ctx* c) { return c->snap != NULL ? flink_snapshot_capture(c->snap, c->values, sizeof(c->values), NULL) : -1; }
+
+/*
+ * Functions
+ */
+static int b_info_get_description(bench_ctx* c) { return flink_info_get_description(c->subdev, c->desc); }
+static int b_ain_get_resolution(bench_ctx* c) { return flink_analog_in_get_resolution(c->subdev, &c->u32); }
+static int b_ain_get_value(bench_ctx* c) { return flink_analog_in_get_value(c->subdev, 0, &c->u32); }
+static int b_ain_get_values(bench_ctx* c) {
+	uint32_t count = flink_subdevice_get_nofchannels(c->subdev);
+	return flink_analog_in_get_values(c->subdev, 0, count < MAX_VALUES ? count : MAX_VALUES, c->values);
+}
+static int b_aout_get_resolution(bench_ctx* c) { return flink_analog_out_get_resolution(c->subdev, &c->u32); }
+static int b_aout_set_value(bench_ctx* c) { return flink_analog_out_set_value(c->subdev, 0, 0); }
+static int b_dio_get_baseclock(bench_ctx* c) { return flink_dio_get_baseclock(c->subdev, &c->u32); }
+static int b_dio_set_direction(bench_ctx* c) { return flink_dio_set_direction(c->subdev, 0, FLINK_INPUT); }
+static int b_dio_set_value(bench_ctx* c) { return flink_dio_set_value(c->subdev, 0, 0); }
+static int b_dio_get_value(bench_ctx* c) { return flink_dio_get_value(c->subdev, 0, &c->u8); }
+static int b_dio_set_debounce(bench_ctx* c) { return flink_dio_set_debounce(c->subdev, 0, 0); }
+static int b_dio_get_debounce(bench_ctx* c) { return flink_dio_get_debounce(c->subdev, 0, &c->u32); }
+static int b_dio_get_port(bench_ctx* c) { return flink_dio_get_port(c->subdev, 0, 1, c->values); }
+static int b_dio_set_port_masked(bench_ctx* c) { return flink_dio_set_port_masked(c->subdev, 0, 1, c->values, c->masks); }
+static int b_dio_set_direction_mask(bench_ctx* c) { return flink_dio_set_direction_mask(c->subdev, 0, 1, c->values, c->masks); }
+static int b_counter_set_mode(bench_ctx* c) { return flink_counter_set_mode(c->subdev, 0); }
+static int b_counter_get_count(bench_ctx* c) { return flink_counter_get_count(c->subdev, 0, &c->u32); }
+static int b_pwm_get_baseclock(bench_ctx* c) { return flink_pwm_get_baseclock(c->subdev, &c->u32); }
+static int b_pwm_set_period(bench_ctx* c) { return flink_pwm_set_period(c->subdev, 0, 0); }
+static int b_pwm_get_period(bench_ctx* c) { return flink_pwm_get_period(c->subdev, 0, &c->u32); }
+static int b_pwm_set_hightime(bench_ctx* c) { return flink_pwm_set_hightime(c->subdev, 0, 0); }
+static int b_pwm_get_hightime(bench_ctx* c) { return flink_pwm_get_hightime(c->subdev, 0, &c->u32); }
+static int b_ppwa_get_baseclock(bench_ctx* c) { return flink_ppwa_get_baseclock(c->subdev, &c->u32); }
+static int b_ppwa_get_period(bench_ctx* c) { return flink_ppwa_get_period(c->subdev, 0, &c->u32); }
+static int b_ppwa_get_hightime(bench_ctx* c) { return flink_ppwa_get_hightime(c->subdev, 0, &c->u32); }
+static int b_wd_get_baseclock(bench_ctx* c) { return flink_wd_get_baseclock(c->subdev, &c->u32); }
+static int b_wd_get_status(bench_ctx* c) { return flink_wd_get_status(c->subdev, &c->u8); }
+static int b_wd_set_counter(bench_ctx* c) { return flink_wd_set_counter(c->subdev, 0); }
+static int b_stepper_get_baseclock(bench_ctx* c) { return flink_stepperMotor_get_baseclock(c->subdev, &c->u32); }
+static int b_stepper_set_local_config_reg(bench_ctx* c) { return flink_stepperMotor_set_local_config_reg(c->subdev, 0, 0); }
+static int b_stepper_get_local_config_reg(bench_ctx* c) { return flink_stepperMotor_get_local_config_reg(c->subdev, 0, &c->u32); }
+static int b_stepper_set_bits_atomic(bench_ctx* c) { return flink_stepperMotor_set_local_config_reg_bits_atomic(c->subdev, 0, 0); }
+static int b_stepper_reset_bits_atomic(bench_ctx* c) { return flink_stepperMotor_reset_local_config_reg_bits_atomic(c->subdev, 0, 0); }
+static int b_stepper_set_prescaler_start(bench_ctx* c) { return flink_stepperMotor_set_prescaler_start(c->subdev, 0, 0); }
+static int b_stepper_get_prescaler_start(bench_ctx* c) { return flink_stepperMotor_get_prescaler_start(c->subdev, 0, &c->u32); }
+static int b_stepper_set_prescaler_top(bench_ctx* c) { return flink_stepperMotor_set_prescaler_top(c->subdev, 0, 0); }
+static int b_stepper_get_prescaler_top(bench_ctx* c) { return flink_stepperMotor_get_prescaler_top(c->subdev, 0, &c->u32); }
+static int b_stepper_set_acceleration(bench_ctx* c) { return flink_stepperMotor_set_acceleration(c->subdev, 0, 0); }
+static int b_stepper_get_acceleration(bench_ctx* c) { return flink_stepperMotor_get_acceleration(c->subdev, 0, &c->u32); }
+static int b_stepper_set_steps_to_do(bench_ctx* c) { return flink_stepperMotor_set_steps_to_do(c->subdev, 0, 0); }
+static int b_stepper_get_steps_to_do(bench_ctx* c) { return flink_stepperMotor_get_steps_to_do(c->subdev, 0, &c->u32); }
+static int b_stepper_get_steps_have_done(bench_ctx* c) { return flink_stepperMotor_get_steps_have_done(c->subdev, 0, &c->u32); }
+static int b_sensor_get_resolution(bench_ctx* c) { return flink_reflectivesensor_get_resolution(c->subdev, &c->u32); }
+static int b_sensor_get_value(bench_ctx* c) { return flink_reflectivesensor_get_value(c->subdev, 0, &c->u32); }
+static int b_sensor_set_upper_level_int(bench_ctx* c) { return flink_reflectivesensor_set_upper_level_int(c->subdev, 0, 0); }
+static int b_sensor_get_upper_level_int(bench_ctx* c) { return flink_reflectivesensor_get_upper_level_int(c->subdev, 0, &c->u32); }
+static int b_sensor_set_lower_level_int(bench_ctx* c) { return flink_reflectivesensor_set_lower_level_int(c->subdev, 0, 0); }
+static int b_sensor_get_lower_level_int(bench_ctx* c) { return flink_reflectivesensor_get_lower_level_int(c->subdev, 0, &c->u32); }
+static int b_set_irq_multiplex(bench_ctx* c) { return flink_set_irq_multiplex(c->subdev, 0, 0); }
+static int b_get_irq_multiplex(bench_ctx* c) { return flink_get_irq_multiplex(c->subdev, 0, &c->u32); }
+static int b_get_signal_offset(bench_ctx* c) { return flink_get_signal_offset(c->dev, &c->u32); }
+
+static const bench benches[] = {
+	{ "flink_open+flink_close",                   NO_SUBDEV,                    SLOW,   b_open_close },
+	{ "flink_open_mapped+flink_close",            NO_SUBDEV,                    SLOW,   b_open_mapped_close },
+	{ "flink_get_nof_subdevices",                 NO_SUBDEV,                    0,      b_get_nof_subdevices },
+	{ "flink_get_subdevice_by_id",                NO_SUBDEV,                    0,      b_get_subdevice_by_id },
+	{ "flink_get_subdevice_by_unique_id",         NO_SUBDEV,                    0,      b_get_subdevice_by_unique_id },
+	{ "flink_subdevice_get_id",                   ANY_SUBDEV,                   0,      b_get_id },
+	{ "flink_subdevice_get_function",             ANY_SUBDEV,                   0,      b_get_function },
+	{ "flink_subdevice_get_subfunction",          ANY_SUBDEV,                   0,      b_get_subfunction },
+	{ "flink_subdevice_get_function_version",     ANY_SUBDEV,                   0,      b_get_function_version },
+	{ "flink_subdevice_get_baseaddr",             ANY_SUBDEV,                   0,      b_get_baseaddr },
+	{ "flink_subdevice_get_memsize",              ANY_SUBDEV,                   0,      b_get_memsize },
+	{ "flink_subdevice_get_nofchannels",          ANY_SUBDEV,                   0,      b_get_nofchannels },
+	{ "flink_subdevice_get_unique_id",            ANY_SUBDEV,                   0,      b_get_unique_id },
+	{ "flink_subdevice_id2str",                   ANY_SUBDEV,                   0,      b_id2str },
+	{ "flink_subdevice_select",                   ANY_SUBDEV,                   0,      b_select },
+	{ "flink_subdevice_set_cached",               PWM_INTERFACE_ID,             0,      b_set_cached },
+	{ "flink_subdevice_refresh",                  PWM_INTERFACE_ID,             0,      b_refresh },
+	{ "flink_subdevice_reset",                    PWM_INTERFACE_ID,             WRITES, b_reset },
+	{ "flink_flush",                              NO_SUBDEV,                    0,      b_flush },
+	{ "flink_read",                               ANY_SUBDEV,                   0,      b_read },
+	{ "flink_read/header",                        ANY_SUBDEV,                   0,      b_read_header },
+	{ "flink_read_bit",                           ANY_SUBDEV,                   0,      b_read_bit },
+	{ "flink_write",                              PWM_INTERFACE_ID,             WRITES, b_write },
+	{ "flink_write_bit",                          PWM_INTERFACE_ID,             WRITES, b_write_bit },
+	{ "flink_fast_read32",                        PWM_INTERFACE_ID,             0,      b_fast_read32 },
+	{ "flink_fast_write32",                       PWM_INTERFACE_ID,             WRITES, b_fast_write32 },
+	{ "flink_txn_begin+flink_txn_free",           NO_SUBDEV,                    0,      b_txn_begin_free },
+	{ "flink_txn_commit",                         ANY_SUBDEV,                   0,      b_txn_commit },
+	{ "flink_snapshot_capture",                   ANY_SUBDEV,                   0,      b_snapshot_capture },
+	{ "flink_get_signal_offset",                  NO_SUBDEV,                    0,      b_get_signal_offset },
+	{ "flink_info_get_description",               INFO_DEVICE_ID,               0,      b_info_get_description },
+	{ "flink_analog_in_get_resolution",           ANALOG_INPUT_INTERFACE_ID,    0,      b_ain_get_resolution },
+	{ "flink_analog_in_get_value",                ANALOG_INPUT_INTERFACE_ID,    0,      b_ain_get_value },
+	{ "flink_analog_in_get_values",               ANALOG_INPUT_INTERFACE_ID,    0,      b_ain_get_values },
+	{ "flink_analog_out_get_resolution",          ANALOG_OUTPUT_INTERFACE_ID,   0,      b_aout_get_resolution },
+	{ "flink_analog_out_set_value",               ANALOG_OUTPUT_INTERFACE_ID,   WRITES, b_aout_set_value },
+	{ "flink_dio_get_baseclock",                  GPIO_INTERFACE_ID,            0,      b_dio_get_baseclock },
+	{ "flink_dio_set_direction",                  GPIO_INTERFACE_ID,            WRITES, b_dio_set_direction },
+	{ "flink_dio_set_value",                      GPIO_INTERFACE_ID,            WRITES, b_dio_set_value },
+	{ "flink_dio_get_value",                      GPIO_INTERFACE_ID,            0,      b_dio_get_value },
+	{ "flink_dio_set_debounce",                   GPIO_INTERFACE_ID,            WRITES, b_dio_set_debounce },
+	{ "flink_dio_get_debounce",                   GPIO_INTERFACE_ID,            0,      b_dio_get_debounce },
+	{ "flink_dio_get_port",                       GPIO_INTERFACE_ID,            0,      b_dio_get_port },
+	{ "flink_dio_set_port_masked",                GPIO_INTERFACE_ID,            WRITES, b_dio_set_port_masked },
+	{ "flink_dio_set_direction_mask",             GPIO_INTERFACE_ID,            WRITES, b_dio_set_direction_mask },
+	{ "flink_counter_set_mode",                   COUNTER_INTERFACE_ID,         WRITES, b_counter_set_mode },
+	{ "flink_counter_get_count",                  COUNTER_INTERFACE_ID,         0,      b_counter_get_count },
+	{ "flink_pwm_get_baseclock",                  PWM_INTERFACE_ID,             0,      b_pwm_get_baseclock },
+	{ "flink_pwm_set_period",                     PWM_INTERFACE_ID,             WRITES, b_pwm_set_period },
+	{ "flink_pwm_get_period",                     PWM_INTERFACE_ID,             0,      b_pwm_get_period },
+	{ "flink_pwm_set_hightime",                   PWM_INTERFACE_ID,             WRITES, b_pwm_set_hightime },
+	{ "flink_pwm_get_hightime",                   PWM_INTERFACE_ID,             0,      b_pwm_get_hightime },
+	{ "flink_ppwa_get_baseclock",                 PPWA_INTERFACE_ID,            0,      b_ppwa_get_baseclock },
+	{ "flink_ppwa_get_period",                    PPWA_INTERFACE_ID,            0,      b_ppwa_get_period },
+	{ "flink_ppwa_get_hightime",                  PPWA_INTERFACE_ID,            0,      b_ppwa_get_hightime },
+	{ "flink_wd_get_baseclock",                   WD_INTERFACE_ID,              0,      b_wd_get_baseclock },
+	{ "flink_wd_get_status",                      WD_INTERFACE_ID,              0,      b_wd_get_status },
+	{ "flink_wd_set_counter",                     WD_INTERFACE_ID,              WRITES, b_wd_set_counter },
+	{ "flink_stepperMotor_get_baseclock",         STEPPER_MOTOR_INTERFACE_ID,   0,      b_stepper_get_baseclock },
+	{ "flink_stepperMotor_set_local_config_reg",  STEPPER_MOTOR_INTERFACE_ID,   WRITES, b_stepper_set_local_config_reg },
+	{ "flink_stepperMotor_get_local_config_reg",  STEPPER_MOTOR_INTERFACE_ID,   0,      b_stepper_get_local_config_reg },
+	{ "flink_stepperMotor_set_local_config_reg_bits_atomic",   STEPPER_MOTOR_INTERFACE_ID, WRITES, b_stepper_set_bits_atomic },
+	{ "flink_stepperMotor_reset_local_config_reg_bits_atomic", STEPPER_MOTOR_INTERFACE_ID, WRITES, b_stepper_reset_bits_atomic },
+	{ "flink_stepperMotor_set_prescaler_start",   STEPPER_MOTOR_INTERFACE_ID,   WRITES, b_stepper_set_prescaler_start },
+	{ "flink_stepperMotor_get_prescaler_start",   STEPPER_MOTOR_INTERFACE_ID,   0,      b_stepper_get_prescaler_start },
+	{ "flink_stepperMotor_set_prescaler_top",     STEPPER_MOTOR_INTERFACE_ID,   WRITES, b_stepper_set_prescaler_top },
+	{ "flink_stepperMotor_get_prescaler_top",     STEPPER_MOTOR_INTERFACE_ID,   0,      b_stepper_get_prescaler_top },
+	{ "flink_stepperMotor_set_acceleration",      STEPPER_MOTOR_INTERFACE_ID,   WRITES, b_stepper_set_acceleration },
+	{ "flink_stepperMotor_get_acceleration",      STEPPER_MOTOR_INTERFACE_ID,   0,      b_stepper_get_acceleration },
+	{ "flink_stepperMotor_set_steps_to_do",       STEPPER_MOTOR_INTERFACE_ID,   WRITES, b_stepper_set_steps_to_do },
+	{ "flink_stepperMotor_get_steps_to_do",       STEPPER_MOTOR_INTERFACE_ID,   0,      b_stepper_get_steps_to_do },
+	{ "flink_stepperMotor_get_steps_have_done",   STEPPER_MOTOR_INTERFACE_ID,   0,      b_stepper_get_steps_have_done },
+	{ "flink_reflectivesensor_get_resolution",    SENSOR_INTERFACE_ID,          0,      b_sensor_get_resolution },
+	{ "flink_reflectivesensor_get_value",         SENSOR_INTERFACE_ID,          0,      b_sensor_get_value },
+	{ "flink_reflectivesensor_set_upper_level_int", SENSOR_INTERFACE_ID,        WRITES, b_sensor_set_upper_level_int },
+	{ "flink_reflectivesensor_get_upper_level_int", SENSOR_INTERFACE_ID,        0,      b_sensor_get_upper_level_int },
+	{ "flink_reflectivesensor_set_lower_level_int", SENSOR_INTERFACE_ID,        WRITES, b_sensor_set_lower_level_int },
+	{ "flink_reflectivesensor_get_lower_level_int", SENSOR_INTERFACE_ID,        0,      b_sensor_get_lower_level_int },
+	{ "flink_set_irq_multiplex",                  IRQ_MULTIPLEXER_INTERFACE_ID, WRITES, b_set_irq_multiplex },
+	{ "flink_get_irq_multiplex",                  IRQ_MULTIPLEXER_INTERFACE_ID, 0,      b_get_irq_multiplex },
+};
+#define NOF_BENCHES (sizeof(benches) / sizeof(benches[0]))
+
+static uint64_t now_ns(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static int compare_u64(const void* a, const void* b) {
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return x < y ? -1 : x > y;
+}
+
+// Sample of the sorted samples below which the given fraction lies
+static uint64_t percentile(const uint64_t* sorted, uint32_t n, double fraction) {
+	uint32_t i = (uint32_t)(fraction * n);
+	return sorted[i < n ? i : n - 1];
+}
+
+// Median time of reading the clock twice, subtracted from every sample
+static uint64_t clock_overhead(uint64_t* samples, uint32_t n) {
+	uint32_t i;
+	for(i = 0; i < n; i++) {
+		uint64_t start = now_ns();
+		samples[i] = now_ns() - start;
+	}
+	qsort(samples, n, sizeof(uint64_t), compare_u64);
+	return percentile(samples, n, 0.5);
+}
+
+static flink_subdev* find(flink_dev* dev, uint16_t function) {
+	int i;
+	if(function == ANY_SUBDEV) return flink_get_subdevice_by_id(dev, 0);
+	for(i = 0; i < flink_get_nof_subdevices(dev); i++) {
+		flink_subdev* subdev = flink_get_subdevice_by_id(dev, i);
+		if(flink_subdevice_get_function(subdev) == function) return subdev;
+	}
+	return NULL;
+}
+
+// Times every call, then all calls at once for the throughput. Returns -1 if the call fails.
+static int run(const bench* b, bench_ctx* c, uint32_t calls, uint64_t overhead, uint64_t* samples, bench_result* res) {
+	uint64_t start, end;
+	uint32_t i;
+
+	for(i = 0; i < WARMUP_CALLS; i++) {
+		if(b->call(c) != 0) return -1;
+	}
+	for(i = 0; i < calls; i++) {
+		start = now_ns();
+		b->call(c);
+		end = now_ns();
+		samples[i] = end - start > overhead ? end - start - overhead : 0;
+	}
+	qsort(samples, calls, sizeof(uint64_t), compare_u64);
+	res->calls = calls;
+	res->median_ns = percentile(samples, calls, 0.5);
+	res->p99_ns = percentile(samples, calls, 0.99);
+	res->p999_ns = percentile(samples, calls, 0.999);
+	res->max_ns = samples[calls - 1];
+
+	start = now_ns();
+	for(i = 0; i < calls; i++) b->call(c);
+	end = now_ns();
+	res->calls_per_s = end > start ? calls * 1e9 / (end - start) : 0;
+	return 0;
+}
+
+static void print_json_string(const char* s) {
+	putchar('"');
+	for(; *s; s++) {
+		if(*s == '"' || *s == '\\') putchar('\\');
+		putchar(*s);
+	}
+	putchar('"');
+}
+
+static void print_result(int json, int first, const char* dev_name, const bench* b, int subdev_id, const bench_result* res) {
+	if(json) {
+		printf("%s\n  { \"device\": ", first ? "" : ",");
+		print_json_string(dev_name);
+		printf(", \"name\": \"%s\", \"subdevice\": %d, \"calls\": %u, \"median_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu, \"calls_per_s\": %.0f }",
+		       b->name, subdev_id, res->calls, (unsigned long long)res->median_ns, (unsigned long long)res->p99_ns,
+		       (unsigned long long)res->p999_ns, (unsigned long long)res->max_ns, res->calls_per_s);
+	}
+	else {
+		printf("%s,%s,%d,%u,%llu,%llu,%llu,%llu,%.0f\n", dev_name, b->name, subdev_id, res->calls,
+		       (unsigned long long)res->median_ns, (unsigned long long)res->p99_ns,
+		       (unsigned long long)res->p999_ns, (unsigned long long)res->max_ns, res->calls_per_s);
+	}
+}
+
+static void usage(const char* prog) {
+	fprintf(stderr, "Usage: %s [-d device] [-n calls] [-f csv|json] [-b filter] [-w]\n", prog);
+	fprintf(stderr, "  -d  device name, e.g. /dev/flink0, mmap:/dev/flink0 or sim: (default " DEFAULT_DEV ")\n");
+	fprintf(stderr, "  -n  timed calls per function (default %d)\n", DEFAULT_CALLS);
+	fprintf(stderr, "  -f  output format (default csv)\n");
+	fprintf(stderr, "  -b  only run functions whose name contains the filter\n");
+	fprintf(stderr, "  -w  also run the functions writing to the device, they write zeros to channel 0\n");
+}
+
+int main(int argc, char* argv[]) {
+	bench_ctx ctx;
+	bench_result res;
+	uint64_t* samples;
+	uint64_t overhead;
+	uint32_t calls = DEFAULT_CALLS, n, i;
+	const char* filter = NULL;
+	int json = 0, writes = 0, first = 1, skipped = 0, subdev_id;
+	int c;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.dev_name = DEFAULT_DEV;
+
+	/* Compute command line arguments */
+	while((c = getopt(argc, argv, "d:n:f:b:wh")) != -1) {
+		switch(c) {
+			case 'd': // device
+				ctx.dev_name = optarg;
+				break;
+			case 'n': // number of calls
+				calls = atoi(optarg);
+				break;
+			case 'f': // output format
+				if(strcmp(optarg, "json") == 0) json = 1;
+				else if(strcmp(optarg, "csv") != 0) {
+					fprintf(stderr, "Unknown format `%s'.\n", optarg);
+					return -1;
+				}
+				break;
+			case 'b': // filter
+				filter = optarg;
+				break;
+			case 'w': // run writing functions
+				writes = 1;
+				break;
+			case 'h':
+				usage(argv[0]);
+				return EXIT_SUCCESS;
+			case '?':
+				if(optopt == 'd' || optopt == 'n' || optopt == 'f' || optopt == 'b') fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+				else if(isprint(optopt)) fprintf (stderr, "Unknown option `-%c'.\n", optopt);
+				else fprintf(stderr, "Unknown option character `\\x%x'.\n", optopt);
+				return -1;
+			default:
+				abort();
+		}
+	}
+	if(calls < 10) calls = 10;
+
+	ctx.dev = flink_open(ctx.dev_name);
+	if(ctx.dev == NULL || flink_get_nof_subdevices(ctx.dev) <= 0) {
+		fprintf(stderr, "Failed to open device %s!\n", ctx.dev_name);
+		return -1;
+	}
+	ctx.last = flink_get_subdevice_by_id(ctx.dev, flink_get_nof_subdevices(ctx.dev) - 1);
+
+	// Transactions and snapshots read the header of the first subdevice register by register
+	ctx.txn = flink_txn_begin(ctx.dev);
+	ctx.snap = flink_snapshot_create(ctx.dev);
+	for(i = 0; i < HEADER_SIZE / REGISTER_WITH; i++) {
+		flink_subdev* subdev = flink_get_subdevice_by_id(ctx.dev, 0);
+		if(ctx.txn != NULL && flink_txn_add_read(ctx.txn, subdev, i * REGISTER_WITH, REGISTER_WITH, &ctx.values[i]) != 0) {
+			flink_txn_free(ctx.txn);
+			ctx.txn = NULL;
+		}
+		if(ctx.snap != NULL && flink_snapshot_add_register(ctx.snap, subdev, i * REGISTER_WITH, REGISTER_WITH, i * REGISTER_WITH) != 0) {
+			flink_snapshot_free(ctx.snap);
+			ctx.snap = NULL;
+		}
+	}
+	if(find(ctx.dev, PWM_INTERFACE_ID) == NULL || flink_fast_open(find(ctx.dev, PWM_INTERFACE_ID), &ctx.fast) != 0) {
+		ctx.fast.subdev = NULL;
+	}
+
+	samples = malloc(calls * sizeof(uint64_t));
+	if(samples == NULL) {
+		fprintf(stderr, "Out of memory!\n");
+		return -1;
+	}
+	overhead = clock_overhead(samples, calls);
+
+	if(json) printf("[");
+	else printf("device,name,subdevice,calls,median_ns,p99_ns,p999_ns,max_ns,calls_per_s\n");
+	for(i = 0; i < NOF_BENCHES; i++) {
+		const bench* b = &benches[i];
+
+		if(filter != NULL && strstr(b->name, filter) == NULL) continue;
+		if((b->flags & WRITES) && !writes) continue;
+		ctx.subdev = b->function != NO_SUBDEV ? find(ctx.dev, b->function) : NULL;
+		if(b->function != NO_SUBDEV && ctx.subdev == NULL) { // no such subdevice
+			skipped++;
+			continue;
+		}
+		subdev_id = ctx.subdev != NULL ? flink_subdevice_get_id(ctx.subdev) : -1;
+		n = (b->flags & SLOW) ? (calls + 9) / 10 : calls;
+		if(run(b, &ctx, n, overhead, samples, &res) != 0) { // not supported by the backend
+			fprintf(stderr, "%s: not supported by %s, skipped\n", b->name, ctx.dev_name);
+			skipped++;
+			continue;
+		}
+		print_result(json, first, ctx.dev_name, b, subdev_id, &res);
+		first = 0;
+	}
+	if(json) printf("\n]\n");
+	fprintf(stderr, "%d functions skipped, clock overhead of %llu ns subtracted\n", skipped, (unsigned long long)overhead);
+
+	free(samples);
+	flink_snapshot_free(ctx.snap);
+	flink_txn_free(ctx.txn);
+	flink_close(ctx.dev);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,16 @@
+#ifndef FLINK_TEST_CHECK_H_
+#define FLINK_TEST_CHECK_H_
+
+#include <stdio.h>
+
+// Failed checks of a test, the test fails if any
+static int errors = 0;
+
+static void check(int ok, const char* what) {
+	if(!ok) {
+		printf("FAILED: %s\n", what);
+		errors++;
+	}
+}
+
+#endif // FLINK_TEST_CHECK_H_
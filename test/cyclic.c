@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define DESIGN         "sim:ain:4,aout:4,pwm:2"
+#define NOF_CHANNELS   4
+#define PERIOD_US      2000
+#define NOF_CYCLES     50
+
+#define FUNC_OFFSET    (HEADER_SIZE + SUBHEADER_SIZE)
+#define VALUE(ch)      (FUNC_OFFSET + REGISTER_WITH * (1 + (ch)))
+
+typedef struct {
+	uint32_t inputs[NOF_CHANNELS];
+	uint32_t outputs[NOF_CHANNELS];
+	flink_subdev* pwm;
+	uint64_t last_cycle;
+	int stop_at;
+} loop;
+
+static double now_ms(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+// Control law: outputs follow the inputs, the pwm period counts the cycles
+static int control(flink_cyclic* cyc, uint64_t cycle, void* arg) {
+	loop* l = arg;
+	int i;
+	for(i = 0; i < NOF_CHANNELS; i++) l->outputs[i] = l->inputs[i] + 1;
+	flink_pwm_set_period(l->pwm, 0, (uint32_t)cycle);
+	l->last_cycle = cycle;
+	return l->stop_at >= 0 && cycle == (uint64_t)l->stop_at;
+}
+
+static int overrun(flink_cyclic* cyc, uint64_t cycle, void* arg) {
+	if(cycle % 2 == 0) nanosleep(&(struct timespec){ 0, 3 * PERIOD_US * 1000 }, NULL);
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_subdev* ain;
+	flink_subdev* aout;
+	flink_cyclic* cyc;
+	flink_cyclic_stats stats;
+	loop l = { .stop_at = -1 };
+	uint32_t value;
+	double start, elapsed;
+	int i;
+
+	printf("Opening device %s...\n", DESIGN);
+	dev = flink_open(DESIGN);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	ain = flink_get_subdevice_by_id(dev, 0);
+	aout = flink_get_subdevice_by_id(dev, 1);
+	l.pwm = flink_get_subdevice_by_id(dev, 2);
+	flink_subdevice_set_cached(l.pwm, 1);
+	for(i = 0; i < NOF_CHANNELS; i++) flink_sim_poke(ain, VALUE(i), 100 * i);
+
+	cyc = flink_cyclic_create(dev, PERIOD_US, control, &l);
+	check(cyc != NULL, "create executor");
+	if(cyc == NULL) return -1;
+	for(i = 0; i < NOF_CHANNELS; i++) {
+		check(flink_cyclic_add_read(cyc, ain, VALUE(i), REGISTER_WITH, &l.inputs[i]) == 0, "add read");
+		check(flink_cyclic_add_write(cyc, aout, VALUE(i), REGISTER_WITH, &l.outputs[i]) == 0, "add write");
+	}
+
+	// Reads before, writes and cached registers after the handler
+	start = now_ms();
+	check(flink_cyclic_run(cyc, NOF_CYCLES) == 0, "run");
+	elapsed = now_ms() - start;
+	printf("%d cycles in %.1f ms\n", NOF_CYCLES, elapsed);
+	check(elapsed >= (NOF_CYCLES - 1) * PERIOD_US / 1e3, "cycles ran at the period");
+	for(i = 0; i < NOF_CHANNELS; i++) {
+		flink_sim_peek(aout, VALUE(i), &value);
+		check(value == 100 * (uint32_t)i + 1, "write set");
+	}
+	flink_sim_peek(l.pwm, FUNC_OFFSET + PWM_FIRSTPWM_OFFSET, &value);
+	check(value == NOF_CYCLES - 1, "cached registers flushed");
+
+	flink_cyclic_get_stats(cyc, &stats);
+	printf("latency avg %llu max %llu ns, exec avg %llu ns, jitter max %llu ns, %llu overruns\n",
+	       (unsigned long long)stats.latency_avg_ns, (unsigned long long)stats.latency_max_ns,
+	       (unsigned long long)stats.exec_avg_ns, (unsigned long long)stats.jitter_max_ns,
+	       (unsigned long long)stats.overruns);
+	check(stats.cycles == NOF_CYCLES && stats.errors == 0, "statistics");
+	check(stats.latency_min_ns <= stats.latency_avg_ns && stats.latency_avg_ns <= stats.latency_max_ns, "latency");
+	check(stats.exec_min_ns <= stats.exec_avg_ns && stats.exec_avg_ns <= stats.exec_max_ns, "execution time");
+
+	// The handler ends the run
+	l.stop_at = 5;
+	check(flink_cyclic_run(cyc, 0) == 0 && l.last_cycle == 5, "stopped by handler");
+	flink_cyclic_free(cyc);
+
+	// Overruns skip the releases which passed
+	cyc = flink_cyclic_create(dev, PERIOD_US, overrun, NULL);
+	start = now_ms();
+	flink_cyclic_run(cyc, 10);
+	elapsed = now_ms() - start;
+	flink_cyclic_get_stats(cyc, &stats);
+	check(stats.cycles == 10 && stats.overruns >= 5 && stats.skipped >= 2 * stats.overruns, "overruns");
+	check(elapsed >= 5 * 3 * PERIOD_US / 1e3, "overrun cycles");
+	flink_cyclic_free(cyc);
+
+	check(flink_cyclic_create(dev, 0, NULL, NULL) == NULL, "zero period");
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define PWM_BASE           0x0000
+#define PWM_SIZE           0x0040
+#define PWM_CHANNELS       2
+#define IMAGE_SIZE         (PWM_BASE + PWM_SIZE)
+#define PERIOD_OFFSET      (HEADER_SIZE + SUBHEADER_SIZE + PWM_FIRSTPWM_OFFSET)
+
+#define NOF_MAPPED_CALLS   2000000
+#define NOF_SIM_CALLS      200000
+
+static double now_ns(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// Compares the checked and the unchecked read of a register, prints ns per call
+static void compare(const char* name, flink_subdev* subdev, int calls) {
+	flink_fast_subdev fast;
+	volatile uint32_t sink = 0;
+	uint32_t value;
+	double start, checked, unchecked;
+	int i;
+
+	check(flink_fast_open(subdev, &fast) == 0, "open fast handle");
+
+	// Both accessors see the writes of the other one
+	flink_write(subdev, PERIOD_OFFSET, REGISTER_WITH, &(uint32_t){ 1234 });
+	check(flink_fast_read32(&fast, PERIOD_OFFSET) == 1234, "unchecked read");
+	flink_fast_write32(&fast, PERIOD_OFFSET, 4321);
+	value = 0;
+	flink_read(subdev, PERIOD_OFFSET, REGISTER_WITH, &value);
+	check(value == 4321, "unchecked write");
+
+	start = now_ns();
+	for(i = 0; i < calls; i++) {
+		flink_read(subdev, PERIOD_OFFSET, REGISTER_WITH, &value);
+		sink += value;
+	}
+	checked = (now_ns() - start) / calls;
+	start = now_ns();
+	for(i = 0; i < calls; i++) {
+		sink += flink_fast_read32(&fast, PERIOD_OFFSET);
+	}
+	unchecked = (now_ns() - start) / calls;
+	printf("%-8s flink_read %6.1f ns, flink_fast_read32 %6.1f ns, saving %6.1f ns per call\n", name, checked, unchecked, checked - unchecked);
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_subdev* pwm;
+	flink_fast_subdev fast;
+	uint8_t image[IMAGE_SIZE];
+	uint32_t hdr[4] = { (uint32_t)PWM_INTERFACE_ID << 16, PWM_SIZE, PWM_CHANNELS, 1 };
+	char file_name[64];
+	int fd;
+
+	// Mapped registers: a memory backed image of the device memory
+	memset(image, 0, sizeof(image));
+	memcpy(image + PWM_BASE, hdr, sizeof(hdr));
+	fd = memfd_create("flink_image", 0);
+	if(fd < 0 || write(fd, image, sizeof(image)) != sizeof(image)) {
+		printf("Failed to create device image!\n");
+		return -1;
+	}
+	snprintf(file_name, sizeof(file_name), "/proc/self/fd/%d", fd);
+	dev = flink_open_mapped(file_name);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	compare("mapped", flink_get_subdevice_by_id(dev, 0), NOF_MAPPED_CALLS);
+	flink_close(dev);
+	close(fd);
+
+	// Registers accessed through a backend call
+	dev = flink_open("sim:pwm:2");
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	pwm = flink_get_subdevice_by_id(dev, 0);
+	compare("sim", pwm, NOF_SIM_CALLS);
+
+	// The unchecked accessors would bypass the shadow registers
+	flink_subdevice_set_cached(pwm, 1);
+	check(flink_fast_open(pwm, &fast) < 0, "cached subdevice refused");
+	check(flink_fast_open(NULL, &fast) < 0, "invalid subdevice refused");
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
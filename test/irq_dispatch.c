@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define DESIGN      "sim:irqmux:8"
+#define NOF_IRQS    8
+#define TRIGGERS    100
+
+typedef struct {
+	atomic_uint count;	// interrupts seen by the handler
+	atomic_uint calls;	// handler calls
+} irq_stat;
+
+static flink_irq_dispatcher* disp;
+static irq_stat stats[NOF_IRQS];
+
+static void handler(flink_dev* dev, uint32_t irq, uint32_t count, void* arg) {
+	irq_stat* stat = arg;
+	stat->count += count;
+	stat->calls++;
+}
+
+static flink_irq_batch last_batch;
+
+static void batch_handler(flink_dev* dev, const flink_irq_batch* batch, void* arg) {
+	irq_stat* stat = arg;
+	last_batch = *batch;
+	stat->count += batch->count;
+	stat->calls++;
+}
+
+static void once(flink_dev* dev, uint32_t irq, uint32_t count, void* arg) {
+	handler(dev, irq, count, arg);
+	flink_irq_dispatcher_remove(disp, irq); // handlers may remove themselves
+}
+
+// Waits until the handler of an irq has seen a number of interrupts
+static int wait_count(uint32_t irq, uint32_t count) {
+	int i;
+	for(i = 0; i < 1000 && stats[irq].count < count; i++) {
+		nanosleep(&(struct timespec){ 0, 1000000 }, NULL);
+	}
+	return stats[irq].count == count;
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_irq_stats st;
+	uint64_t calls;
+	uint32_t irq;
+	int i;
+
+	printf("Opening device %s...\n", DESIGN);
+	dev = flink_open(DESIGN);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+
+	disp = flink_irq_dispatcher_start(dev, -1, 0);
+	check(disp != NULL, "start dispatcher");
+	if(disp == NULL) return -1;
+
+	// Every irq gets its own argument
+	for(irq = 0; irq < NOF_IRQS; irq++) {
+		check(flink_irq_dispatcher_add(disp, irq, handler, &stats[irq]) == 0, "add handler");
+	}
+	for(i = 0; i < TRIGGERS; i++) {
+		for(irq = 0; irq < NOF_IRQS; irq++) flink_sim_trigger_irq(dev, irq);
+	}
+	for(irq = 0; irq < NOF_IRQS; irq++) {
+		check(wait_count(irq, TRIGGERS), "interrupts per irq");
+		check(stats[irq].calls >= 1 && stats[irq].calls <= TRIGGERS, "handler calls");
+	}
+
+	// Statistics
+	check(flink_irq_dispatcher_get_stats(disp, 0, &st) == 0, "get statistics");
+	for(calls = 0, i = 0; i < FLINK_IRQ_HIST_BINS; i++) calls += st.histogram[i];
+	check(st.count == TRIGGERS && st.calls == stats[0].calls && st.coalesced == st.count - st.calls, "statistics counters");
+	check(calls == st.calls, "histogram");
+	check(st.latency_min_ns <= st.latency_avg_ns && st.latency_avg_ns <= st.latency_max_ns, "average latency");
+	check(st.latency_p50_ns <= st.latency_p99_ns && st.latency_p99_ns <= st.latency_max_ns, "latency percentiles");
+	check(st.duration_min_ns <= st.duration_avg_ns && st.duration_avg_ns <= st.duration_max_ns, "handler duration");
+	check(flink_irq_dispatcher_reset_stats(disp, 0) == 0, "reset statistics");
+	flink_irq_dispatcher_get_stats(disp, 0, &st);
+	check(st.count == 0 && st.calls == 0 && st.latency_max_ns == 0, "statistics after reset");
+
+	// Removed irqs are not dispatched anymore
+	check(flink_irq_dispatcher_remove(disp, 2) == 0, "remove handler");
+	check(flink_irq_dispatcher_remove(disp, 2) < 0, "remove unregistered irq");
+	flink_sim_trigger_irq(dev, 2);
+	flink_sim_trigger_irq(dev, 3);
+	check(wait_count(3, TRIGGERS + 1), "irq after removal of another one");
+	check(stats[2].count == TRIGGERS, "removed irq dispatched");
+
+	// A handler removing itself is called once
+	check(flink_irq_dispatcher_add(disp, 4, once, &stats[4]) == 0, "replace handler");
+	flink_sim_trigger_irq(dev, 4);
+	check(wait_count(4, TRIGGERS + 1), "handler removing itself");
+	flink_sim_trigger_irq(dev, 4);
+	flink_sim_trigger_irq(dev, 3);
+	check(wait_count(3, TRIGGERS + 2) && stats[4].count == TRIGGERS + 1, "removed by handler");
+
+	// Coalescing by number of interrupts
+	check(flink_irq_dispatcher_add_coalesced(disp, 6, 10, 0, batch_handler, &stats[6]) == 0, "add coalesced handler");
+	calls = stats[6].calls;
+	for(i = 0; i < 9; i++) flink_sim_trigger_irq(dev, 6);
+	nanosleep(&(struct timespec){ 0, 20000000 }, NULL);
+	check(stats[6].calls == calls, "batch delivered before max events");
+	flink_sim_trigger_irq(dev, 6);
+	check(wait_count(6, TRIGGERS + 10) && stats[6].calls == calls + 1, "batch of max events");
+	check(last_batch.irq == 6 && last_batch.count == 10 && last_batch.first_ns <= last_batch.last_ns, "batch contents");
+
+	// Coalescing by delay
+	check(flink_irq_dispatcher_add_coalesced(disp, 7, 0, 50000, batch_handler, &stats[7]) == 0, "add delayed handler");
+	calls = stats[7].calls;
+	for(i = 0; i < 5; i++) flink_sim_trigger_irq(dev, 7);
+	nanosleep(&(struct timespec){ 0, 10000000 }, NULL);
+	check(stats[7].calls == calls, "batch delivered before max delay");
+	check(wait_count(7, TRIGGERS + 5) && stats[7].calls == calls + 1, "batch after max delay");
+	flink_irq_dispatcher_get_stats(disp, 7, &st);
+	check(st.latency_max_ns >= 50000000, "delay of the batch");
+
+	check(flink_irq_dispatcher_add(disp, 1000, handler, NULL) < 0, "invalid irq");
+	check(flink_irq_dispatcher_stop(disp) == 0, "stop dispatcher");
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <poll.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define DESIGN "sim:irqmux:4"
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_irq* irq;
+	uint32_t irqs[] = { 1, 3 };
+	uint32_t counts[2];
+	struct pollfd pfd;
+
+	printf("Opening device %s...\n", DESIGN);
+	dev = flink_open(DESIGN);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+
+	irq = flink_irq_open(dev, irqs, 2);
+	check(irq != NULL, "register irqs");
+	if(irq == NULL) return -1;
+	pfd.fd = flink_irq_get_fd(irq);
+	pfd.events = POLLIN;
+	check(pfd.fd >= 0, "irq file descriptor");
+
+	// Nothing pending
+	check(poll(&pfd, 1, 0) == 0, "fd not readable without irq");
+	check(flink_irq_wait(irq, 10, counts) == 0, "wait times out");
+
+	// Interrupts are counted per irq
+	flink_sim_trigger_irq(dev, 3);
+	flink_sim_trigger_irq(dev, 1);
+	flink_sim_trigger_irq(dev, 3);
+	flink_sim_trigger_irq(dev, 2); // not registered, dropped
+	check(poll(&pfd, 1, 1000) == 1 && (pfd.revents & POLLIN), "fd readable after irq");
+	check(flink_irq_read(irq, counts) == 3, "nof interrupts");
+	check(counts[0] == 1 && counts[1] == 2, "interrupts per irq");
+	check(flink_irq_read(irq, counts) == 0 && counts[0] == 0 && counts[1] == 0, "interrupts consumed");
+
+	flink_sim_trigger_irq(dev, 1);
+	check(flink_irq_wait(irq, -1, counts) == 1 && counts[0] == 1, "wait for irq");
+
+	// Unregistered irqs are dropped
+	check(flink_irq_close(irq) == 0, "close irqs");
+	check(flink_sim_trigger_irq(dev, 1) == 0, "trigger after close");
+	check(flink_sim_trigger_irq(dev, 100) < 0, "invalid irq");
+
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define DESIGN          "sim:pwm:4"
+#define NOF_THREADS     4
+#define ERRORS_PER_THREAD 5000
+#define RING_CAPACITY   64
+#define NOF_TIMED_CALLS 100000
+
+typedef struct {
+	int  calls;
+	int  level;
+	int  error;
+	char message[FLINK_LOG_MESSAGE_SIZE];
+} capture;
+
+static flink_subdev* pwm;
+
+static double now_ns(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void handler(const flink_log_entry* entry, void* arg) {
+	capture* c = arg;
+	c->calls++;
+	c->level = entry->level;
+	c->error = entry->error;
+	strcpy(c->message, entry->message);
+}
+
+// A failing call: reading without buffer
+static int fail(void) {
+	return flink_read(pwm, 0, REGISTER_WITH, NULL) < 0;
+}
+
+// Time per failing call, the ring is drained between batches so that no message is dropped
+static double time_failures(void) {
+	flink_log_entry entries[RING_CAPACITY];
+	double start, sum = 0;
+	int i, k;
+	for(k = 0; k < NOF_TIMED_CALLS / RING_CAPACITY; k++) {
+		start = now_ns();
+		for(i = 0; i < RING_CAPACITY; i++) fail();
+		sum += now_ns() - start;
+		if(flink_log_get_level() != FLINK_LOG_OFF) flink_log_read(entries, RING_CAPACITY);
+	}
+	return sum / (k * RING_CAPACITY);
+}
+
+static void* producer(void* arg) {
+	int i;
+	for(i = 0; i < ERRORS_PER_THREAD; i++) fail();
+	return NULL;
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_log_entry entries[RING_CAPACITY];
+	pthread_t threads[NOF_THREADS];
+	capture c;
+	uint64_t read = 0;
+	double off, ring;
+	int i, n, running, ok;
+
+	dev = flink_open(DESIGN);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	pwm = flink_get_subdevice_by_id(dev, 0);
+
+	// Errors reach the handler
+	memset(&c, 0, sizeof(c));
+	check(flink_log_get_level() == FLINK_LOG_ERROR, "default level");
+	flink_log_set_handler(handler, &c);
+	check(fail() && c.calls == 1, "error logged");
+	check(c.level == FLINK_LOG_ERROR && strcmp(c.message, "flink error: Null ptr as argument") == 0, "error message");
+	check(c.error != 0, "error code");
+
+	// Debug messages only with the debug level, without newline
+	c.calls = 0;
+	flink_pwm_set_period(pwm, 0, 100);
+	check(c.calls == 0, "no debug messages by default");
+	check(flink_log_set_level(FLINK_LOG_DEBUG) == 0, "set debug level");
+	flink_pwm_set_period(pwm, 0, 100);
+	check(c.calls > 0 && c.level == FLINK_LOG_DEBUG && c.error == 0, "debug messages");
+	check(c.message[0] != '\0' && c.message[strlen(c.message) - 1] != '\n', "debug message without newline");
+
+	// Nothing is logged when off
+	flink_log_set_level(FLINK_LOG_OFF);
+	c.calls = 0;
+	check(fail() && c.calls == 0, "logging off");
+	check(flink_log_set_level(FLINK_LOG_DEBUG + 1) < 0, "invalid level");
+	check(flink_log_get_level() == FLINK_LOG_OFF, "level kept");
+	off = time_failures();
+
+	// Ring: messages are kept in order until read, new ones are dropped when full
+	flink_log_set_level(FLINK_LOG_ERROR);
+	check(flink_log_set_ring(RING_CAPACITY - 1) == 0, "set up ring");
+	c.calls = 0;
+	for(i = 0; i < RING_CAPACITY + 10; i++) fail();
+	check(c.calls == 0, "handler not called with ring");
+	check(flink_log_get_dropped() == 10, "full ring drops new messages");
+	n = flink_log_read(entries, RING_CAPACITY);
+	check(n == RING_CAPACITY, "ring holds the capacity");
+	ok = 1;
+	for(i = 0; i < n; i++) {
+		ok = ok && entries[i].level == FLINK_LOG_ERROR && strcmp(entries[i].message, "flink error: Null ptr as argument") == 0;
+		ok = ok && (i == 0 || entries[i].timestamp_ns >= entries[i - 1].timestamp_ns);
+	}
+	check(ok, "ring messages in order");
+	check(flink_log_read(entries, RING_CAPACITY) == 0, "ring empty");
+	ring = time_failures();
+	check(flink_log_get_dropped() == 10, "no message dropped while draining");
+
+	// Threads log concurrently while the ring is drained, every message is read or dropped
+	check(flink_log_set_ring(RING_CAPACITY) == 0, "set up new ring");
+	for(i = 0; i < NOF_THREADS; i++) pthread_create(&threads[i], NULL, producer, NULL);
+	ok = 1;
+	do {
+		running = read + flink_log_get_dropped() < NOF_THREADS * ERRORS_PER_THREAD;
+		n = flink_log_read(entries, RING_CAPACITY);
+		for(i = 0; i < n; i++) {
+			ok = ok && strcmp(entries[i].message, "flink error: Null ptr as argument") == 0;
+		}
+		read += n;
+	} while(running || n > 0);
+	for(i = 0; i < NOF_THREADS; i++) pthread_join(threads[i], NULL);
+	check(ok, "concurrent messages intact");
+	check(read + flink_log_get_dropped() == NOF_THREADS * ERRORS_PER_THREAD, "concurrent messages read or dropped");
+	printf("%llu messages read, %llu dropped\n", (unsigned long long)read, (unsigned long long)flink_log_get_dropped());
+	printf("failing call: %.1f ns with logging off, %.1f ns into the ring\n", off, ring);
+
+	check(flink_log_set_ring(0) == 0, "remove ring");
+	check(flink_log_read(entries, RING_CAPACITY) < 0, "no ring");
+	flink_log_set_handler(NULL, NULL);
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <flinklib.h>
+
+#define GPIO_BASE          0x0000
+#define GPIO_SIZE          0x0100
+#define GPIO_CHANNELS      32
+#define PWM_BASE           (GPIO_BASE + GPIO_SIZE)
+#define PWM_SIZE           0x0040
+#define PWM_CHANNELS       2
+#define IMAGE_SIZE         (PWM_BASE + PWM_SIZE)
+
+#define GPIO_DIR_OFFSET    (GPIO_BASE + HEADER_SIZE + SUBHEADER_SIZE + 4)
+#define GPIO_VALUE_OFFSET  (GPIO_DIR_OFFSET + REGISTER_WITH)
+#define PWM_PERIOD_OFFSET  (PWM_BASE + HEADER_SIZE + SUBHEADER_SIZE + PWM_FIRSTPWM_OFFSET)
+
+static void put_header(uint8_t* image, uint32_t base, uint16_t function, uint32_t size, uint32_t channels, uint32_t unique_id) {
+	uint32_t hdr[4] = { (uint32_t)function << 16, size, channels, unique_id };
+	memcpy(image + base, hdr, sizeof(hdr));
+}
+
+static uint32_t get_word(int fd, uint32_t offset) {
+	uint32_t value = 0;
+	if(pread(fd, &value, sizeof(value), offset) != sizeof(value)) return 0xffffffff;
+	return value;
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_subdev* gpio;
+	flink_subdev* pwm;
+	uint8_t image[IMAGE_SIZE];
+	char file_name[64];
+	uint32_t value;
+	int fd, errors = 0;
+
+	// Create a memory backed stand-in for the device memory
+	memset(image, 0, sizeof(image));
+	put_header(image, GPIO_BASE, GPIO_INTERFACE_ID, GPIO_SIZE, GPIO_CHANNELS, 0x10);
+	put_header(image, PWM_BASE, PWM_INTERFACE_ID, PWM_SIZE, PWM_CHANNELS, 0x20);
+	fd = memfd_create("flink_image", 0);
+	if(fd < 0 || write(fd, image, sizeof(image)) != sizeof(image)) {
+		printf("Failed to create device image!\n");
+		return -1;
+	}
+	snprintf(file_name, sizeof(file_name), "/proc/self/fd/%d", fd);
+
+	printf("Opening device image %s...\n", file_name);
+	dev = flink_open_mapped(file_name);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+
+	if(flink_get_nof_subdevices(dev) != 2) {
+		printf("Wrong number of subdevices: %d\n", flink_get_nof_subdevices(dev));
+		return -1;
+	}
+	gpio = flink_get_subdevice_by_unique_id(dev, 0x10);
+	pwm = flink_get_subdevice_by_unique_id(dev, 0x20);
+	if(gpio == NULL || pwm == NULL || flink_subdevice_get_function(pwm) != PWM_INTERFACE_ID || flink_subdevice_get_nofchannels(pwm) != PWM_CHANNELS) {
+		printf("Subdevices not read correctly from headers!\n");
+		return -1;
+	}
+
+	// Bit operations
+	flink_dio_set_direction(gpio, 3, FLINK_OUTPUT);
+	flink_dio_set_value(gpio, 3, 1);
+	flink_dio_set_value(gpio, 31, 1);
+	if(get_word(fd, GPIO_DIR_OFFSET) != (1u << 3) || get_word(fd, GPIO_VALUE_OFFSET) != ((1u << 3) | (1u << 31))) {
+		printf("Bit write did not reach the device memory!\n");
+		errors++;
+	}
+	uint8_t bit = 0;
+	flink_dio_get_value(gpio, 31, &bit);
+	if(bit != 1) {
+		printf("Bit read returned %u!\n", bit);
+		errors++;
+	}
+	if(flink_read_bit(gpio, GPIO_VALUE_OFFSET - GPIO_BASE + 1, 0, &bit) >= 0) {
+		printf("Bit read of an unaligned register did not fail!\n");
+		errors++;
+	}
+
+	// Register operations
+	flink_pwm_set_period(pwm, 1, 1234);
+	if(get_word(fd, PWM_PERIOD_OFFSET + REGISTER_WITH) != 1234) {
+		printf("Register write did not reach the device memory!\n");
+		errors++;
+	}
+	value = 0;
+	flink_pwm_get_period(pwm, 1, &value);
+	if(value != 1234) {
+		printf("Register read returned %u!\n", value);
+		errors++;
+	}
+
+	// Accesses outside of the subdevice must fail
+	if(flink_read(pwm, PWM_SIZE, REGISTER_WITH, &value) >= 0) {
+		printf("Read outside of subdevice did not fail!\n");
+		errors++;
+	}
+
+	flink_close(dev);
+
+	// The same backend is selected by the scheme of the device name
+	snprintf(file_name, sizeof(file_name), "mmap:/proc/self/fd/%d", fd);
+	dev = flink_open(file_name);
+	if(dev == NULL) {
+		printf("Failed to open %s!\n", file_name);
+		return -1;
+	}
+	value = 0;
+	flink_pwm_get_period(flink_get_subdevice_by_unique_id(dev, 0x20), 1, &value);
+	if(value != 1234) {
+		printf("Register read after reopening returned %u!\n", value);
+		errors++;
+	}
+	flink_close(dev);
+	close(fd);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
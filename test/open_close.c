@@ -3,6 +3,7 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <ctype.h>
+#include <time.h>
 
 #include <flinklib.h>
 
@@ -11,16 +12,22 @@
 int main(int argc, char* argv[]) {
 	flink_dev* dev;
 	char* dev_name = DEFAULT_DEV;
+	int count = 1, i;
+	struct timespec start, end;
+	double us;
 	char c;
 	
 	/* Compute command line arguments */
-	while((c = getopt(argc, argv, "d:")) != -1) {
+	while((c = getopt(argc, argv, "d:n:")) != -1) {
 		switch(c) {
 			case 'd': // device
 				dev_name = optarg;
 				break;
+			case 'n': // number of repetitions
+				count = atoi(optarg);
+				break;
 			case '?':
-				if(optopt == 'd') fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+				if(optopt == 'd' || optopt == 'n') fprintf(stderr, "Option -%c requires an argument.\n", optopt);
 				else if(isprint(optopt)) fprintf (stderr, "Unknown option `-%c'.\n", optopt);
 				else fprintf(stderr, "Unknown option character `\\x%x'.\n", optopt);
 				return -1;
@@ -29,6 +36,22 @@ int main(int argc, char* argv[]) {
 		}
 	}
 	
+	if(count > 1) { // measure the startup time
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(i = 0; i < count; i++) {
+			dev = flink_open(dev_name);
+			if(dev == NULL) {
+				printf("Failed to open device!\n");
+				return -1;
+			}
+			flink_close(dev);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		us = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / 1e3 / count;
+		printf("Opened and closed %s %d times, %.1f us each\n", dev_name, count, us);
+		return EXIT_SUCCESS;
+	}
+	
 	printf("Opening device %s...\n", dev_name);
 	dev = flink_open(dev_name);
 	if(dev == NULL) {
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define DESIGN         "sim:pwm:4,ain:8,dio:32"
+#define PWM_ID         0
+#define AIN_ID         1
+#define DIO_ID         2
+#define NOF_RUNS       100
+#define NOF_VALUES     (NOF_RUNS * 7 + 1)
+#define LAST_PERIOD    (1 + (NOF_RUNS - 4) * 7)	// index of the last period read of channel 0
+
+// The traffic of the application, returns the nof values read
+static int run(flink_dev* dev, uint32_t* values) {
+	flink_subdev* pwm = flink_get_subdevice_by_id(dev, PWM_ID);
+	flink_subdev* ain = flink_get_subdevice_by_id(dev, AIN_ID);
+	flink_subdev* dio = flink_get_subdevice_by_id(dev, DIO_ID);
+	flink_txn* txn;
+	uint32_t value;
+	uint8_t bit;
+	int i, n = 0;
+
+	flink_pwm_get_baseclock(pwm, &values[n++]);
+	for(i = 0; i < NOF_RUNS; i++) {
+		flink_pwm_set_period(pwm, i % 4, 1000 + i);
+		flink_pwm_set_hightime(pwm, i % 4, i);
+		flink_pwm_get_period(pwm, i % 4, &values[n++]);
+		flink_pwm_get_hightime(pwm, i % 4, &values[n++]);
+		flink_dio_set_value(dio, i % 32, i & 1);
+		flink_dio_get_value(dio, i % 32, &bit);
+		values[n++] = bit;
+
+		txn = flink_txn_begin(dev);
+		flink_txn_add_read(txn, ain, HEADER_SIZE + SUBHEADER_SIZE + ANALOG_INPUT_FIRST_VALUE_OFFSET, REGISTER_WITH, &values[n++]);
+		flink_txn_add_read(txn, ain, HEADER_SIZE + SUBHEADER_SIZE + ANALOG_INPUT_FIRST_VALUE_OFFSET + REGISTER_WITH, REGISTER_WITH, &values[n++]);
+		flink_txn_add_read(txn, pwm, HEADER_SIZE + SUBHEADER_SIZE + PWM_FIRSTPWM_OFFSET, REGISTER_WITH, &values[n++]);
+		flink_txn_commit(txn, NULL);
+		flink_txn_free(txn);
+		values[n++] = flink_read(pwm, flink_subdevice_get_memsize(pwm), REGISTER_WITH, &value) < 0;
+	}
+	flink_dio_set_direction(dio, 0, 1);
+	return n;
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_subdev* pwm;
+	flink_replay_stats stats;
+	uint32_t recorded[NOF_VALUES], replayed[NOF_VALUES], value;
+	char name[128], replay[128], trace[64];
+	int n, m;
+
+	snprintf(trace, sizeof(trace), "/tmp/flink_record_replay_%d.trace", (int)getpid());
+	snprintf(name, sizeof(name), "record:%s;trace=%s", DESIGN, trace);
+	snprintf(replay, sizeof(replay), "replay:%s", trace);
+
+	// Record the traffic of the simulator
+	dev = flink_open(name);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	check(flink_get_nof_subdevices(dev) == 3, "recorded device has the subdevices");
+	memset(recorded, 0, sizeof(recorded));
+	n = run(dev, recorded);
+	check(recorded[0] != 0, "base clock read");
+	check(recorded[n - 1] == 1, "read outside of subdevice fails");
+	check(flink_record_flush(dev) == 0, "flush trace");
+	check(flink_replay_get_stats(dev, &stats) < 0, "no replay statistics while recording");
+	flink_close(dev);
+	check(flink_record_flush(NULL) < 0, "flush without device");
+
+	// Replaying the same traffic reads the same values without the simulator
+	dev = flink_open(replay);
+	if(dev == NULL) {
+		printf("Failed to open trace!\n");
+		unlink(trace);
+		return -1;
+	}
+	check(flink_get_nof_subdevices(dev) == 3, "replayed device has the subdevices");
+	pwm = flink_get_subdevice_by_id(dev, PWM_ID);
+	check(pwm != NULL && flink_subdevice_get_function(pwm) == PWM_INTERFACE_ID, "replayed subdevice function");
+	memset(replayed, 0, sizeof(replayed));
+	m = run(dev, replayed);
+	check(m == n && memcmp(recorded, replayed, n * sizeof(uint32_t)) == 0, "replayed values");
+	check(flink_replay_get_stats(dev, &stats) == 0, "read replay statistics");
+	check(stats.records > 0 && stats.matched == stats.records, "all records matched");
+	check(stats.skipped == 0 && stats.repeated == 0 && stats.missing == 0 && stats.mismatched == 0, "replay without divergence");
+	printf("%llu records replayed\n", (unsigned long long)stats.records);
+	check(flink_record_flush(dev) < 0, "no flush while replaying");
+	flink_close(dev);
+
+	// A diverging application: other data, reads repeated or not in the trace, writes not in the trace
+	dev = flink_open(replay);
+	pwm = flink_get_subdevice_by_id(dev, PWM_ID);
+	check(flink_pwm_set_period(pwm, 0, 1) == 0, "write other data");
+	check(flink_pwm_get_period(pwm, 0, &value) == 0 && value == recorded[1], "read recorded data");
+	check(flink_dio_set_direction(flink_get_subdevice_by_id(dev, DIO_ID), 0, 1) == 0, "skip to the last record");
+	check(flink_pwm_get_period(pwm, 0, &value) == 0 && value == recorded[LAST_PERIOD], "read repeated");
+	check(flink_analog_in_get_values(flink_get_subdevice_by_id(dev, AIN_ID), 7, 1, &value) < 0, "read not in the trace");
+	check(flink_pwm_set_period(pwm, 0, 2) == 0, "write not in the trace");
+	check(flink_replay_get_stats(dev, &stats) == 0, "read replay statistics");
+	check(stats.mismatched == 1, "mismatched write");
+	check(stats.repeated == 1, "repeated read");
+	check(stats.missing == 2, "missing accesses");
+	check(stats.skipped > 0, "records skipped");
+	flink_close(dev);
+
+	// Invalid names and traces
+	check(flink_open("record:" DESIGN) == NULL, "record without trace");
+	check(flink_open("replay:/nonexistent.trace") == NULL, "replay without trace");
+	unlink(trace);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
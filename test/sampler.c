@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define DESIGN         "sim:ain:4,counter:2,pwm:1"
+#define NOF_AIN        4
+#define NOF_CHANNELS   (NOF_AIN + 1)
+#define PERIOD_US      1000
+#define MAX_FRAMES     16
+
+#define FUNC_OFFSET    (HEADER_SIZE + SUBHEADER_SIZE)
+#define VALUE(ch)      (FUNC_OFFSET + REGISTER_WITH * (1 + (ch)))	// after the resolution
+#define COUNT(ch)      (FUNC_OFFSET + REGISTER_WITH * (ch))
+
+static void sleep_ms(int ms) {
+	nanosleep(&(struct timespec){ ms / 1000, (ms % 1000) * 1000000L }, NULL);
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_subdev* ain;
+	flink_subdev* counter;
+	flink_sampler* smp;
+	flink_sampler_stats stats;
+	uint64_t timestamps[MAX_FRAMES], last_timestamp = 0, nof_read = 0;
+	uint32_t values[MAX_FRAMES * NOF_CHANNELS], last_count = 0, count;
+	ssize_t n;
+	int i, k, ordered = 1, consistent = 1;
+
+	dev = flink_open(DESIGN);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	ain = flink_get_subdevice_by_id(dev, 0);
+	counter = flink_get_subdevice_by_id(dev, 1);
+	for(i = 0; i < NOF_AIN; i++) flink_sim_poke(ain, VALUE(i), 100 + i);
+
+	smp = flink_sampler_create(dev, PERIOD_US, 64);
+	check(smp != NULL, "create sampler");
+	if(smp == NULL) return -1;
+	for(i = 0; i < NOF_AIN; i++) check(flink_sampler_add_channel(smp, ain, i) == 0, "add analog input");
+	check(flink_sampler_add_channel(smp, counter, 1) == 0, "add counter");
+	check(flink_sampler_add_channel(smp, counter, 2) < 0, "channel out of range");
+	check(flink_sampler_add_channel(smp, flink_get_subdevice_by_id(dev, 2), 0) < 0, "function without values");
+	check(flink_sampler_start(smp, -1, 0) == 0, "start");
+	check(flink_sampler_add_channel(smp, ain, 0) < 0, "add after start");
+
+	// The hardware counts while the consumer drains batches
+	for(k = 1; k <= 50; k++) {
+		flink_sim_poke(counter, COUNT(1), k);
+		sleep_ms(1);
+		while((n = flink_sampler_read(smp, timestamps, values, MAX_FRAMES)) > 0) {
+			for(i = 0; i < n; i++) {
+				count = values[i * NOF_CHANNELS + NOF_AIN];
+				if(timestamps[i] <= last_timestamp || count < last_count) ordered = 0;
+				if(values[i * NOF_CHANNELS] != 100 || values[i * NOF_CHANNELS + NOF_AIN - 1] != 100 + NOF_AIN - 1) consistent = 0;
+				last_timestamp = timestamps[i];
+				last_count = count;
+			}
+			nof_read += n;
+		}
+	}
+	check(flink_sampler_stop(smp) == 0, "stop");
+	nof_read += flink_sampler_read(smp, NULL, values, MAX_FRAMES);
+	flink_sampler_get_stats(smp, &stats);
+	printf("%llu frames, %llu read, %llu dropped, %llu overruns\n", (unsigned long long)stats.frames,
+	       (unsigned long long)nof_read, (unsigned long long)stats.dropped, (unsigned long long)stats.overruns);
+	check(stats.frames >= 20, "frames sampled at the period");
+	check(nof_read == stats.frames, "every frame read once");
+	check(ordered, "frames in order");
+	check(consistent, "channel values");
+	check(last_count > 25, "counter followed");
+	check(stats.dropped == 0 && stats.errors == 0, "no frames lost");
+	flink_sampler_free(smp);
+
+	// A full ring drops the new frames
+	smp = flink_sampler_create(dev, PERIOD_US, 3);
+	flink_sampler_add_channel(smp, counter, 0);
+	flink_sampler_start(smp, -1, 0);
+	sleep_ms(20);
+	n = flink_sampler_read(smp, timestamps, values, MAX_FRAMES);
+	flink_sampler_get_stats(smp, &stats);
+	check(n == 4, "ring capacity rounded up to a power of two");
+	check(stats.dropped > 0 && stats.frames == 4, "frames dropped when full");
+	flink_sampler_free(smp);
+
+	check(flink_sampler_create(dev, 0, 8) == NULL, "zero period");
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
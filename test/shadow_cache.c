@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define DESIGN "sim:pwm:4,dio:64,stepper:2,ain:2"
+
+#define FUNC_OFFSET         (HEADER_SIZE + SUBHEADER_SIZE)
+#define PWM_PERIOD(ch)      (FUNC_OFFSET + PWM_FIRSTPWM_OFFSET + (ch) * REGISTER_WITH)
+#define DIO_VALUE(word)     (FUNC_OFFSET + REGISTER_WITH + (2 + (word)) * REGISTER_WITH)	// 64 channels use two words
+#define STEPPER_REG(r, ch)  (FUNC_OFFSET + STEPPER_MOTOR_FIRST_CONF_OFFSET + ((r) * 2 + (ch)) * REGISTER_WITH)
+
+static uint32_t peek(flink_subdev* subdev, uint32_t offset) {
+	uint32_t value = 0xdeadbeef;
+	flink_sim_peek(subdev, offset, &value);
+	return value;
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_subdev* pwm;
+	flink_subdev* dio;
+	flink_subdev* stepper;
+	flink_txn* txn;
+	uint32_t value;
+	int i;
+
+	printf("Opening device %s...\n", DESIGN);
+	dev = flink_open(DESIGN);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	pwm = flink_get_subdevice_by_id(dev, 0);
+	dio = flink_get_subdevice_by_id(dev, 1);
+	stepper = flink_get_subdevice_by_id(dev, 2);
+
+	check(flink_subdevice_set_cached(pwm, 1) == 0, "enable cache of pwm");
+	check(flink_subdevice_set_cached(dio, 1) == 0, "enable cache of dio");
+	check(flink_subdevice_set_cached(stepper, 1) == 0, "enable cache of stepper");
+	check(flink_subdevice_set_cached(flink_get_subdevice_by_id(dev, 3), 1) < 0, "analog inputs are not cached");
+
+	// Writes reach the device on flush
+	for(i = 0; i < 4; i++) flink_pwm_set_period(pwm, i, 1000 + i);
+	check(peek(pwm, PWM_PERIOD(0)) == 0, "pwm period written before flush");
+	flink_pwm_get_period(pwm, 3, &value);
+	check(value == 0, "reads access the device");
+	check(flink_flush(dev) == 0, "flush");
+	for(i = 0; i < 4; i++) check(peek(pwm, PWM_PERIOD(i)) == 1000 + (uint32_t)i, "pwm period after flush");
+
+	// Unchanged values are not written
+	flink_sim_poke(pwm, PWM_PERIOD(1), 7);
+	flink_pwm_set_period(pwm, 1, 1001);
+	flink_flush(dev);
+	check(peek(pwm, PWM_PERIOD(1)) == 7, "unchanged value written");
+
+	// Digital outputs, directions are written immediately
+	flink_dio_set_direction(dio, 40, FLINK_OUTPUT);
+	flink_dio_set_value(dio, 40, 1);
+	check(peek(dio, DIO_VALUE(1)) == 0, "dio value written before flush");
+	flink_flush(dev);
+	check(peek(dio, DIO_VALUE(1)) == (1u << 8), "dio value after flush");
+
+	// Masked port writes modify the cache and keep pending writes
+	flink_dio_set_direction(dio, 0, FLINK_OUTPUT);
+	flink_dio_set_direction(dio, 1, FLINK_OUTPUT);
+	flink_dio_set_value(dio, 0, 1);
+	value = 0x2;
+	check(flink_dio_set_port_masked(dio, 0, 1, &value, &value) == 0, "masked port write");
+	check(peek(dio, DIO_VALUE(0)) == 0, "masked port write before flush");
+	flink_flush(dev);
+	check(peek(dio, DIO_VALUE(0)) == 0x3, "pending bit kept by masked port write");
+
+	// Stepper motor: atomic registers keep their order, steps to do are always written
+	flink_stepperMotor_set_local_config_reg(stepper, 1, 0x10);
+	flink_stepperMotor_set_local_config_reg_bits_atomic(stepper, 1, 0x03);
+	check(peek(stepper, STEPPER_REG(0, 1)) == 0x13, "pending configuration flushed before atomic write");
+	flink_sim_poke(stepper, STEPPER_REG(0, 1), 0x99);
+	flink_stepperMotor_set_local_config_reg(stepper, 1, 0x13);
+	flink_flush(dev);
+	check(peek(stepper, STEPPER_REG(0, 1)) == 0x99, "cache follows atomic write");
+	flink_stepperMotor_set_steps_to_do(stepper, 0, 5);
+	flink_flush(dev);
+	flink_sim_poke(stepper, STEPPER_REG(6, 0), 0);
+	flink_stepperMotor_set_steps_to_do(stepper, 0, 5);
+	flink_flush(dev);
+	check(peek(stepper, STEPPER_REG(6, 0)) == 5, "steps to do written again");
+
+	// Transaction writes update the cache and go to the device after the pending writes
+	flink_pwm_set_period(pwm, 3, 100);
+	flink_flush(dev);
+	txn = flink_txn_begin(dev);
+	value = 5;
+	flink_txn_add_write(txn, pwm, PWM_PERIOD(3), REGISTER_WITH, &value);
+	check(flink_txn_commit(txn, NULL) == 0, "commit transaction on cached subdevice");
+	check(peek(pwm, PWM_PERIOD(3)) == 5, "transaction written");
+	flink_pwm_set_period(pwm, 3, 100);
+	flink_flush(dev);
+	check(peek(pwm, PWM_PERIOD(3)) == 100, "cache takes transaction write");
+	flink_pwm_set_period(pwm, 3, 200);
+	flink_txn_commit(txn, NULL);
+	flink_flush(dev);
+	check(peek(pwm, PWM_PERIOD(3)) == 5, "transaction written after pending write");
+	flink_txn_free(txn);
+
+	// A reset reloads the cache
+	flink_subdevice_reset(pwm);
+	flink_pwm_set_period(pwm, 2, 1002);
+	flink_flush(dev);
+	check(peek(pwm, PWM_PERIOD(2)) == 1002, "cache reloaded after reset");
+
+	// Disabling writes pending registers
+	flink_pwm_set_period(pwm, 0, 5);
+	flink_subdevice_set_cached(pwm, 0);
+	check(peek(pwm, PWM_PERIOD(0)) == 5, "pending write on disable");
+	flink_pwm_set_period(pwm, 0, 6);
+	check(peek(pwm, PWM_PERIOD(0)) == 6, "write without cache");
+
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define DESIGN "sim:info,dio:40,pwm:2,ain:100,counter:2,wd,stepper:2,irqmux:4"
+
+#define FUNC_OFFSET        (HEADER_SIZE + SUBHEADER_SIZE)
+#define DIO_VALUE_OFFSET   (FUNC_OFFSET + REGISTER_WITH + 2 * REGISTER_WITH)	// 40 channels use two words
+#define AIN_VALUE_OFFSET   (FUNC_OFFSET + REGISTER_WITH)
+#define AIN_CHANNELS       100
+
+static flink_subdev* find(flink_dev* dev, uint16_t function) {
+	int i;
+	for(i = 0; i < flink_get_nof_subdevices(dev); i++) {
+		flink_subdev* subdev = flink_get_subdevice_by_id(dev, i);
+		if(flink_subdevice_get_function(subdev) == function) return subdev;
+	}
+	return NULL;
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_subdev* subdev;
+	char desc[INFO_DESC_SIZE + 1];
+	uint32_t value, values[AIN_CHANNELS], ports[2], masks[2];
+	uint8_t bit;
+	int i, ok;
+
+	printf("Opening device %s...\n", DESIGN);
+	dev = flink_open(DESIGN);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	check(flink_get_nof_subdevices(dev) == 8, "number of subdevices");
+
+	// Info
+	subdev = find(dev, INFO_DEVICE_ID);
+	memset(desc, 0, sizeof(desc));
+	check(subdev && flink_info_get_description(subdev, desc) == 0 && strcmp(desc, "flink simulator") == 0, "info description");
+
+	// Digital I/O: only outputs are written, inputs are driven by the hardware
+	subdev = find(dev, GPIO_INTERFACE_ID);
+	check(subdev && flink_subdevice_get_nofchannels(subdev) == 40, "dio channels");
+	flink_dio_set_direction(subdev, 33, FLINK_OUTPUT);
+	flink_dio_set_value(subdev, 33, 1);
+	flink_dio_set_value(subdev, 34, 1);
+	flink_sim_peek(subdev, DIO_VALUE_OFFSET + REGISTER_WITH, &value);
+	check(value == (1u << 1), "dio output value");
+	flink_sim_poke(subdev, DIO_VALUE_OFFSET, 1u << 5);
+	bit = 0;
+	flink_dio_get_value(subdev, 5, &bit);
+	check(bit == 1, "dio input value");
+	flink_dio_get_baseclock(subdev, &value);
+	check(value != 0, "dio base clock");
+	ports[0] = 0xffff0000; ports[1] = 0xff;
+	masks[0] = 0xffffffff; masks[1] = 0x0f;
+	check(flink_dio_set_direction_mask(subdev, 0, 2, ports, masks) == 0, "dio direction of ports");
+	ports[0] = 0xaaaaaaaa; ports[1] = 0x0;
+	masks[0] = 0x00ff0000; masks[1] = 0x01;
+	check(flink_dio_set_port_masked(subdev, 0, 2, ports, masks) == 0, "dio masked port write");
+	check(flink_dio_get_port(subdev, 0, 2, ports) == 0 && ports[0] == 0x00aa0020 && ports[1] == (1u << 1), "dio port values");
+	check(flink_dio_get_port(subdev, 1, 2, ports) < 0, "dio port range");
+
+	// PWM: reset restores the defaults
+	subdev = find(dev, PWM_INTERFACE_ID);
+	flink_pwm_set_period(subdev, 1, 1000);
+	value = 0;
+	flink_pwm_get_period(subdev, 1, &value);
+	check(value == 1000, "pwm period");
+	flink_subdevice_reset(subdev);
+	flink_pwm_get_period(subdev, 1, &value);
+	check(value == 0, "pwm reset");
+
+	// Base clock is read once until refreshed
+	flink_pwm_get_baseclock(subdev, &value);
+	flink_sim_poke(subdev, FUNC_OFFSET, 1000);
+	flink_pwm_get_baseclock(subdev, &ports[0]);
+	check(ports[0] == value, "cached base clock");
+	flink_subdevice_refresh(subdev);
+	flink_pwm_get_baseclock(subdev, &value);
+	check(value == 1000, "refreshed base clock");
+
+	// Analog input: values are read only
+	subdev = find(dev, ANALOG_INPUT_INTERFACE_ID);
+	flink_sim_poke(subdev, AIN_VALUE_OFFSET + 2 * REGISTER_WITH, 1234);
+	flink_write(subdev, AIN_VALUE_OFFSET + 2 * REGISTER_WITH, REGISTER_WITH, &(uint32_t){ 1 });
+	flink_analog_in_get_value(subdev, 2, &value);
+	check(value == 1234, "analog input value");
+	for(i = 0; i < AIN_CHANNELS; i++) flink_sim_poke(subdev, AIN_VALUE_OFFSET + i * REGISTER_WITH, i);
+	ok = flink_analog_in_get_values(subdev, 10, AIN_CHANNELS - 10, values) == 0;
+	for(i = 0; ok && i < AIN_CHANNELS - 10; i++) ok = values[i] == 10 + (uint32_t)i;
+	check(ok, "analog input range spanning several transfers");
+	check(flink_analog_in_get_values(subdev, 10, AIN_CHANNELS - 9, values) < 0, "analog input range exceeding the channels");
+
+	// Counter
+	subdev = find(dev, COUNTER_INTERFACE_ID);
+	flink_sim_poke(subdev, FUNC_OFFSET + REGISTER_WITH, 42);
+	flink_counter_get_count(subdev, 1, &value);
+	check(value == 42, "counter value");
+
+	// Stepper motor: atomic set and reset of the local configuration
+	subdev = find(dev, STEPPER_MOTOR_INTERFACE_ID);
+	flink_stepperMotor_set_local_config_reg(subdev, 1, 0x10);
+	flink_stepperMotor_set_local_config_reg_bits_atomic(subdev, 1, 0x03);
+	flink_stepperMotor_reset_local_config_reg_bits_atomic(subdev, 1, 0x01);
+	flink_stepperMotor_get_local_config_reg(subdev, 1, &value);
+	check(value == 0x12, "stepper atomic configuration");
+
+	// Watchdog: expires after counter / base clock seconds
+	subdev = find(dev, WD_INTERFACE_ID);
+	flink_wd_get_baseclock(subdev, &value);
+	flink_wd_set_counter(subdev, value / 1000); // 1 ms
+	flink_wd_arm(subdev);
+	flink_wd_get_status(subdev, &bit);
+	check(bit == 0, "watchdog armed");
+	nanosleep(&(struct timespec){ 0, 5000000 }, NULL);
+	flink_wd_get_status(subdev, &bit);
+	check(bit == 1, "watchdog expired");
+
+	// Irq multiplexer
+	subdev = find(dev, IRQ_MULTIPLEXER_INTERFACE_ID);
+	flink_set_irq_multiplex(subdev, 3, 7);
+	flink_get_irq_multiplex(subdev, 3, &value);
+	check(value == 7, "irq multiplexer");
+
+	// Accesses outside of the subdevice must fail
+	check(flink_read(subdev, flink_subdevice_get_memsize(subdev), REGISTER_WITH, &value) < 0, "read outside of subdevice");
+
+	flink_close(dev);
+
+	// Unknown functions are rejected
+	check(flink_open("sim:info,foo") == NULL, "unknown function");
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
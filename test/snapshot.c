@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define DESIGN         "sim:counter:2,ppwa:2,ain:4,aout:2,pwm:2,dio:8"
+#define LATENCY_NS     20000
+#define NOF_CAPTURES   200
+#define NOF_AIN        4
+
+#define FUNC_OFFSET    (HEADER_SIZE + SUBHEADER_SIZE)
+#define REG(n)         (FUNC_OFFSET + REGISTER_WITH * (n))
+
+typedef struct {
+	uint64_t timestamp;
+	uint32_t count;
+	uint32_t ppwa[2];			// period, high time
+	uint32_t ain[NOF_AIN];
+	uint32_t aout;
+	uint32_t pwm[2];			// period, high time
+} estimator_input;			// no padding, the fields are naturally aligned
+
+typedef struct {
+	flink_dev* dev;
+	atomic_int stop;
+} writer;
+
+static double now_us(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+// Writes the same value to an analog output and a pwm period with one transaction
+static void* write_pairs(void* arg) {
+	writer* w = arg;
+	flink_txn* txn = flink_txn_begin(w->dev);
+	uint32_t value = 0;
+
+	flink_txn_add_write(txn, flink_get_subdevice_by_id(w->dev, 3), REG(1), REGISTER_WITH, &value);
+	flink_txn_add_write(txn, flink_get_subdevice_by_id(w->dev, 4), REG(1), REGISTER_WITH, &value);
+	while(!w->stop) {
+		value++;
+		flink_txn_commit(txn, NULL);
+	}
+	flink_txn_free(txn);
+	return NULL;
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_subdev *counter, *ppwa, *ain, *aout, *pwm;
+	flink_snapshot* snap;
+	estimator_input in;
+	uint64_t last = 0;
+	uint32_t value;
+	writer w;
+	pthread_t thread;
+	double start, elapsed, per_capture, per_read;
+	int i, coherent = 1;
+
+	dev = flink_open(DESIGN);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	counter = flink_get_subdevice_by_id(dev, 0);
+	ppwa = flink_get_subdevice_by_id(dev, 1);
+	ain = flink_get_subdevice_by_id(dev, 2);
+	aout = flink_get_subdevice_by_id(dev, 3);
+	pwm = flink_get_subdevice_by_id(dev, 4);
+	flink_sim_poke(counter, REG(1), 4711);
+	flink_sim_poke(ppwa, REG(1 + 1), 2000);	// period of channel 1
+	flink_sim_poke(ppwa, REG(1 + 2 + 1), 500);	// high time of channel 1
+	for(i = 0; i < NOF_AIN; i++) flink_sim_poke(ain, REG(1 + i), 10 * i);
+
+	snap = flink_snapshot_create(dev);
+	check(snap != NULL, "create snapshot");
+	if(snap == NULL) return -1;
+	check(flink_snapshot_add_channel(snap, counter, 1, offsetof(estimator_input, count)) == 0, "add counter");
+	check(flink_snapshot_add_channel(snap, ppwa, 1, offsetof(estimator_input, ppwa)) == 0, "add ppwa");
+	for(i = 0; i < NOF_AIN; i++) {
+		check(flink_snapshot_add_channel(snap, ain, i, offsetof(estimator_input, ain) + i * sizeof(uint32_t)) == 0, "add analog input");
+	}
+	check(flink_snapshot_add_channel(snap, aout, 0, offsetof(estimator_input, aout)) == 0, "add analog output");
+	check(flink_snapshot_add_channel(snap, pwm, 0, offsetof(estimator_input, pwm)) == 0, "add pwm");
+	check(flink_snapshot_add_channel(snap, ain, NOF_AIN, 0) < 0, "channel out of range");
+	check(flink_snapshot_add_channel(snap, flink_get_subdevice_by_id(dev, 5), 0, 0) < 0, "function without values");
+
+	// Values land in their fields
+	check(flink_snapshot_capture(snap, &in, sizeof(in), &in.timestamp) == 0, "capture");
+	check(in.count == 4711, "counter value");
+	check(in.ppwa[0] == 2000 && in.ppwa[1] == 500, "ppwa period and high time");
+	for(i = 0; i < NOF_AIN; i++) check(in.ain[i] == 10 * (uint32_t)i, "analog input values");
+	check(in.timestamp > 0, "timestamp");
+	check(flink_snapshot_capture(snap, &in, offsetof(estimator_input, pwm), NULL) < 0, "struct too small");
+
+	// A capture costs one access, separate reads one access per register. The fastest call is not disturbed by preemption.
+	flink_sim_set_latency(dev, LATENCY_NS);
+	per_capture = per_read = 1e9;
+	for(i = 0; i < NOF_CAPTURES; i++) {
+		start = now_us();
+		flink_snapshot_capture(snap, &in, sizeof(in), &in.timestamp);
+		elapsed = now_us() - start;
+		if(elapsed < per_capture) per_capture = elapsed;
+		start = now_us();
+		flink_counter_get_count(counter, 1, &value);
+		elapsed = now_us() - start;
+		if(elapsed < per_read) per_read = elapsed;
+	}
+	printf("capture of 10 registers %.1f us, single read %.1f us\n", per_capture, per_read);
+	check(per_capture < 2 * per_read, "capture in one access");
+	flink_sim_set_latency(dev, 0);
+
+	// Values written together are captured together
+	w.dev = dev;
+	w.stop = 0;
+	pthread_create(&thread, NULL, write_pairs, &w);
+	for(i = 0; i < 20000; i++) {
+		flink_snapshot_capture(snap, &in, sizeof(in), &in.timestamp);
+		if(in.aout != in.pwm[0]) coherent = 0;
+		if(in.timestamp < last) coherent = 0;
+		last = in.timestamp;
+	}
+	w.stop = 1;
+	pthread_join(thread, NULL);
+	check(coherent, "coherent values across subdevices");
+
+	flink_snapshot_free(snap);
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
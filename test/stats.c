@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define DESIGN         "sim:pwm:4,ain:8,dio:32"
+#define PWM_ID         0
+#define AIN_ID         1
+#define DIO_ID         2
+#define AIN_CHANNELS   8
+
+static flink_stats get(flink_dev* dev, flink_subdev* subdev) {
+	flink_stats stats;
+	memset(&stats, 0xff, sizeof(stats));
+	check(flink_get_stats(dev, subdev, &stats) == 0, "read statistics");
+	return stats;
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_subdev *pwm, *ain, *dio;
+	flink_stats stats, total;
+	flink_txn* txn;
+	uint32_t value, values[AIN_CHANNELS];
+	uint8_t bit;
+	int i;
+
+	dev = flink_open(DESIGN);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	pwm = flink_get_subdevice_by_id(dev, PWM_ID);
+	ain = flink_get_subdevice_by_id(dev, AIN_ID);
+	dio = flink_get_subdevice_by_id(dev, DIO_ID);
+
+	// Built without FLINK_STATS: the statistics can not be read
+	if(getopt(argc, argv, "x") == 'x') {
+		check(flink_get_stats(dev, NULL, &stats) < 0, "statistics compiled out");
+		check(flink_reset_stats(dev) < 0, "reset compiled out statistics");
+		flink_close(dev);
+		if(errors) return -1;
+		printf("Test successful!\n");
+		return EXIT_SUCCESS;
+	}
+
+	// Single accesses are counted on their subdevice
+	check(flink_reset_stats(dev) == 0, "reset statistics");
+	for(i = 0; i < 10; i++) flink_pwm_set_period(pwm, i % 4, i);
+	for(i = 0; i < 5; i++) flink_pwm_get_period(pwm, i % 4, &value);
+	for(i = 0; i < 3; i++) flink_dio_set_value(dio, i, 1);
+	flink_dio_get_value(dio, 0, &bit);
+	check(flink_read(pwm, flink_subdevice_get_memsize(pwm), REGISTER_WITH, &value) < 0, "read outside of subdevice");
+	stats = get(dev, pwm);
+	check(stats.writes == 10 && stats.bytes_written == 10 * REGISTER_WITH, "pwm writes");
+	check(stats.reads == 6 && stats.bytes_read == 5 * REGISTER_WITH, "pwm reads");
+	check(stats.errors == 1, "pwm errors");
+	check(stats.time_ns > 0 && stats.max_time_ns > 0 && stats.max_time_ns <= stats.time_ns, "pwm time");
+	stats = get(dev, dio);
+	check(stats.bit_writes == 3 && stats.bit_reads == 1 && stats.reads == 0 && stats.errors == 0, "dio bit accesses");
+	stats = get(dev, ain);
+	check(stats.reads == 0 && stats.writes == 0 && stats.time_ns == 0, "ain not accessed");
+
+	// A transaction is counted once on the device, its operations on their subdevices
+	txn = flink_txn_begin(dev);
+	for(i = 0; i < 3; i++) flink_txn_add_read(txn, ain, HEADER_SIZE + SUBHEADER_SIZE + ANALOG_INPUT_FIRST_VALUE_OFFSET + i * REGISTER_WITH, REGISTER_WITH, &values[i]);
+	flink_txn_add_write(txn, pwm, HEADER_SIZE + SUBHEADER_SIZE + PWM_FIRSTPWM_OFFSET, REGISTER_WITH, &value);
+	check(flink_txn_commit(txn, NULL) == 0, "commit transaction");
+	flink_txn_free(txn);
+	stats = get(dev, ain);
+	check(stats.reads == 3 && stats.bytes_read == 3 * REGISTER_WITH, "transaction reads");
+	check(get(dev, pwm).writes == 11, "transaction write");
+
+	// A range read is one access
+	check(flink_analog_in_get_values(ain, 0, AIN_CHANNELS, values) == 0, "read analog inputs");
+	check(get(dev, ain).reads == 4, "range read counted once");
+
+	// Cached writes reach the device with one transaction per flush
+	flink_subdevice_set_cached(pwm, 1);
+	for(i = 0; i < 4; i++) flink_pwm_set_period(pwm, i, 100 + i);
+	flink_flush(dev);
+	flink_subdevice_set_cached(pwm, 0);
+
+	// The device adds the ioctls, transactions and all subdevices
+	flink_get_signal_offset(dev, &value);
+	total = get(dev, NULL);
+	check(total.ioctls == 1, "ioctls");
+	check(total.syscalls == 0, "no system calls on the simulator");
+	check(total.transactions == 2, "transactions");
+	check(total.bit_writes == 3 && total.bit_reads == 1, "device bit accesses");
+	check(total.reads == get(dev, pwm).reads + get(dev, ain).reads + get(dev, dio).reads, "device reads");
+	check(total.writes == get(dev, pwm).writes + get(dev, ain).writes + get(dev, dio).writes, "device writes");
+	check(total.errors == 1, "device errors");
+	printf("%llu reads, %llu writes, %llu bit accesses, %llu transactions, %llu ns, longest call %llu ns\n",
+	       (unsigned long long)total.reads, (unsigned long long)total.writes, (unsigned long long)(total.bit_reads + total.bit_writes),
+	       (unsigned long long)total.transactions, (unsigned long long)total.time_ns, (unsigned long long)total.max_time_ns);
+
+	// Invalid arguments and reset
+	check(flink_get_stats(dev, NULL, NULL) < 0, "no statistics buffer");
+	check(flink_reset_stats(dev) == 0, "reset statistics");
+	total = get(dev, NULL);
+	check(total.reads == 0 && total.writes == 0 && total.transactions == 0 && total.time_ns == 0 && total.max_time_ns == 0, "statistics cleared");
+
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
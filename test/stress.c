@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define MAX_THREADS    8
+#define FLUSH_EVERY    16
+#define FUNC_OFFSET    (HEADER_SIZE + SUBHEADER_SIZE)
+#define DIO_DIR_OFFSET (FUNC_OFFSET + REGISTER_WITH)
+
+// One pwm per thread, a cached analog output and a digital I/O shared by all threads
+#define DESIGN "sim:pwm:4,pwm:4,pwm:4,pwm:4,pwm:4,pwm:4,pwm:4,pwm:4,aout:8,dio:8;latency=%u"
+#define AOUT_ID        MAX_THREADS
+#define DIO_ID         (MAX_THREADS + 1)
+
+typedef struct {
+	pthread_t     thread;
+	flink_dev*    dev;
+	int           id;
+	uint32_t      n;
+	int           errors;
+} worker;
+
+static double now_s(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Every thread accesses its own subdevice, no lock is shared
+static void* own_subdevice(void* arg) {
+	worker* w = arg;
+	flink_subdev* pwm = flink_get_subdevice_by_id(w->dev, w->id);
+	uint32_t k, period, clk;
+
+	for(k = 0; k < w->n; k++) {
+		if(flink_pwm_set_period(pwm, k % 4, k) != 0) w->errors++;
+		if(flink_pwm_get_period(pwm, k % 4, &period) != 0 || period != k) w->errors++;
+		if(flink_pwm_get_baseclock(pwm, &clk) != 0 || clk == 0) w->errors++;
+	}
+	return NULL;
+}
+
+// All threads write their channel of a cached subdevice and flush, and set their bit of a shared register,
+// every second thread with a masked port write
+static void* shared_subdevice(void* arg) {
+	worker* w = arg;
+	flink_subdev* aout = flink_get_subdevice_by_id(w->dev, AOUT_ID);
+	flink_subdev* dio = flink_get_subdevice_by_id(w->dev, DIO_ID);
+	uint32_t k, output, mask = 1u << w->id;
+	int ret;
+
+	for(k = 0; k < w->n; k++) {
+		if(flink_analog_out_set_value(aout, w->id, k) != 0) w->errors++;
+		if(k % FLUSH_EVERY == 0 && flink_flush(w->dev) != 0) w->errors++;
+		output = (k + 1 == w->n) ? FLINK_OUTPUT : k % 2;
+		if(w->id % 2) {
+			output = output ? mask : 0;
+			ret = flink_dio_set_direction_mask(dio, 0, 1, &output, &mask);
+		}
+		else {
+			ret = flink_dio_set_direction(dio, w->id, output);
+		}
+		if(ret != 0) w->errors++;
+	}
+	return NULL;
+}
+
+static double run(flink_dev* dev, int nof_threads, uint32_t n, void* (*body)(void*)) {
+	worker workers[MAX_THREADS];
+	double start;
+	int i;
+
+	start = now_s();
+	for(i = 0; i < nof_threads; i++) {
+		workers[i].dev = dev;
+		workers[i].id = i;
+		workers[i].n = n;
+		workers[i].errors = 0;
+		pthread_create(&workers[i].thread, NULL, body, workers + i);
+	}
+	for(i = 0; i < nof_threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		check(workers[i].errors == 0, "accesses of a thread");
+	}
+	return now_s() - start;
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	char design[128];
+	uint32_t n = 20000, latency = 2000, value;
+	int max_threads, threads, i;
+	double t, t1 = 0;
+	int c;
+
+	max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if(max_threads > MAX_THREADS) max_threads = MAX_THREADS;
+	if(max_threads < 4) max_threads = 4; // still check the correctness with several threads
+
+	/* Compute command line arguments */
+	while((c = getopt(argc, argv, "n:l:t:")) != -1) {
+		switch(c) {
+			case 'n': // accesses per thread
+				n = atoi(optarg);
+				break;
+			case 'l': // simulated access latency
+				latency = atoi(optarg);
+				break;
+			case 't': // maximum number of threads
+				max_threads = atoi(optarg);
+				if(max_threads < 1 || max_threads > MAX_THREADS) {
+					fprintf(stderr, "Number of threads must be 1 to %d.\n", MAX_THREADS);
+					return -1;
+				}
+				break;
+			case '?':
+				if(optopt == 'n' || optopt == 'l' || optopt == 't') fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+				else if(isprint(optopt)) fprintf (stderr, "Unknown option `-%c'.\n", optopt);
+				else fprintf(stderr, "Unknown option character `\\x%x'.\n", optopt);
+				return -1;
+			default:
+				abort();
+		}
+	}
+
+	snprintf(design, sizeof(design), DESIGN, latency);
+	dev = flink_open(design);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+
+	// Scaling of threads working on their own subdevices
+	printf("%u x 3 accesses per thread, %u ns latency, %ld CPUs\n", n, latency, sysconf(_SC_NPROCESSORS_ONLN));
+	for(threads = 1; threads <= max_threads; threads *= 2) {
+		t = run(dev, threads, n, own_subdevice);
+		if(threads == 1) t1 = t;
+		printf("%d threads: %8.0f accesses/s, speedup %.2f\n", threads, threads * 3.0 * n / t, t1 * threads / t);
+	}
+
+	// Threads sharing a cached subdevice and a register written bitwise
+	flink_subdevice_set_cached(flink_get_subdevice_by_id(dev, AOUT_ID), 1);
+	run(dev, max_threads, n, shared_subdevice);
+	check(flink_flush(dev) == 0, "final flush");
+	for(i = 0; i < max_threads; i++) {
+		flink_sim_peek(flink_get_subdevice_by_id(dev, AOUT_ID), FUNC_OFFSET + REGISTER_WITH * (1 + i), &value);
+		check(value == n - 1, "last value of every thread flushed");
+	}
+	flink_sim_peek(flink_get_subdevice_by_id(dev, DIO_ID), DIO_DIR_OFFSET, &value);
+	check(value == (1u << max_threads) - 1, "bit and masked port writes of all threads");
+
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
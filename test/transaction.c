@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <flinklib.h>
+
+#define LATENCY_NS     1000000	// 1 ms per access
+#define NOF_CHANNELS   8
+#define DESIGN         "sim:pwm:8,ain:8;latency=1000000"
+
+#define FUNC_OFFSET    (HEADER_SIZE + SUBHEADER_SIZE)
+
+static double now_ms(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_subdev* pwm;
+	flink_subdev* ain;
+	flink_txn* txn;
+	uint32_t periods[NOF_CHANNELS], readback[NOF_CHANNELS], values[NOF_CHANNELS];
+	ssize_t results[2 * NOF_CHANNELS + NOF_CHANNELS + 1];
+	uint32_t dummy;
+	double start, elapsed;
+	int i, n = 0, errors = 0;
+
+	printf("Opening device %s...\n", DESIGN);
+	dev = flink_open(DESIGN);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	pwm = flink_get_subdevice_by_id(dev, 0);
+	ain = flink_get_subdevice_by_id(dev, 1);
+	for(i = 0; i < NOF_CHANNELS; i++) {
+		flink_sim_poke(ain, FUNC_OFFSET + REGISTER_WITH * (1 + i), 100 + i);
+	}
+
+	// Collect the I/O of a whole cycle
+	txn = flink_txn_begin(dev);
+	for(i = 0; i < NOF_CHANNELS; i++) {
+		periods[i] = 1000 * (i + 1);
+		flink_txn_add_write(txn, pwm, FUNC_OFFSET + PWM_FIRSTPWM_OFFSET + REGISTER_WITH * i, REGISTER_WITH, &periods[i]); n++;
+		flink_txn_add_read(txn, pwm, FUNC_OFFSET + PWM_FIRSTPWM_OFFSET + REGISTER_WITH * i, REGISTER_WITH, &readback[i]); n++;
+	}
+	for(i = 0; i < NOF_CHANNELS; i++) {
+		flink_txn_add_read(txn, ain, FUNC_OFFSET + REGISTER_WITH * (1 + i), REGISTER_WITH, &values[i]); n++;
+	}
+
+	start = now_ms();
+	if(flink_txn_commit(txn, results) != 0) {
+		printf("Commit failed!\n");
+		errors++;
+	}
+	elapsed = now_ms() - start;
+	printf("%d operations committed in %.2f ms\n", n, elapsed);
+	if(elapsed > n * LATENCY_NS / 1e6 / 2) {
+		printf("Transaction was not executed as one access!\n");
+		errors++;
+	}
+	for(i = 0; i < NOF_CHANNELS; i++) {
+		if(readback[i] != periods[i] || values[i] != 100 + (uint32_t)i) {
+			printf("Channel %d: period %u, value %u\n", i, readback[i], values[i]);
+			errors++;
+		}
+	}
+	for(i = 0; i < n; i++) {
+		if(results[i] != REGISTER_WITH) {
+			printf("Operation %d returned %zd\n", i, results[i]);
+			errors++;
+		}
+	}
+
+	// A failing operation is reported without stopping the others
+	flink_txn_add_read(txn, ain, flink_subdevice_get_memsize(ain), REGISTER_WITH, &dummy);
+	if(flink_txn_commit(txn, results) == 0 || results[n] >= 0 || results[n - 1] != REGISTER_WITH) {
+		printf("Failing operation not reported!\n");
+		errors++;
+	}
+
+	// Subdevices of other devices are rejected
+	if(flink_txn_add_read(txn, NULL, 0, REGISTER_WITH, &dummy) == 0) {
+		printf("Invalid subdevice accepted!\n");
+		errors++;
+	}
+
+	flink_txn_free(txn);
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <flinklib.h>
+
+#include "check.h"
+
+#define DESIGN         "sim:wd"
+#define TIMEOUT_MS     20
+#define HEARTBEAT_MS   30
+
+static void sleep_ms(int ms) {
+	nanosleep(&(struct timespec){ ms / 1000, (ms % 1000) * 1000000L }, NULL);
+}
+
+int main(int argc, char* argv[]) {
+	flink_dev* dev;
+	flink_subdev* wd;
+	flink_wd_service* wds;
+	flink_wd_stats stats;
+	uint8_t status = 1;
+	int i;
+
+	dev = flink_open(DESIGN);
+	if(dev == NULL) {
+		printf("Failed to open device!\n");
+		return -1;
+	}
+	wd = flink_get_subdevice_by_id(dev, 0);
+
+	check(flink_wd_service_start(wd, 0, HEARTBEAT_MS, -1, 0) == NULL, "zero timeout rejected");
+	wds = flink_wd_service_start(wd, TIMEOUT_MS, HEARTBEAT_MS, -1, 0);
+	check(wds != NULL, "start service");
+	if(wds == NULL) return -1;
+
+	// Healthy loop: the watchdog is kicked and does not expire
+	for(i = 0; i < 20; i++) {
+		flink_wd_service_heartbeat(wds);
+		sleep_ms(5);
+	}
+	flink_wd_get_status(wd, &status);
+	check(status == 0, "watchdog kept alive by heartbeats");
+	flink_wd_service_get_stats(wds, &stats);
+	printf("kicks %llu, slack min %llu ns, kick interval max %llu ns\n", (unsigned long long)stats.kicks,
+	       (unsigned long long)stats.slack_min_ns, (unsigned long long)stats.kick_interval_max_ns);
+	check(stats.kicks >= 4, "kicks counted");
+	check(stats.missed_heartbeats == 0, "no missed heartbeats");
+	check(stats.slack_min_ns > 0 && stats.slack_min_ns < TIMEOUT_MS * 1000000ull, "kick slack");
+	check(stats.expired == 0, "not expired");
+
+	// Stalled loop: the kicks stop and the watchdog expires
+	sleep_ms(4 * TIMEOUT_MS + HEARTBEAT_MS);
+	flink_wd_get_status(wd, &status);
+	check(status == 1, "watchdog expired without heartbeats");
+	flink_wd_service_get_stats(wds, &stats);
+	check(stats.missed_heartbeats > 0, "missed heartbeats counted");
+	check(stats.expired == 1, "expiry seen by the service");
+
+	check(flink_wd_service_stop(wds) == 0, "stop service");
+	flink_close(dev);
+
+	if(errors) {
+		printf("%d errors!\n", errors);
+		return -1;
+	}
+	printf("Test successful!\n");
+	return EXIT_SUCCESS;
+}
@@ -16,32 +16,70 @@
 
 #define DEFAULT_DEV "/dev/flink0"
 
-flink_dev*    dev;
-uint32_t      irq_nr = 0;
-uint32_t      signal_offset;
+volatile sig_atomic_t running = 1;
 
-void customsignalhandler(int sig) {
-	printf("IRQ: %u arrived.\n", sig-signal_offset);
+void sigintHandler(int signum) {
+	running = 0;
 }
 
-void sigintHandler(int signum) {
-	int error = 0;
-    error = flink_unregister_irq(dev, irq_nr);
-	if(error != 0) {
-		printf("Could not unregister IRQ. error: %u!\n", error);
+void countHandler(flink_dev* dev, uint32_t irq, uint32_t count, void* arg) {
+	// only measured by the dispatcher
+}
+
+void printHistogram(flink_irq_stats* stats) {
+	int i, last = 0;
+	for(i = 0; i < FLINK_IRQ_HIST_BINS; i++) {
+		if(stats->histogram[i] > 0) last = i;
 	}
+	printf("Latency histogram:\n");
+	for(i = 0; i <= last; i++) {
+		printf("  < %10llu ns: %llu\n", 2ull << i, (unsigned long long)stats->histogram[i]);
+	}
+}
 
-	// Close flink device
-	flink_close(dev);
+int runStatistics(flink_dev* dev, uint32_t irq_nr, int cpu, int priority) {
+	flink_irq_dispatcher* disp;
+	flink_irq_stats stats = { 0 };
 
-    exit(0);
+	disp = flink_irq_dispatcher_start(dev, cpu, priority);
+	if(disp == NULL) {
+		printf("Could not start dispatcher!\n");
+		return EREAD;
+	}
+	if(flink_irq_dispatcher_add(disp, irq_nr, countHandler, NULL) != 0) {
+		printf("Could not register IRQ!\n");
+		flink_irq_dispatcher_stop(disp);
+		return EREAD;
+	}
+
+	printf("Press ctrl+c to exit program\n");
+	while(running) {
+		sleep(1);
+		if(flink_irq_dispatcher_get_stats(disp, irq_nr, &stats) != 0) break;
+		printf("IRQ %u: %llu interrupts, %llu coalesced, latency min/avg/p99/max %llu/%llu/%llu/%llu ns, handler max %llu ns\n",
+		       irq_nr, (unsigned long long)stats.count, (unsigned long long)stats.coalesced,
+		       (unsigned long long)stats.latency_min_ns, (unsigned long long)stats.latency_avg_ns,
+		       (unsigned long long)stats.latency_p99_ns, (unsigned long long)stats.latency_max_ns,
+		       (unsigned long long)stats.duration_max_ns);
+		fflush(stdout);
+	}
+	printHistogram(&stats);
+	flink_irq_dispatcher_stop(disp);
+	return EXIT_SUCCESS;
 }
 
 int main(int argc, char* argv[]) {
 	char*         dev_name = DEFAULT_DEV;
 	bool          verbose = false;
-	int           error = 0;
-	uint32_t      signal_nr = 0;
+	bool          statistics = false;
+	int           cpu = -1;
+	int           priority = 0;
+	int           ret;
+	flink_dev*    dev;
+	flink_irq*    irq;
+	uint32_t      irq_nr = 0;
+	uint32_t      signal_offset;
+	uint32_t      count;
 	
 	// Error message if long dashes (en dash) are used
 	int i;
@@ -54,7 +92,7 @@ int main(int argc, char* argv[]) {
 	
 	/* Compute command line arguments */
 	int c;
-	while((c = getopt(argc, argv, "d:i:v")) != -1) {
+	while((c = getopt(argc, argv, "d:i:c:p:tv")) != -1) {
 		switch(c) {
 			case 'd': // device file
 				dev_name = optarg;
@@ -62,11 +100,20 @@ int main(int argc, char* argv[]) {
 			case 'i': // irq
 				irq_nr = atoi(optarg);
 				break;
+			case 'c': // cpu of the dispatcher
+				cpu = atoi(optarg);
+				break;
+			case 'p': // SCHED_FIFO priority of the dispatcher
+				priority = atoi(optarg);
+				break;
+			case 't': // latency statistics
+				statistics = true;
+				break;
 			case 'v':
 				verbose = true;
 				break;
 			case '?':
-				if(optopt == 'd' || optopt == 'c') fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+				if(optopt == 'd' || optopt == 'i' || optopt == 'c' || optopt == 'p') fprintf(stderr, "Option -%c requires an argument.\n", optopt);
 				else if(isprint(optopt)) fprintf (stderr, "Unknown option `-%c'.\n", optopt);
 				else fprintf(stderr, "Unknown option character `\\x%x'.\n", optopt);
 				return EPARAM;
@@ -85,37 +132,40 @@ int main(int argc, char* argv[]) {
 	// catch ctrl+c. To avoid a dead irq inside the kernel
 	signal(SIGINT, sigintHandler);
 
-	// register the requested irq inside teh kernel. This will also setup the signal inside the kernel
-	signal_nr = flink_register_irq(dev, irq_nr);
-	if(signal_nr < 0) {
-		printf("Could not register IRQ. error: %d!\n", error);
-		return EREAD;
-	}
-
-	if(verbose) {
-		printf("IRQ Nr: %u \n", irq_nr);
+	if(statistics) {
+		ret = runStatistics(dev, irq_nr, cpu, priority);
+		flink_close(dev);
+		return ret;
 	}
 
-	// Read the signal offset
-	error = flink_get_signal_offset(dev,&signal_offset);
-	if(error != 0) {
-		printf("Get signal offset failed!\n");
+	// register the requested irq inside the kernel. The irq is received through a file descriptor
+	irq = flink_irq_open(dev, &irq_nr, 1);
+	if(irq == NULL) {
+		printf("Could not register IRQ!\n");
+		flink_close(dev);
 		return EREAD;
 	}
+
 	if(verbose) {
-		printf("Signal offset is: %u \n", signal_offset);
-		printf("Listening to Signal Nr. (calcuated):      %u \n", signal_offset + irq_nr);
-		printf("Listening to Signal Nr. (direct recived): %u \n", signal_nr);
+		printf("IRQ Nr: %u \n", irq_nr);
+		if(flink_get_signal_offset(dev, &signal_offset) == 0) {
+			printf("Signal offset is: %u \n", signal_offset);
+			printf("Listening to Signal Nr. (calcuated):      %u \n", signal_offset + irq_nr);
+		}
+		printf("Listening on file descriptor %d \n", flink_irq_get_fd(irq));
 	}
 
-	// Register the routine to a signal that is fired when the IRQ occurs.
-	signal(signal_nr, customsignalhandler);
-
 	printf("Press ctrl+c to exit program\n");
 	fflush(stdout);
 
-	while (1) {
-        sleep(1);
-    }	
+	while(running) {
+		if(flink_irq_wait(irq, -1, &count) > 0) {
+			printf("IRQ: %u arrived %u times.\n", irq_nr, count);
+			fflush(stdout);
+		}
+	}
+
+	flink_irq_close(irq);
+	flink_close(dev);
     return EXIT_SUCCESS;
 }
@@ -4,7 +4,6 @@
 #include <getopt.h>
 #include <ctype.h>
 #include <stdbool.h>
-#include <sched.h>
 
 #include <flinklib.h>
 
@@ -16,6 +15,42 @@
 
 #define DEFAULT_DEV "/dev/flink0"
 
+typedef struct {
+	flink_subdev* subdev;
+	uint32_t      counter;
+	bool          verbose;
+	int           error;
+} wd_cycle;
+
+// Retriggers the watchdog, arms it in the first cycle
+int retrigger(flink_cyclic* cyc, uint64_t cycle, void* arg) {
+	wd_cycle* wd = arg;
+	uint8_t status;
+
+	if(flink_wd_set_counter(wd->subdev, wd->counter) != 0) {
+		fprintf(stderr, "stderr, Writing counter failed!\n");
+		wd->error = EREAD;
+		return 1;
+	}
+	if(cycle == 0) {
+		if(flink_wd_arm(wd->subdev) != 0) {
+			fprintf(stderr, "stderr, Arming WD failed!\n");
+			wd->error = EWRITE;
+			return 1;
+		}
+		if(wd->verbose) {
+			printf("WD armed\n");
+			flink_wd_get_status(wd->subdev, &status);
+			printf("status = %d\n", status);
+		}
+	}
+	if(wd->verbose) {
+		printf(".");
+		fflush(stdout);
+	}
+	return 0;
+}
+
 int main(int argc, char* argv[]) {
 	flink_dev*    dev;
 	flink_subdev* subdev;
@@ -27,8 +62,9 @@ int main(int argc, char* argv[]) {
 	uint32_t      counter;
 	uint32_t      base_clk;
 	bool          verbose = false;
-	bool          first = true;
 	bool          rt = false;
+	flink_cyclic* cyc;
+	wd_cycle      wd;
 	int           error = 0;
 	
 	// Error message if long dashes (en dash) are used
@@ -114,15 +150,7 @@ int main(int argc, char* argv[]) {
 	counter = (uint32_t)div;
 	if(verbose) printf("Calculated counter value: %u\n", counter);
 	
-	if(rt) {
-		struct sched_param schedulingParam;
-		schedulingParam.sched_priority = 49;
-		if(sched_setscheduler(0, SCHED_RR, &schedulingParam) == -1) {
-			fprintf(stderr, "Error while setting scheduler parameters\n");
-			return -1;
-		}
-		verbose = false;
-	}
+	if(rt) verbose = false;
 	
 	// Read counter value
 	printf("WD active\n");
@@ -130,31 +158,23 @@ int main(int argc, char* argv[]) {
 	flink_wd_get_status(subdev, &status);
 	if(verbose) printf("status = %d\n", status);
 	
-	while(repeat-- > 0) {
-		error = flink_wd_set_counter(subdev, counter);
-		if(error != 0) {
-			fprintf(stderr, "stderr, Writing counter failed!\n");
-			return EREAD;
-		}
-		if(first) {
-			error = flink_wd_arm(subdev);
-			if(error != 0) {
-				fprintf(stderr, "stderr, Arming WD failed!\n");
-				return EWRITE;
-			}
-			else {
-				if(verbose) printf("WD armed\n");
-				flink_wd_get_status(subdev, &status);
-				if(verbose) printf("status = %d\n", status);
-			}
-			first = false;
-		}
-		if(verbose) {
-			printf(".");	
-			fflush(stdout);
-		}
-		usleep(800 * time); // retrigger after 80% of the given time
+	// Retrigger after 80% of the given time, at absolute release times
+	wd.subdev = subdev;
+	wd.counter = counter;
+	wd.verbose = verbose;
+	wd.error = 0;
+	cyc = flink_cyclic_create(dev, 800 * time, retrigger, &wd);
+	if(cyc == NULL) {
+		fprintf(stderr, "Creating the retrigger cycle failed!\n");
+		return EPARAM;
+	}
+	if(rt) flink_cyclic_set_realtime(cyc, -1, 49, 1);
+	if(repeat > 0 && flink_cyclic_run(cyc, repeat) != 0) {
+		fprintf(stderr, "Error while setting scheduler parameters\n");
+		return -1;
 	}
+	flink_cyclic_free(cyc);
+	if(wd.error != 0) return wd.error;
 	if(verbose) printf("\n");
 	printf("WD done\n");
 	